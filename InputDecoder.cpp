@@ -1,5 +1,5 @@
  
-/** $VER: InputDecoder.cpp (2026.01.08) P. Stuer **/
+/** $VER: InputDecoder.cpp (2026.10.19) P. Stuer **/
 
 #include "pch.h"
 
@@ -25,6 +25,7 @@ class InputDecoder : public input_stubs
 public:
     InputDecoder() noexcept :
         _File(), _FilePath(), _FileStats(),
+        _Data(), _NativeFilePath(), _SongCount(1), _SongIndex(),
         _Decoder(),
         _SynthesisRate(DefaultSynthesisRate),
         _LoopNumber(),
@@ -64,25 +65,29 @@ public:
         {
             _FileStats = _File->get_stats(abortHandler);
 
-            if ((_FileStats.m_size == 0) || (_FileStats.m_size > (t_size)(1 << 16)))
+            if ((_FileStats.m_size == 0) || (_FileStats.m_size > (t_size) MaxFileSize))
                 throw exception_io_unsupported_format("File too big");
         }
 
         {
-            pfc::array_t<t_uint8> Data;
+            _Data.resize((size_t)_FileStats.m_size);
 
-            Data.resize((size_t)_FileStats.m_size);
+            _File->read_object(&_Data[0], (t_size) _FileStats.m_size, abortHandler);
 
-            _File->read_object(&Data[0], (t_size) _FileStats.m_size, abortHandler);
+            _NativeFilePath = filesystem::g_get_native_path(filePath, abortHandler);
 
-            {
-                const auto NativeFilePath = filesystem::g_get_native_path(filePath, abortHandler);
+            // Each song of a song bundle is a subsong.
+            _SongCount = 1;
 
-                _Decoder = new pmd_decoder_t();
+            if (bundle_t::IsBundle(_Data.get_ptr(), _Data.get_size()))
+            {
+                bundle_t Bundle;
 
-                if (!_Decoder->Open(Data.get_ptr(), (size_t) _FileStats.m_size, (uint32_t) CfgSynthesisRate, NativeFilePath, CfgSamplesPath.get()))
-                    throw exception_io_data("Invalid PMD file");
+                if (Bundle.Open(_Data.get_ptr(), _Data.get_size()))
+                    _SongCount = Bundle.GetSongCount();
             }
+
+            OpenSong(0);
         }
     }
 
@@ -93,7 +98,7 @@ public:
 
     static bool g_is_our_path(const char *, const char * extension)
     {
-        for (const auto & Extention : { "m", "m2", "mz" })
+        for (const auto & Extention : { "m", "m2", "mz", "pmdb" })
         {
             if (::stricmp_utf8(extension, Extention) == 0)
                 return true;
@@ -128,7 +133,7 @@ public:
 
     unsigned get_subsong_count()
     {
-        return 1;
+        return (unsigned) _SongCount;
     }
 
     t_uint32 get_subsong(unsigned subSongIndex)
@@ -139,8 +144,10 @@ public:
     /// <summary>
     /// Retrieves information about specified subsong.
     /// </summary>
-    void get_info(t_uint32, file_info & fileInfo, abort_callback &)
+    void get_info(t_uint32 subSongIndex, file_info & fileInfo, abort_callback &)
     {
+        OpenSong(subSongIndex);
+
         double Length = _Decoder->GetLength() / 1'000.;
 
         fileInfo.set_length(Length);
@@ -210,10 +217,12 @@ public:
     /// <summary>
     /// Initializes the decoder before playing the specified subsong. Resets playback position to the beginning of specified subsong.
     /// </summary>
-    void decode_initialize(unsigned, unsigned, abort_callback & abortHandler)
+    void decode_initialize(unsigned subSongIndex, unsigned, abort_callback & abortHandler)
     {
         _File->reopen(abortHandler); // Equivalent to seek to zero, except it also works on nonseekable streams
 
+        OpenSong(subSongIndex);
+
         _Decoder->Initialize();
 
         _Decoder->SetMaxLoopNumber((uint32_t) CfgLoopCount);
@@ -308,11 +317,42 @@ public:
 
     #pragma endregion
 
+private:
+    /// <summary>
+    /// Opens the specified song of the file, unless it is already open.
+    /// </summary>
+    void OpenSong(size_t songIndex)
+    {
+        if ((_Decoder != nullptr) && (songIndex == _SongIndex))
+            return;
+
+        if (songIndex >= _SongCount)
+            throw exception_io_data("Invalid subsong index");
+
+        delete _Decoder;
+        _Decoder = new pmd_decoder_t();
+
+        if (!_Decoder->Open(_Data.get_ptr(), _Data.get_size(), songIndex, (uint32_t) CfgSynthesisRate, _NativeFilePath, CfgSamplesPath.get()))
+        {
+            delete _Decoder;
+            _Decoder = nullptr;
+
+            throw exception_io_data("Invalid PMD file");
+        }
+
+        _SongIndex = songIndex;
+    }
+
 private:
     service_ptr_t<file> _File;
     pfc::string _FilePath;
     t_filestats _FileStats;
 
+    pfc::array_t<t_uint8> _Data;
+    pfc::string8 _NativeFilePath;
+    size_t _SongCount;              // Number of songs in the file. A song bundle can hold more than one.
+    size_t _SongIndex;              // Song opened by the decoder
+
     pmd_decoder_t * _Decoder;
 
     uint32_t _SynthesisRate;
@@ -321,11 +361,13 @@ private:
     uint32_t _LoopNumber;
 
     bool _IsDynamicInfoSet;
+
+    static const size_t MaxFileSize = 64 * 1024 * 1024; // Song bundles can be larger than the 64KB limit of the song data itself.
 };
 
 #pragma warning(default: 4820) // x bytes padding added after last data member
 
 // Declare the supported file types to make it show in "open file" dialog etc.
-DECLARE_FILE_TYPE("PMD (Professional Music Driver) files", "*.m;*.m2;*.mz");
+DECLARE_FILE_TYPE("PMD (Professional Music Driver) files", "*.m;*.m2;*.mz;*.pmdb");
 
 static input_factory_t<InputDecoder> _InputDecoderFactory;
@@ -0,0 +1,211 @@
+
+/** $VER: Bundle.cpp (2026.10.19) P. Stuer - Single-file song bundle with embedded sample banks **/
+
+#include <pch.h>
+
+#include "Bundle.h"
+
+/// <summary>
+/// Returns true if the data is a song bundle.
+/// </summary>
+bool bundle_t::IsBundle(const uint8_t * data, size_t size) noexcept
+{
+    return (size >= sizeof(BUNDLEHEADER)) && (::memcmp(data, "PMDB", 4) == 0);
+}
+
+/// <summary>
+/// Gets the file name part of a path.
+/// </summary>
+static const WCHAR * GetFileName(const WCHAR * filePath) noexcept
+{
+    const WCHAR * FileName = filePath;
+
+    for (const WCHAR * p = filePath; *p != '\0'; ++p)
+    {
+        if ((*p == '\\') || (*p == '/'))
+            FileName = p + 1;
+    }
+
+    return FileName;
+}
+
+/// <summary>
+/// Opens a bundle for the specified song. The data is referenced, not copied, and must remain valid while the bundle is used.
+/// </summary>
+bool bundle_t::Open(const uint8_t * data, size_t size, size_t songIndex) noexcept
+{
+    _Data = nullptr;
+    _Size = 0;
+    _Entries = nullptr;
+    _Count = 0;
+    _SongCount = 0;
+    _SongIndex = 0;
+
+    if (!IsBundle(data, size))
+        return false;
+
+    const auto * Header = (const BUNDLEHEADER *) data;
+
+    if ((Header->Version != BundleVersion) || (Header->SongCount == 0) || (Header->SongCount > Header->Count) || (songIndex >= Header->SongCount))
+        return false;
+
+    if (sizeof(BUNDLEHEADER) + (size_t) Header->Count * sizeof(BUNDLEENTRY) > size)
+        return false;
+
+    const auto * Entries = (const BUNDLEENTRY *) (data + sizeof(BUNDLEHEADER));
+
+    for (size_t i = 0; i < Header->Count; ++i)
+    {
+        const auto & Entry = Entries[i];
+
+        if (((size_t) Entry.Offset > size) || ((size_t) Entry.Size > size - Entry.Offset))
+            return false;
+
+        if (::wmemchr(Entry.Name, '\0', _countof(Entry.Name)) == nullptr)
+            return false;
+    }
+
+    _Data = data;
+    _Size = size;
+    _Entries = Entries;
+    _Count = Header->Count;
+    _SongCount = Header->SongCount;
+    _SongIndex = songIndex;
+
+    return true;
+}
+
+/// <summary>
+/// Gets the data of the song the bundle was opened for.
+/// </summary>
+bool bundle_t::GetSong(const uint8_t *& data, size_t & size) const noexcept
+{
+    if (_Count == 0)
+        return false;
+
+    data = _Data + _Entries[_SongIndex].Offset;
+    size = _Entries[_SongIndex].Size;
+
+    return true;
+}
+
+/// <summary>
+/// Finds the data of the specified file and optionally its path in the bundle. The comparison ignores case.
+/// The file is looked for in the directory of the song first, like on disk, and then by its path relative to the root of the bundle.
+/// </summary>
+bool bundle_t::Find(const WCHAR * fileName, const uint8_t *& data, size_t & size, const WCHAR ** name) const noexcept
+{
+    if (_Count == 0)
+        return false;
+
+    const WCHAR * SongName = _Entries[_SongIndex].Name;
+    const size_t DirectoryLength = (size_t) (GetFileName(SongName) - SongName);
+
+    const BUNDLEENTRY * Match = nullptr;
+
+    for (size_t i = _SongCount; i < _Count; ++i)
+    {
+        const WCHAR * EntryName = _Entries[i].Name;
+
+        if ((::_wcsnicmp(EntryName, SongName, DirectoryLength) == 0) && (::_wcsicmp(EntryName + DirectoryLength, fileName) == 0))
+        {
+            Match = &_Entries[i];
+            break;
+        }
+
+        if ((Match == nullptr) && (::_wcsicmp(EntryName, fileName) == 0))
+            Match = &_Entries[i];
+    }
+
+    if (Match == nullptr)
+        return false;
+
+    data = _Data + Match->Offset;
+    size = Match->Size;
+
+    if (name != nullptr)
+        *name = Match->Name;
+
+    return true;
+}
+
+/// <summary>
+/// Creates a bundle from the specified songs and the files they reference. Files with the same contents are stored once.
+/// </summary>
+bool bundle_t::Create(const std::vector<bundle_file_t> & songs, const std::vector<bundle_file_t> & files, std::vector<uint8_t> & bundle)
+{
+    std::vector<const bundle_file_t *> Files;
+
+    for (const auto & Song : songs)
+        Files.push_back(&Song);
+
+    for (const auto & File : files)
+        Files.push_back(&File);
+
+    if (songs.empty() || (Files.size() > 0xFFFF))
+        return false;
+
+    for (size_t i = 0; i < Files.size(); ++i)
+    {
+        if (Files[i]->Name.empty() || (Files[i]->Name.size() >= _countof(BUNDLEENTRY::Name)))
+            return false;
+
+        for (size_t j = 0; j < i; ++j)
+        {
+            if (::_wcsicmp(Files[i]->Name.c_str(), Files[j]->Name.c_str()) == 0)
+                return false;
+        }
+    }
+
+    auto Align = [](size_t offset) { return (offset + BundleAlignment - 1) & ~((size_t) BundleAlignment - 1); };
+
+    size_t Offset = Align(sizeof(BUNDLEHEADER) + Files.size() * sizeof(BUNDLEENTRY));
+
+    std::vector<BUNDLEENTRY> Entries(Files.size());
+
+    for (size_t i = 0; i < Files.size(); ++i)
+    {
+        const auto & Data = Files[i]->Data;
+
+        Entries[i] = { };
+
+        ::wcscpy_s(Entries[i].Name, _countof(Entries[i].Name), Files[i]->Name.c_str());
+
+        Entries[i].Size = (uint32_t) Data.size();
+
+        // Share the data of an earlier entry with the same contents.
+        size_t j = 0;
+
+        while ((j < i) && ((Files[j]->Data.size() != Data.size()) || (::memcmp(Files[j]->Data.data(), Data.data(), Data.size()) != 0)))
+            ++j;
+
+        if (j < i)
+        {
+            Entries[i].Offset = Entries[j].Offset;
+
+            continue;
+        }
+
+        if (Offset + Data.size() > 0xFFFFFFFF)
+            return false;
+
+        Entries[i].Offset = (uint32_t) Offset;
+
+        Offset = Align(Offset + Data.size());
+    }
+
+    bundle.assign(Offset, 0);
+
+    BUNDLEHEADER Header = { { 'P', 'M', 'D', 'B' }, BundleVersion, (uint16_t) Files.size(), (uint16_t) songs.size(), 0, 0 };
+
+    ::memcpy(bundle.data(), &Header, sizeof(Header));
+    ::memcpy(bundle.data() + sizeof(Header), Entries.data(), Entries.size() * sizeof(BUNDLEENTRY));
+
+    for (size_t i = 0; i < Files.size(); ++i)
+    {
+        if (!Files[i]->Data.empty())
+            ::memcpy(bundle.data() + Entries[i].Offset, Files[i]->Data.data(), Files[i]->Data.size());
+    }
+
+    return true;
+}
@@ -0,0 +1,75 @@
+
+/** $VER: Bundle.h (2026.10.19) P. Stuer - Single-file song bundle with embedded sample banks **/
+
+#pragma once
+
+#include <windows.h>
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#pragma pack(push)
+#pragma pack(1)
+struct BUNDLEHEADER
+{
+    char ID[4];                     // 'PMDB'
+    uint16_t Version;
+    uint16_t Count;                 // Number of entries. The songs come first.
+    uint16_t SongCount;             // Number of songs, at least 1.
+    uint16_t Reserved1;
+    uint32_t Reserved2;
+};
+
+struct BUNDLEENTRY
+{
+    WCHAR Name[MAX_PATH];           // Path relative to the root of the bundle, separated by backslashes and zero-terminated.
+    uint32_t Offset;                // Offset of the data from the start of the bundle, aligned on BundleAlignment bytes. Entries with the same contents share their data.
+    uint32_t Size;
+};
+#pragma pack(pop)
+
+/// <summary>
+/// Describes a file to store in a bundle.
+/// </summary>
+struct bundle_file_t
+{
+    std::wstring Name;              // Path relative to the root of the bundle
+    std::vector<uint8_t> Data;
+};
+
+/// <summary>
+/// Implements a read-only view of a song bundle: one or more .M songs of a directory tree packed together with every sample bank they reference (.P86, .PPC, .PPS, .PZI, .PVI).
+/// The layout is a fixed-size header and index followed by aligned data so the bundle can be used in-place from a memory-mapped file.
+/// </summary>
+class bundle_t
+{
+public:
+    bundle_t() noexcept : _Data(), _Size(), _Entries(), _Count(), _SongCount(), _SongIndex() { }
+
+    static bool IsBundle(const uint8_t * data, size_t size) noexcept;
+
+    bool Open(const uint8_t * data, size_t size, size_t songIndex = 0) noexcept;
+
+    size_t GetSongCount() const noexcept { return _SongCount; }
+    const WCHAR * GetSongName() const noexcept { return (_Count != 0) ? _Entries[_SongIndex].Name : L""; }
+
+    bool GetSong(const uint8_t *& data, size_t & size) const noexcept;
+    bool Find(const WCHAR * fileName, const uint8_t *& data, size_t & size, const WCHAR ** name = nullptr) const noexcept;
+
+    static bool Create(const std::vector<bundle_file_t> & songs, const std::vector<bundle_file_t> & files, std::vector<uint8_t> & bundle);
+
+public:
+    static constexpr uint16_t BundleVersion = 2;
+    static constexpr uint32_t BundleAlignment = 16;
+
+private:
+    const uint8_t * _Data;
+    size_t _Size;
+
+    const BUNDLEENTRY * _Entries;
+    size_t _Count;
+    size_t _SongCount;
+    size_t _SongIndex;              // Song the bundle was opened for. Its directory is searched first for the files it references.
+};
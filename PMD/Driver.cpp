@@ -1,74 +1,31 @@
 
-/** $VER: Driver.cpp (2026.01.07) Driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
+/** $VER: Driver.cpp (2026.10.19) Driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
 
 #include <pch.h>
 
 #include "PMD.h"
 
+/// <summary>
+/// Processes one tick of all the parts of the song, in the order of the part table.
+/// </summary>
 void pmd_driver_t::DriverMain() noexcept
 {
-    int32_t i;
-
     _Driver._LoopCheck = 0x03;
 
-    // .M or .M2 (PC-98/PC-88/X68000 systems)
-    if (_Version == 0x00)
-    {
-        for (i = 0; i < (int32_t) _countof(_SSGChannels); ++i)
-        {
-            _Driver._CurrentChannel = i + 1;
-            SSGMain(&_SSGChannels[i]);
-        }
-    }
-
-    _Driver._FMSelector = 0x100;
+    _CommandCount = 0;
 
-    // Process FM channel 4, 5 and 6.
-    for (i = 0; i < 3; ++i)
+    for (size_t i = 0; i < _PartCount; ++i)
     {
-        _Driver._CurrentChannel = i + 1;
-
-        FMMain(&_FMChannels[i + 3]);
-    }
+        const part_t & Part = _Parts[i];
 
-    _Driver._FMSelector = 0x000;
+        _Driver._CurrentChannel = Part.ChannelNumber;
+        _Driver._FMSelector     = Part.FMSelector;
 
-    // Process FM channel 1, 2 and 3.
-    for (i = 0; i < 3; ++i)
-    {
-        _Driver._CurrentChannel = i + 1;
-
-        FMMain(&_FMChannels[i]);
+        (this->*Part.Main)(Part.Channel);
     }
 
-    // Process FM extension channel 1, 2 and 3.
-    for (i = 0; i < (int32_t) _countof(_FMExtensionChannels); ++i)
-    {
-        _Driver._CurrentChannel = 3;
-        FMMain(&_FMExtensionChannels[i]);
-    }
-
-    // .M or .M2 (PC-98/PC-88/X68000 systems)
-    if (_Version == 0x00)
-    {
-        RhythmMain(&_RhythmChannel);
-
-        if (_IsUsingP86)
-            P86Main(&_ADPCMChannel);
-        else
-            ADPCMMain(&_ADPCMChannel);
-    }
-
-    // .M or .M2 (PC-98/PC-88/X68000 systems)
-    if (_Version != 0xFF)
-    {
-        for (i = 0; i < (int32_t) _countof(_PPZ8Channels); ++i)
-        {
-            _Driver._CurrentChannel = i;
-
-            PPZ8Main(&_PPZ8Channels[i]);
-        }
-    }
+    _PeakCommandCount   = std::max(_PeakCommandCount, _CommandCount);
+    _TotalCommandCount += _CommandCount;
 
     if (_Driver._LoopCheck == 0x00)
         return;
@@ -112,11 +69,85 @@ void pmd_driver_t::DriverMain() noexcept
 
         if (_State._LoopCount == 255)
             _State._LoopCount = 1;
+
+        if (_Events != nullptr)
+            RecordEvent(EventSong, event_type_t::Loop, _State._LoopCount);
     }
     else
         _State._LoopCount = -1;
 }
 
+/// <summary>
+/// Counts a command against the budget of the current tick. Returns false once the budget has been used up; the song is then aborted with ERR_COMMAND_LIMIT.
+/// A part that only consists of commands would otherwise keep the driver inside a single tick forever.
+/// </summary>
+bool pmd_driver_t::CountCommand() noexcept
+{
+    if (_CommandCount < MaxCommandsPerTick)
+    {
+        _CommandCount++;
+
+        return true;
+    }
+
+    _ErrorCode = ERR_COMMAND_LIMIT;
+    _Driver._Flags |= DriverStopRequested;
+
+    return false;
+}
+
+/// <summary>
+/// Builds the table of parts processed by DriverMain(). Each entry binds a part to the main function of its sound source and the chip channel it plays on.
+/// Parts that have no data when the song starts are left out. The FM3 extension and PPZ8 parts are only included if the song can start them.
+/// </summary>
+void pmd_driver_t::BuildPartTable() noexcept
+{
+    _PartCount = 0;
+
+    auto AddPart = [this](void (pmd_driver_t::* main)(channel_t *), channel_t * channel, int32_t channelNumber, int32_t fmSelector, bool isStartedByCommand = false)
+    {
+        if ((channel->_Data != nullptr) || isStartedByCommand)
+            _Parts[_PartCount++] = { main, channel, channelNumber, fmSelector };
+    };
+
+    // .M or .M2 (PC-98/PC-88/X68000 systems)
+    if (_Version == 0x00)
+    {
+        for (int32_t i = 0; i < (int32_t) _countof(_SSGChannels); ++i)
+            AddPart(&pmd_driver_t::SSGMain, &_SSGChannels[i], i + 1, 0x000);
+    }
+
+    // FM channel 4, 5 and 6.
+    for (int32_t i = 0; i < 3; ++i)
+        AddPart(&pmd_driver_t::FMMain, &_FMChannels[i + 3], i + 1, 0x100);
+
+    // FM channel 1, 2 and 3.
+    for (int32_t i = 0; i < 3; ++i)
+        AddPart(&pmd_driver_t::FMMain, &_FMChannels[i], i + 1, 0x000);
+
+    // FM extension channel 1, 2 and 3.
+    if (_Usage.UsesFMExtension)
+    {
+        for (auto & Channel : _FMExtensionChannels)
+            AddPart(&pmd_driver_t::FMMain, &Channel, 3, 0x000, true);
+    }
+
+    // .M or .M2 (PC-98/PC-88/X68000 systems)
+    if (_Version == 0x00)
+    {
+        AddPart(&pmd_driver_t::RhythmMain, &_RhythmChannel, 3, 0x000);
+
+        AddPart(_IsUsingP86 ? &pmd_driver_t::P86Main : &pmd_driver_t::ADPCMMain, &_ADPCMChannel, 3, 0x000);
+    }
+
+    // .M or .M2 (PC-98/PC-88/X68000 systems)
+    if ((_Version != 0xFF) && _Usage.UsesPPZ8)
+    {
+        for (int32_t i = 0; i < (int32_t) _countof(_PPZ8Channels); ++i)
+            AddPart(&pmd_driver_t::PPZ8Main, &_PPZ8Channels[i], i, 0x000, true);
+    }
+}
+
 void pmd_driver_t::DriverStart() noexcept
 {
     // Set Timer B = 0 and Timer Reset (to match the length of the song every time)
@@ -134,8 +165,14 @@ void pmd_driver_t::DriverStart() noexcept
     _FramesToDo = 0;
     _Position = 0;
 
+    _CommandCount = 0;
+    _PeakCommandCount = 0;
+    _TotalCommandCount = 0;
+    _ErrorCode = ERR_SUCCESS;
+
     InitializeState();
     InitializeChannels();
+    BuildPartTable();
 
     InitializeOPNA();
     InitializeTimers();
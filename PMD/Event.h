@@ -0,0 +1,36 @@
+
+/** $VER: Event.h (2026.10.19) Musical event of a song (Based on PMDWin code by C60 / Masahiro Kajihara) **/
+
+#pragma once
+
+#include <cstdint>
+
+/// <summary>
+/// Identifies the type of a musical event.
+/// </summary>
+enum class event_type_t : uint8_t
+{
+    KeyOn,          // Value: octave (high nibble) and note (low nibble). Drum mask for the rhythm part.
+    KeyOff,         // Value: unused
+    Instrument,     // Value: instrument number
+    Volume,         // Value: volume of the channel
+    Tempo,          // Value: duration of a quarter note (in ticks)
+    Loop,           // Value: number of times the song has looped
+    RhythmShot,     // Value: instruments of the rhythm sound source started by a '\b', '\s', '\c', '\h', '\t' or '\i' command, on the channel of the part that issued it (bit 0-5: bass drum, snare drum, top cymbal, hi-hat, tom, rim shot)
+};
+
+/// <summary>
+/// Represents a musical event of a song (12 bytes).
+/// </summary>
+struct event_t
+{
+    uint32_t Tick;          // Position in ticks
+    uint32_t Time;          // Position in ms
+    uint8_t Channel;        // Channel number (see pmd_driver_t::GetChannel()) or EventSong
+    event_type_t Type;
+    uint16_t Value;
+};
+
+static_assert(sizeof(event_t) == 12);
+
+constexpr uint8_t EventSong = 0xFF; // Channel number of the events that apply to the whole song.
@@ -4,6 +4,7 @@
 #include <pch.h>
 
 #include "File.h"
+#include "Bundle.h"
 
 #include <pathcch.h>
 
@@ -38,6 +39,15 @@ bool CombinePath(WCHAR * filePath, size_t size, const WCHAR * part1, const WCHAR
 
 int64_t File::GetFileSize(const WCHAR * filePath)
 {
+    if (_Bundle != nullptr)
+    {
+        const uint8_t * Data;
+        size_t Size;
+
+        if (_Bundle->Find(filePath, Data, Size))
+            return (int64_t) Size;
+    }
+
     WIN32_FIND_DATA fd;
 
     HANDLE Handle = ::FindFirstFileW(filePath, &fd);
@@ -54,6 +64,13 @@ bool File::Open(const WCHAR * filePath)
 {
     Close();
 
+    if ((_Bundle != nullptr) && _Bundle->Find(filePath, _Data, _Size))
+    {
+        _Offset = 0;
+
+        return true;
+    }
+
     hFile = ::CreateFileW(filePath, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
 
     return (hFile != INVALID_HANDLE_VALUE);
@@ -61,6 +78,10 @@ bool File::Open(const WCHAR * filePath)
 
 void File::Close()
 {
+    _Data = nullptr;
+    _Size = 0;
+    _Offset = 0;
+
     if (hFile != INVALID_HANDLE_VALUE)
     {
         ::CloseHandle(hFile);
@@ -70,6 +91,16 @@ void File::Close()
 
 int32_t File::Read(void * dest, uint32_t size)
 {
+    if (_Data != nullptr)
+    {
+        const size_t Size = std::min((size_t) size, _Size - _Offset);
+
+        ::memcpy(dest, _Data + _Offset, Size);
+        _Offset += Size;
+
+        return (int32_t) Size;
+    }
+
     if (hFile == INVALID_HANDLE_VALUE)
         return -1;
 
@@ -80,6 +111,28 @@ int32_t File::Read(void * dest, uint32_t size)
 
 bool File::Seek(int32_t offset, SeekMethod method)
 {
+    if (_Data != nullptr)
+    {
+        int64_t Offset;
+
+        switch (method)
+        {
+            case SeekBegin:   Offset = offset; break;
+            case SeekCurrent: Offset = (int64_t) _Offset + offset; break;
+            case SeekEnd:     Offset = (int64_t) _Size + offset; break;
+
+            default:
+                return false;
+        }
+
+        if ((Offset < 0) || (Offset > (int64_t) _Size))
+            return false;
+
+        _Offset = (size_t) Offset;
+
+        return true;
+    }
+
     if (hFile == INVALID_HANDLE_VALUE)
         return false;
 
@@ -105,3 +158,144 @@ bool File::Seek(int32_t offset, SeekMethod method)
 
     return (::SetFilePointer(hFile, offset, 0, Method) != INVALID_SET_FILE_POINTER);
 }
+
+/// <summary>
+/// Gets the size of the specified file in the specified directory, or -1 if the file does not exist.
+/// </summary>
+int64_t directory_index_t::GetFileSize(const std::wstring & directoryPath, const WCHAR * fileName) noexcept
+{
+    // File names that contain a path are not indexed.
+    if ((::wcschr(fileName, '\\') != nullptr) || (::wcschr(fileName, '/') != nullptr))
+    {
+        WCHAR FilePath[MAX_PATH];
+
+        if (!CombinePath(FilePath, _countof(FilePath), directoryPath.c_str(), fileName))
+            return -1;
+
+        File f;
+
+        return f.GetFileSize(FilePath);
+    }
+
+    try
+    {
+        std::lock_guard<std::mutex> Lock(_Mutex);
+
+        const std::wstring Key = ToLower(directoryPath.c_str());
+
+        directory_t & Directory = _Directories[Key];
+
+        if (!Update(directoryPath, Directory))
+            return -1;
+
+        const auto Entry = Directory.Files.find(ToLower(fileName));
+
+        if (Entry == Directory.Files.end())
+            return -1;
+
+        if (!Validate(directoryPath, fileName, Entry->second))
+        {
+            Directory.Files.erase(Entry);
+
+            return -1;
+        }
+
+        return Entry->second.Size;
+    }
+    catch (...)
+    {
+        return -1;
+    }
+}
+
+/// <summary>
+/// Rebuilds the index of the specified directory if its last write time has changed since the index was built, or if the index was built too soon after that time to be trusted.
+/// </summary>
+bool directory_index_t::Update(const std::wstring & directoryPath, directory_t & directory)
+{
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+
+    if (!::GetFileAttributesExW(directoryPath.c_str(), GetFileExInfoStandard, &fad))
+    {
+        directory.LastWriteTime = 0;
+        directory.IsRacy = false;
+        directory.Files.clear();
+
+        return false;
+    }
+
+    const uint64_t LastWriteTime = ToUInt64(fad.ftLastWriteTime);
+
+    if ((LastWriteTime == directory.LastWriteTime) && (LastWriteTime != 0) && !directory.IsRacy)
+        return true;
+
+    // A change within the time stamp granularity of the last one leaves the time stamp of the directory unchanged. Such an index is rebuilt on the next lookup.
+    {
+        FILETIME Now;
+
+        ::GetSystemTimeAsFileTime(&Now);
+
+        directory.IsRacy = (ToUInt64(Now) < LastWriteTime + TimeStampGranularity);
+    }
+
+    directory.LastWriteTime = LastWriteTime;
+    directory.Files.clear();
+
+    WCHAR Pattern[MAX_PATH];
+
+    if (!CombinePath(Pattern, _countof(Pattern), directoryPath.c_str(), L"*"))
+        return false;
+
+    WIN32_FIND_DATAW fd;
+
+    HANDLE Handle = ::FindFirstFileExW(Pattern, FindExInfoBasic, &fd, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+
+    if (Handle == INVALID_HANDLE_VALUE)
+        return true;
+
+    do
+    {
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+
+        directory.Files[ToLower(fd.cFileName)] = { ToUInt64(fd.ftLastWriteTime), (int64_t) (((uint64_t) fd.nFileSizeHigh) << 32) + fd.nFileSizeLow };
+    }
+    while (::FindNextFileW(Handle, &fd));
+
+    ::FindClose(Handle);
+
+    return true;
+}
+
+/// <summary>
+/// Checks an indexed file against the file system and updates its last write time and size when it was replaced. Returns false if the file no longer exists.
+/// </summary>
+bool directory_index_t::Validate(const std::wstring & directoryPath, const WCHAR * fileName, file_t & file) noexcept
+{
+    WCHAR FilePath[MAX_PATH];
+
+    if (!CombinePath(FilePath, _countof(FilePath), directoryPath.c_str(), fileName))
+        return false;
+
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+
+    if (!::GetFileAttributesExW(FilePath, GetFileExInfoStandard, &fad) || (fad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        return false;
+
+    file = { ToUInt64(fad.ftLastWriteTime), (int64_t) (((uint64_t) fad.nFileSizeHigh) << 32) + fad.nFileSizeLow };
+
+    return true;
+}
+
+/// <summary>
+/// Converts the specified text to lowercase.
+/// </summary>
+std::wstring directory_index_t::ToLower(const WCHAR * text)
+{
+    std::wstring Text(text);
+
+    if (!Text.empty())
+        ::CharLowerBuffW(Text.data(), (DWORD) Text.size());
+
+    return Text;
+}
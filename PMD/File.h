@@ -1,5 +1,5 @@
 
-// $VER: File.h (2026.01.07) Based on PMDWin code by C60
+// $VER: File.h (2026.10.19) Based on PMDWin code by C60
 
 #pragma once
 
@@ -10,11 +10,18 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
 bool HasExtension(const WCHAR * filePath, size_t size, const WCHAR * fileExtension);
 bool AddBackslash(WCHAR * filePath, size_t size);
 bool RenameExtension(WCHAR * filePath, size_t size, const WCHAR * fileExtension);
 bool CombinePath(WCHAR * filePath, size_t size, const WCHAR * part1, const WCHAR * part2);
 
+class bundle_t;
+
 #pragma warning(disable: 4820)
 class File
 {
@@ -25,7 +32,7 @@ public:
     };
 
 public:
-    File() : hFile(INVALID_HANDLE_VALUE) { }
+    File() : hFile(INVALID_HANDLE_VALUE), _Bundle(), _Data(), _Size(), _Offset() { }
     virtual ~File() { Close(); }
 
     int64_t GetFileSize(const WCHAR * filePath);
@@ -36,6 +43,53 @@ public:
     int32_t Read(void * data, uint32_t size);
     bool Seek(int32_t offset, SeekMethod method);
 
+    /// <summary>
+    /// Mounts a song bundle. Files found in the bundle are read from memory instead of from the file system. Specify nullptr to unmount.
+    /// </summary>
+    void Mount(const bundle_t * bundle) noexcept { Close(); _Bundle = bundle; }
+    const bundle_t * GetBundle() const noexcept { return _Bundle; }
+
 private:
     HANDLE hFile;
+
+    const bundle_t * _Bundle;
+    const uint8_t * _Data;          // Data of the file opened from the bundle
+    size_t _Size;
+    size_t _Offset;
+};
+
+/// <summary>
+/// Implements a process-wide, case-insensitive index of the files in a directory. An index is built on first use and rebuilt when the last write time of the directory changes.
+/// A file found in the index is checked against its last write time and size before it is reported, so a file that was replaced without changing the directory is not served stale.
+/// </summary>
+class directory_index_t
+{
+public:
+    static int64_t GetFileSize(const std::wstring & directoryPath, const WCHAR * fileName) noexcept;
+
+private:
+    struct file_t
+    {
+        uint64_t LastWriteTime;
+        int64_t Size;
+    };
+
+    struct directory_t
+    {
+        uint64_t LastWriteTime;
+        bool IsRacy;            // True if the index was built so soon after the last write time that a later change could have the same time stamp
+        std::unordered_map<std::wstring, file_t> Files; // Lowercase file name to last write time and size
+    };
+
+    static bool Update(const std::wstring & directoryPath, directory_t & directory);
+    static bool Validate(const std::wstring & directoryPath, const WCHAR * fileName, file_t & file) noexcept;
+    static std::wstring ToLower(const WCHAR * text);
+
+    static uint64_t ToUInt64(const FILETIME & ft) noexcept { return (((uint64_t) ft.dwHighDateTime) << 32) | ft.dwLowDateTime; }
+
+    static const uint64_t TimeStampGranularity = 2 * 10'000'000; // 2 s in 100 ns units, the coarsest granularity of the supported file systems (FAT)
+
+private:
+    static inline std::mutex _Mutex;
+    static inline std::map<std::wstring, directory_t> _Directories;
 };
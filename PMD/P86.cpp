@@ -1,16 +1,17 @@
 
-/** $VER: P86.cpp (2026.01.07) PMD's internal 86PCM driver for the PC-98's 86 soundboard / Programmed by M.Kajihara 96/01/16 / Windows Converted by C60 **/
+/** $VER: P86.cpp (2026.10.19) PMD's internal 86PCM driver for the PC-98's 86 soundboard / Programmed by M.Kajihara 96/01/16 / Windows Converted by C60 **/
 
 #include <pch.h>
 
 #include "P86.h"
+#include "RegisterLog.h"
 
 static const int32_t SampleRates[] =
 {
     4135, 5513, 8270, 11025, 16540, 22050, 33080, 44100
 };
 
-p86_t::p86_t(File * file) : _File(file), _Data()
+p86_t::p86_t(File * file) : _File(file), _RegisterLog(), _Data(), _VolumeTable()
 {
     InitializeInternal();
 }
@@ -189,6 +190,9 @@ void p86_t::InitializeVolume(int value)
 /// </summary>
 bool p86_t::SetVolume(int value)
 {
+    if ((_RegisterLog != nullptr) && _RegisterLog->Add(pcm_call_t::P86SetVolume, value))
+        return true;
+
     _Volume = value;
 
     return true;
@@ -199,6 +203,9 @@ bool p86_t::SetVolume(int value)
 /// </summary>
 bool p86_t::SelectSample(int index)
 {
+    if ((_RegisterLog != nullptr) && _RegisterLog->Add(pcm_call_t::P86SelectSample, index))
+        return true;
+
     _SampleAddr = (_Data != nullptr) ? _Data + _Header.P86Item[index].Offset : nullptr;
     _SampleSize = _Header.P86Item[index].Size;
 
@@ -213,6 +220,9 @@ bool p86_t::SelectSample(int index)
 /// </summary>
 bool p86_t::SetPan(int flags, int value)
 {
+    if ((_RegisterLog != nullptr) && _RegisterLog->Add(pcm_call_t::P86SetPan, flags, value))
+        return true;
+
     _PanFlags = flags;
     _PanValue = value;
 
@@ -224,6 +234,9 @@ bool p86_t::SetPan(int flags, int value)
 /// </summary>
 bool p86_t::SetPitch(int sampleRateIndex, uint32_t pitch)
 {
+    if ((_RegisterLog != nullptr) && _RegisterLog->Add(pcm_call_t::P86SetPitch, sampleRateIndex, (int32_t) pitch))
+        return true;
+
     if ((sampleRateIndex < 0) || (sampleRateIndex >= (int32_t) _countof(SampleRates)) || (pitch > 0x1FFFFF))
         return false;
 
@@ -243,6 +256,9 @@ bool p86_t::SetPitch(int sampleRateIndex, uint32_t pitch)
 /// </summary>
 bool p86_t::SetLoop(int loopBegin, int loopEnd, int releaseBegin, bool isADPCM)
 {
+    if ((_RegisterLog != nullptr) && _RegisterLog->Add(pcm_call_t::P86SetLoop, loopBegin, loopEnd, releaseBegin, isADPCM))
+        return true;
+
     _IsLooping = true;
     _IsReleaseRequested = false;
 
@@ -364,6 +380,9 @@ bool p86_t::SetLoop(int loopBegin, int loopEnd, int releaseBegin, bool isADPCM)
 /// </summary>
 void p86_t::Start()
 {
+    if ((_RegisterLog != nullptr) && _RegisterLog->Add(pcm_call_t::P86Start))
+        return;
+
     _CurrAddr = _SampleAddr;
     _CurrOffs = 0;
     _SizeToDo = _SampleSize;
@@ -377,6 +396,9 @@ void p86_t::Start()
 /// </summary>
 bool p86_t::Stop(void)
 {
+    if ((_RegisterLog != nullptr) && _RegisterLog->Add(pcm_call_t::P86Stop))
+        return true;
+
     _IsPlaying = false;
 
     return true;
@@ -387,6 +409,9 @@ bool p86_t::Stop(void)
 /// </summary>
 bool p86_t::Keyoff(void)
 {
+    if ((_RegisterLog != nullptr) && _RegisterLog->Add(pcm_call_t::P86Keyoff))
+        return true;
+
     if (_IsReleaseRequested)
     {
         _CurrAddr = _ReleaseAddr;
@@ -416,279 +441,51 @@ void p86_t::Mix(frame32_t * frames, size_t frameCount) noexcept
     }
 
     if (_UseInterpolation)
-    {
-        switch (_PanFlags)
-        {
-            case 0: MixCenterInterpolated((sample_t *) frames, frameCount); break;
-            case 1: MixLeftInterpolated  ((sample_t *) frames, frameCount); break;
-            case 2: MixRightInterpolated ((sample_t *) frames, frameCount); break;
-            case 3: MixCenterInterpolated((sample_t *) frames, frameCount); break;
-
-            case 4: MixCenterInterpolatedPhaseReversed((sample_t *) frames, frameCount); break;
-            case 5: MixLeftInterpolatedPhaseReversed  ((sample_t *) frames, frameCount); break;
-            case 6: MixRightInterpolatedPhaseReversed ((sample_t *) frames, frameCount); break;
-            case 7: MixCenterInterpolatedPhaseReversed((sample_t *) frames, frameCount); break;
-        }
-    }
+        MixVoice<true>(frames, frameCount);
     else
-    {
-        switch (_PanFlags)
-        {
-            case 0: MixCenter((sample_t *) frames, frameCount); break;
-            case 1: MixLeft  ((sample_t *) frames, frameCount); break;
-            case 2: MixRight ((sample_t *) frames, frameCount); break;
-            case 3: MixCenter((sample_t *) frames, frameCount); break;
-
-            case 4: MixCenterPhaseReversed((sample_t *) frames, frameCount); break;
-            case 5: MixLeftPhaseReversed  ((sample_t *) frames, frameCount); break;
-            case 6: MixRightPhaseReversed ((sample_t *) frames, frameCount); break;
-            case 7: MixCenterPhaseReversed((sample_t *) frames, frameCount); break;
-        }
-    }
-}
-
-/// <summary>
-/// Center with linear interpolation
-/// </summary>
-void p86_t::MixCenterInterpolated(sample_t * frames, size_t frameCount)
-{
-    for (size_t i = 0; i < frameCount; ++i)
-    {
-        const sample_t Sample = (_VolumeTable[_Volume][_CurrAddr[0]] * (0x1000 - _CurrOffs) + _VolumeTable[_Volume][_CurrAddr[1]] * _CurrOffs) >> 12;
-
-        *frames++ += Sample;
-        *frames++ += Sample;
-
-        if (MoveSamplePointer())
-        {
-            _IsPlaying = false;
-            return;
-        }
-    }
-}
-
-/// <summary>
-/// Center with linear interpolation (Reverse phase)
-/// </summary>
-void p86_t::MixCenterInterpolatedPhaseReversed(sample_t * frames, size_t frameCount)
-{
-    for (size_t i = 0; i < frameCount; ++i)
-    {
-        const sample_t Sample = (_VolumeTable[_Volume][_CurrAddr[0]] * (0x1000 - _CurrOffs) + _VolumeTable[_Volume][_CurrAddr[1]] * _CurrOffs) >> 12;
-
-        *frames++ += Sample;
-        *frames++ -= Sample;
-
-        if (MoveSamplePointer())
-        {
-            _IsPlaying = false;
-            return;
-        }
-    }
+        MixVoice<false>(frames, frameCount);
 }
 
 /// <summary>
-/// Left with linear interpolation
+/// Selects the pan law and phase of the voice mixer.
 /// </summary>
-void p86_t::MixLeftInterpolated(sample_t * frames, size_t frameCount)
+template<bool Interpolate>
+void p86_t::MixVoice(frame32_t * frames, size_t frameCount) noexcept
 {
-    for (size_t i = 0; i < frameCount; ++i)
-    {
-        const sample_t Sample = (_VolumeTable[_Volume][_CurrAddr[0]] * (0x1000 - _CurrOffs) + _VolumeTable[_Volume][_CurrAddr[1]] * _CurrOffs) >> 12;
+    using namespace voice_mixer;
 
-        *frames++ += Sample;
-        *frames++ += Sample * _PanValue / (256 / 2);
-
-        if (MoveSamplePointer())
-        {
-            _IsPlaying = false;
-            return;
-        }
-    }
-}
-
-/// <summary>
-/// Left with linear interpolation (Reverse phase)
-/// </summary>
-void p86_t::MixLeftInterpolatedPhaseReversed(sample_t * frames, size_t frameCount)
-{
-    for (size_t i = 0; i < frameCount; ++i)
+    switch (_PanFlags)
     {
-        const sample_t Sample = (_VolumeTable[_Volume][_CurrAddr[0]] * (0x1000 - _CurrOffs) + _VolumeTable[_Volume][_CurrAddr[1]] * _CurrOffs) >> 12;
-
-        *frames++ += Sample;
-        *frames++ -= Sample * _PanValue / (256 / 2);
-
-        if (MoveSamplePointer())
-        {
-            _IsPlaying = false;
-            return;
-        }
+        case 0: MixVoice<Interpolate, false>(frames, frameCount, pan_center_t()); break;
+        case 1: MixVoice<Interpolate, false>(frames, frameCount, pan_left_t { _PanValue }); break;
+        case 2: MixVoice<Interpolate, false>(frames, frameCount, pan_right_t { _PanValue }); break;
+        case 3: MixVoice<Interpolate, false>(frames, frameCount, pan_center_t()); break;
+
+        case 4: MixVoice<Interpolate, true> (frames, frameCount, pan_center_t()); break;
+        case 5: MixVoice<Interpolate, true> (frames, frameCount, pan_left_t { _PanValue }); break;
+        case 6: MixVoice<Interpolate, true> (frames, frameCount, pan_right_t { _PanValue }); break;
+        case 7: MixVoice<Interpolate, true> (frames, frameCount, pan_center_t()); break;
     }
 }
 
 /// <summary>
-/// Right with linear interpolation
+/// Mixes the voice with the specified pan law, optionally with linear interpolation and/or the phase of the right channel reversed.
 /// </summary>
-void p86_t::MixRightInterpolated(sample_t * frames, size_t frameCount)
+template<bool Interpolate, bool PhaseReversed, typename Pan>
+void p86_t::MixVoice(frame32_t * frames, size_t frameCount, const Pan & pan) noexcept
 {
-    for (size_t i = 0; i < frameCount; ++i)
-    {
-        const sample_t SampleR = (_VolumeTable[_Volume][_CurrAddr[0]] * (0x1000 - _CurrOffs) + _VolumeTable[_Volume][_CurrAddr[1]] * _CurrOffs) >> 12;
-        const sample_t SampleL = SampleR * _PanValue / (256 / 2);
-
-        *frames++ += SampleL;
-        *frames++ += SampleR;
-
-        if (MoveSamplePointer())
-        {
-            _IsPlaying = false;
-            return;
-        }
-    }
-}
+    const sample_t * Volume = _VolumeTable[_Volume];
 
-/// <summary>
-/// Right with linear interpolation (Reverse phase)
-/// </summary>
-void p86_t::MixRightInterpolatedPhaseReversed(sample_t * frames, size_t frameCount)
-{
-    for (size_t i = 0; i < frameCount; ++i)
+    auto Fetch = [this, Volume]() noexcept -> sample_t
     {
-        const sample_t SampleR = (_VolumeTable[_Volume][_CurrAddr[0]] * (0x1000 - _CurrOffs) + _VolumeTable[_Volume][_CurrAddr[1]] * _CurrOffs) >> 12;
-        const sample_t SampleL = SampleR * _PanValue / (256 / 2);
-
-        *frames++ += SampleL;
-        *frames++ -= SampleR;
-
-        if (MoveSamplePointer())
-        {
-            _IsPlaying = false;
-            return;
-        }
-    }
-}
-
-/// <summary>
-/// Center, no interpolation
-/// </summary>
-void p86_t::MixCenter(sample_t * frames, size_t frameCount)
-{
-    for (size_t i = 0; i < frameCount; ++i)
-    {
-        const sample_t Sample = _VolumeTable[_Volume][*_CurrAddr];
-
-        *frames++ += Sample;
-        *frames++ += Sample;
-
-        if (MoveSamplePointer())
-        {
-            _IsPlaying = false;
-            return;
-        }
-    }
-}
-
-/// <summary>
-/// Center, no interpolation (Reverse phase)
-/// </summary>
-void p86_t::MixCenterPhaseReversed(sample_t * frames, size_t frameCount)
-{
-    for (size_t i = 0; i < frameCount; ++i)
-    {
-        const sample_t Sample = _VolumeTable[_Volume][*_CurrAddr];
-
-        *frames++ += Sample;
-        *frames++ -= Sample;
-
-        if (MoveSamplePointer())
-        {
-            _IsPlaying = false;
-            return;
-        }
-    }
-}
-
-/// <summary>
-/// Left, no interpolation
-/// </summary>
-void p86_t::MixLeft(sample_t * frames, size_t frameCount)
-{
-    for (size_t i = 0; i < frameCount; ++i)
-    {
-        const sample_t Sample = _VolumeTable[_Volume][*_CurrAddr];
-
-        *frames++ += Sample;
-        *frames++ += Sample * _PanValue / (256 / 2);
-
-        if (MoveSamplePointer())
-        {
-            _IsPlaying = false;
-            return;
-        }
-    }
-}
-
-/// <summary>
-/// Left, no interpolation (Reverse phase)
-/// </summary>
-void p86_t::MixLeftPhaseReversed(sample_t * frames, size_t frameCount)
-{
-    for (size_t i = 0; i < frameCount; ++i)
-    {
-        const sample_t Sample = _VolumeTable[_Volume][*_CurrAddr];
-
-        *frames++ += Sample;
-        *frames++ -= Sample * _PanValue / (256 / 2);
-
-        if (MoveSamplePointer())
-        {
-            _IsPlaying = false;
-            return;
-        }
-    }
-}
-
-/// <summary>
-/// Right, no interpolation
-/// </summary>
-void p86_t::MixRight(sample_t * frames, size_t frameCount)
-{
-    for (size_t i = 0; i < frameCount; ++i)
-    {
-        const sample_t SampleR = _VolumeTable[_Volume][*_CurrAddr];
-        const sample_t SampleL = SampleR * _PanValue / (256 / 2);
-
-        *frames++ += SampleL;
-        *frames++ += SampleR;
-
-        if (MoveSamplePointer())
-        {
-            _IsPlaying = false;
-            return;
-        }
-    }
-}
-
-/// <summary>
-/// Right, no interpolation (Reverse phase)
-/// </summary>
-void p86_t::MixRightPhaseReversed(sample_t * frames, size_t frameCount)
-{
-    for (size_t i = 0; i < frameCount; ++i)
-    {
-        const sample_t SampleR = _VolumeTable[_Volume][*_CurrAddr];
-        const sample_t SampleL = SampleR * _PanValue / (256 / 2);
-
-        *frames++ += SampleL;
-        *frames++ -= SampleR;
+        if constexpr (Interpolate)
+            return (Volume[_CurrAddr[0]] * (0x1000 - _CurrOffs) + Volume[_CurrAddr[1]] * _CurrOffs) >> 12;
+        else
+            return Volume[*_CurrAddr];
+    };
 
-        if (MoveSamplePointer())
-        {
-            _IsPlaying = false;
-            return;
-        }
-    }
+    if (!voice_mixer::Mix<PhaseReversed>((sample_t *) frames, frameCount, pan, Fetch, [this]() noexcept { return !MoveSamplePointer(); }))
+        _IsPlaying = false;
 }
 
 /// <summary>
@@ -722,7 +519,7 @@ bool p86_t::MoveSamplePointer() noexcept
 }
 
 /// <summary>
-/// 
+/// Selects the volume lookup table. The tables are shared by all instances.
 /// </summary>
 void p86_t::CreateVolumeTable(int volume)
 {
@@ -733,13 +530,18 @@ void p86_t::CreateVolumeTable(int volume)
 
     _VolumeBase = NewVolumeBase;
 
-    for (int32_t i = 0; i < 16; ++i)
+    const auto & Table = shared_table_t<volume_table_t, p86_t>::Get(_VolumeBase, [NewVolumeBase](volume_table_t & table)
     {
-        const double Volume = (double) _VolumeBase * i / 256.; // std::pow(2.0, (i + 15) / 2.0) * _VolumeBase / 0x18000;
+        for (int32_t i = 0; i < 16; ++i)
+        {
+            const double Volume = (double) NewVolumeBase * i / 256.; // std::pow(2.0, (i + 15) / 2.0) * _VolumeBase / 0x18000;
 
-        for (int32_t j = 0; j < 256; ++j)
-            _VolumeTable[i][j] = (sample_t) (Volume * (int8_t) j);
-    }
+            for (int32_t j = 0; j < 256; ++j)
+                table.Rows[i][j] = (sample_t) (Volume * (int8_t) j);
+        }
+    });
+
+    _VolumeTable = Table.Rows;
 }
 
 /// <summary>
@@ -1,9 +1,10 @@
 
-/** $VER: P86.h (2026.01.07) PMD's internal 86PCM driver for the PC-98's 86 soundboard / Programmed by M.Kajihara 96/01/16 / Windows Converted by C60 **/
+/** $VER: P86.h (2026.10.19) PMD's internal 86PCM driver for the PC-98's 86 soundboard / Programmed by M.Kajihara 96/01/16 / Windows Converted by C60 **/
 
 #pragma once
 
 #include "OPNA.h"
+#include "SharedTable.h"
 
 #define P86_VERSION     "1.1c"
 #define vers            0x11
@@ -52,6 +53,8 @@ struct P86HEADER
     } P86Item[MAX_P86];
 };
 
+class register_log_t;
+
 #pragma warning(disable: 4820) // 'x' bytes padding added after data member 'y'
 
 /// <summary>
@@ -79,6 +82,8 @@ public:
     bool SelectSample(int number);
     bool SetLoop(int loopStart, int loopEnd, int releaseStart, bool isADPCM);
 
+    void SetRegisterLog(register_log_t * log) noexcept { _RegisterLog = log; } // Sets the log that receives the calls that affect playback. Specify nullptr to stop logging. See register_log_t::SetLogOnly().
+
     void Mix(frame32_t * frames, size_t frameCount) noexcept;
 
 public:
@@ -91,23 +96,22 @@ private:
     void CreateVolumeTable(int volume);
     void ReadHeader(File * file, P86FILEHEADER & p86header);
 
-    void MixCenter(sample_t * sampleData, size_t sampleCount);
-    void MixCenterPhaseReversed(sample_t * sampleData, size_t sampleCount);
-    void MixLeft(sample_t * sampleData, size_t sampleCount);
-    void MixLeftPhaseReversed(sample_t * sampleData, size_t sampleCount);
-    void MixRight(sample_t * sampleData, size_t sampleCount);
-    void MixRightPhaseReversed(sample_t * sampleData, size_t sampleCount);
-    void MixCenterInterpolated(sample_t * sampleData, size_t sampleCount);
-    void MixCenterInterpolatedPhaseReversed(sample_t * sampleData, size_t sampleCount);
-    void MixLeftInterpolated(sample_t * sampleData, size_t sampleCount);
-    void MixLeftInterpolatedPhaseReversed(sample_t * sampleData, size_t sampleCount);
-    void MixRightInterpolated(sample_t * sampleData, size_t sampleCount);
-    void MixRightInterpolatedPhaseReversed(sample_t * sampleData, size_t sampleCount);
+    struct volume_table_t
+    {
+        sample_t Rows[16][256];
+    };
+
+    template<bool Interpolate>
+    void MixVoice(frame32_t * frames, size_t frameCount) noexcept;
+
+    template<bool Interpolate, bool PhaseReversed, typename Pan>
+    void MixVoice(frame32_t * frames, size_t frameCount, const Pan & pan) noexcept;
 
     bool MoveSamplePointer() noexcept;
 
 private:
     File * _File;
+    register_log_t * _RegisterLog;
     uint8_t * _Data;
 
     int32_t _SampleRate;
@@ -140,7 +144,7 @@ private:
     int32_t _PanValue;                  // Volume value on the side where the volume is lowered.
 
     int32_t _VolumeBase;
-    sample_t _VolumeTable[16][256];
+    const sample_t (* _VolumeTable)[256];
 
     int32_t _SampleRateOriginal;        // Original sample rate
 };
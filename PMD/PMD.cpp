@@ -1,5 +1,5 @@
 
-/** $VER: PMD.cpp (2026.01.07) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
+/** $VER: PMD.cpp (2026.10.19) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
 
 #include <pch.h>
 
@@ -58,7 +58,6 @@ bool pmd_driver_t::Initialize(const WCHAR * directoryPathDrums) noexcept
     Reset();
 
     _PCMSampleRate = FREQUENCY_44_1K;
-    _PPZSampleRate = FREQUENCY_44_1K;
 
     _TimerBTempo = 0x100;
 
@@ -149,11 +148,67 @@ bool pmd_driver_t::IsPMD(const uint8_t * data, size_t size) noexcept
 }
 
 /// <summary>
-/// Loads the data into the driver.
+/// Loads the data into the driver. The data can be a song or a song bundle. The song index selects the song of a bundle, whose sample banks are loaded from the bundle.
 /// </summary>
-int32_t pmd_driver_t::Load(const uint8_t * data, size_t size) noexcept
+int32_t pmd_driver_t::Load(const uint8_t * data, size_t size, size_t songIndex) noexcept
 {
-    if (!IsPMD(data, size))
+    if (!bundle_t::IsBundle(data, size))
+        return LoadInternal(data, size);
+
+    bundle_t Bundle;
+
+    const uint8_t * SongData = nullptr;
+    size_t SongSize = 0;
+
+    if (!Bundle.Open(data, size, songIndex) || !Bundle.GetSong(SongData, SongSize))
+        return ERR_UNKNOWN_FORMAT;
+
+    _File->Mount(&Bundle);
+
+    int32_t Result = LoadInternal(SongData, SongSize);
+
+    _File->Mount(nullptr);
+
+    return Result;
+}
+
+/// <summary>
+/// Returns true if the offset table of the song only points inside the song data: the 11 parts, the rhythm pattern table and, if present, the FM instrument definitions.
+/// The command streams are checked by AnalyzeSourceUsage() once the sample banks that determine how the ADPCM part is decoded have been loaded.
+/// </summary>
+bool pmd_driver_t::HasValidPartOffsets(const uint8_t * data, size_t size) noexcept
+{
+    // Only the standard layout, where the first part follows the offset table, is checked.
+    if (data[2] != 0x00)
+        return true;
+
+    const size_t MaxParts = MaxFMChannels + MaxSSGChannels + 2; // FM, SSG, ADPCM and rhythm
+    const size_t OffsetCount = (size_t) data[1] / sizeof(uint16_t); // The parts, the rhythm pattern table and optionally the FM instrument definitions
+
+    if (size < 1 + OffsetCount * sizeof(uint16_t))
+        return false;
+
+    const uint8_t * Data = data + 1;
+    const size_t Size = size - 1;
+
+    for (size_t i = 0; i < OffsetCount; ++i)
+    {
+        const size_t Offset = (size_t) (Data[i * 2] | (Data[i * 2 + 1] << 8));
+
+        // A part holds at least its end marker. The tables may be empty and end with the song.
+        if ((i < MaxParts) ? (Offset >= Size) : (Offset > Size))
+            return false;
+    }
+
+    return true;
+}
+
+/// <summary>
+/// Loads the song data into the driver.
+/// </summary>
+int32_t pmd_driver_t::LoadInternal(const uint8_t * data, size_t size) noexcept
+{
+    if (!IsPMD(data, size) || !HasValidPartOffsets(data, size))
         return ERR_UNKNOWN_FORMAT;
 
     Stop();
@@ -161,8 +216,8 @@ int32_t pmd_driver_t::Load(const uint8_t * data, size_t size) noexcept
     ::memcpy(_MData, data, size);
     ::memset(_MData + size, 0, sizeof(_MData) - size);
 
-    if (_SearchPath.size() == 0)
-        return ERR_SUCCESS;
+    if ((_SearchPath.size() == 0) && (_File->GetBundle() == nullptr))
+        return AnalyzeSourceUsage(size) ? ERR_SUCCESS : ERR_UNKNOWN_FORMAT;
 
     int32_t Result = ERR_SUCCESS;
 
@@ -248,6 +303,8 @@ int32_t pmd_driver_t::Load(const uint8_t * data, size_t size) noexcept
     {
         _PPZFilePath[0].clear();
         _PPZFilePath[1].clear();
+        _PPZFileName[0].clear();
+        _PPZFileName[1].clear();
 
         GetText(_MData, size, -2, FileName, _countof(FileName));
 
@@ -259,12 +316,10 @@ int32_t pmd_driver_t::Load(const uint8_t * data, size_t size) noexcept
 
             for (size_t i = 0; (*p != '\0') && (i < _countof(_PPZFilePath)); ++i)
             {
-                {
-                    WCHAR * q = ::wcschr(p, ',');
+                WCHAR * q = ::wcschr(p, ',');
 
-                    if (q != nullptr)
-                        *q = '\0';
-                }
+                if (q != nullptr)
+                    *q = '\0';
 
                 _PPZFileName[i] = p;
 
@@ -292,12 +347,17 @@ int32_t pmd_driver_t::Load(const uint8_t * data, size_t size) noexcept
                         _PPZFilePath[i] = FilePath;
                 }
 
-                p += ::wcslen(p) + 1;
+                // A second bank follows a comma.
+                if (q == nullptr)
+                    break;
+
+                p = q + 1;
             }
         }
     }
 
-    return ERR_SUCCESS;
+    // The P86 file determines how the ADPCM part is decoded.
+    return AnalyzeSourceUsage(size) ? ERR_SUCCESS : ERR_UNKNOWN_FORMAT;
 }
 
 /// <summary>
@@ -340,6 +400,15 @@ void pmd_driver_t::Stop() noexcept
 /// </summary>
 void pmd_driver_t::Render(int16_t * frames, size_t frameCount) noexcept
 {
+    // The frames left over by RenderStems() are in the stem buffers. Drop them.
+    if (_IsRenderingStems)
+    {
+        _IsRenderingStems = false;
+
+        _FramePtr = _SrcFrames;
+        _FramesToDo = 0;
+    }
+
     size_t FramesDone = 0;
 
     do
@@ -364,87 +433,109 @@ void pmd_driver_t::Render(int16_t * frames, size_t frameCount) noexcept
                 FramesDone += _FramesToDo;
             }
 
-            if (_OPNAW->ReadStatus() & 0x01)
-                HandleTimerAInterrupt();
-
-            if (_OPNAW->ReadStatus() & 0x02)
-                HandleTimerBInterrupt();
-
-            _OPNAW->SetReg(0x27, _State._FMChannel3Mode | 0x30); // Reset both timer A and B.
-
-            const uint32_t NextTick = _OPNAW->GetNextTick(); // in μs
-
-            _OPNAW->AdvanceTimers(NextTick);
+            const uint32_t NextTick = ProcessTimers(); // in clocks
 
             {
-                _FramesToDo = (size_t) ((double) (NextTick * _PCMSampleRate) / 1'000'000.0);
+                _FramesToDo = AdvancePosition(NextTick);
 
                 ::memset(_DstFrames, 0, _FramesToDo * sizeof(frame32_t));
 
-                if (_PCMSampleRate == _PPZSampleRate)
+                // The PPZ8 runs at the output sample rate. Its pitch steps already include the conversion from the source rate of each sample.
+                if (_Usage.UsesPPZ8)
                     _PPZ8->Mix(_DstFrames, _FramesToDo);
-                else
-                {
-                    // PCM frequency transform of ppz8 (no interpolation)
-                    size_t SampleCount = (size_t) (_FramesToDo * _PPZSampleRate / _PCMSampleRate + 1);
-                    int32_t delta = (int32_t) (8192 * _PPZSampleRate / _PCMSampleRate);
-
-                    ::memset(_TmpFrames, 0, SampleCount * sizeof(sample_t) * 2);
-
-                    _PPZ8->Mix(_TmpFrames, SampleCount);
-
-                    int32_t Carry = 0;
-
-                    // Frequency transform (1 << 13 = 8192)
-                    for (size_t i = 0; i < _FramesToDo; ++i)
-                    {
-                        _DstFrames[i].Left  = _TmpFrames[(Carry >> 13)].Left;
-                        _DstFrames[i].Right = _TmpFrames[(Carry >> 13)].Right;
-
-                        Carry += delta;
-                    }
-                }
             }
 
             {
                 _OPNAW->Mix((sample_t *) _DstFrames, _FramesToDo);
 
-                if (_UsePPSForDrums)
+                if (_UsePPSForDrums && _Usage.UsesSSGEffects)
                     _PPS->Mix(_DstFrames, _FramesToDo);
 
-                if (_IsUsingP86)
+                if (_IsUsingP86 && _Usage.UsesADPCM)
                     _P86->Mix(_DstFrames, _FramesToDo);
             }
 
-            _Position += NextTick;
+            ConvertFrames(_DstFrames, _SrcFrames, _FramesToDo, GetFadeOutFactor());
+        }
+    }
+    while (FramesDone < frameCount);
+}
 
-            {
-                if (_State._FadeOutSpeedHQ > 0)
-                {
-                    int32_t Factor = (_State._LoopCount != -1) ? (int32_t) ((1 << 10) * std::pow(512, -(double) (_Position - _FadeOutPosition) / 1'000 / _State._FadeOutSpeedHQ)) : 0;
+/// <summary>
+/// Renders a chunk of PCM data as stems, one stereo buffer for each source (see stem_t), in a single pass. Mixing the stems approximates the output of Render() without the wait emulation.
+/// Returns false if the OPNA is interpolated, because its stems can only be generated at the output sample rate, or if the stem buffers cannot be allocated.
+/// </summary>
+bool pmd_driver_t::RenderStems(int16_t * const * stemData, size_t frameCount) noexcept
+{
+    if (_UseInterpolation && (_PCMSampleRate != FREQUENCY_55_4K))
+        return false;
 
-                    for (size_t i = 0; i < _FramesToDo; ++i)
-                    {
-                        _SrcFrames[i].Left  = (int16_t) std::clamp(_DstFrames[i].Left  * Factor >> 10, -32768, 32767);
-                        _SrcFrames[i].Right = (int16_t) std::clamp(_DstFrames[i].Right * Factor >> 10, -32768, 32767);
-                    }
+    if (_StemFrames.empty())
+    {
+        try
+        {
+            _StemFrames.resize(StemCount * MaxFrames);
+            _StemMixFrames.resize(StemCount * MaxFrames);
+        }
+        catch (const std::bad_alloc &)
+        {
+            _StemFrames.clear();
+            _StemMixFrames.clear();
 
-                    // Fadeout end
-                    if ((_Position - _FadeOutPosition > (int64_t) _State._FadeOutSpeedHQ * 1'000) && _StopAfterFadeout)
-                        _Driver._Flags |= DriverStopRequested;
-                }
-                else
-                {
-                    for (size_t i = 0; i < _FramesToDo; ++i)
-                    {
-                        _SrcFrames[i].Left  = (int16_t) std::clamp(_DstFrames[i].Left,  -32768, 32767);
-                        _SrcFrames[i].Right = (int16_t) std::clamp(_DstFrames[i].Right, -32768, 32767);
-                    }
-                }
-            }
+            return false;
         }
     }
-    while (FramesDone < frameCount);
+
+    // The frames left over by Render() are in the mixed buffer. Drop them.
+    if (!_IsRenderingStems)
+    {
+        _IsRenderingStems = true;
+
+        _FramePtr = _SrcFrames;
+        _FramesToDo = 0;
+    }
+
+    // The wait emulation of the OPNA mixes ahead into a single buffer. Disable it like GetLength() does.
+    const int32_t FMDelay    = _OPNAW->GetFMDelay();
+    const int32_t SSGDelay   = _OPNAW->GetSSGDelay();
+    const int32_t ADPCMDelay = _OPNAW->GetADPCMDelay();
+    const int32_t RSSDelay   = _OPNAW->GetRSSDelay();
+
+    _OPNAW->SetFMDelay(0);
+    _OPNAW->SetSSGDelay(0);
+    _OPNAW->SetADPCMDelay(0);
+    _OPNAW->SetRhythmDelay(0);
+
+    size_t FramesDone = 0;
+
+    while (FramesDone < frameCount)
+    {
+        if (_FramesToDo == 0)
+        {
+            RenderStemsTick();
+
+            _FramePtr = _SrcFrames;
+            continue;
+        }
+
+        const size_t FrameIndex = (size_t) (_FramePtr - _SrcFrames);
+        const size_t FramesToCopy = std::min(_FramesToDo, frameCount - FramesDone);
+
+        for (size_t i = 0; i < StemCount; ++i)
+            ::memcpy(stemData[i] + FramesDone * 2, &_StemFrames[i * MaxFrames + FrameIndex], FramesToCopy * sizeof(frame16_t));
+
+        _FramesToDo -= FramesToCopy;
+        _FramePtr   += FramesToCopy;
+
+        FramesDone += FramesToCopy;
+    }
+
+    _OPNAW->SetFMDelay(FMDelay);
+    _OPNAW->SetSSGDelay(SSGDelay);
+    _OPNAW->SetADPCMDelay(ADPCMDelay);
+    _OPNAW->SetRhythmDelay(RSSDelay);
+
+    return true;
 }
 
 /// <summary>
@@ -456,7 +547,7 @@ uint32_t pmd_driver_t::GetLoopNumber() const noexcept
 }
 
 /// <summary>
-/// Gets the length of the song and loop part (in ms).
+/// Gets the length of the song and loop part (in ms). Returns false if the song was aborted because it exceeded the command budget of a tick or of the whole song.
 /// </summary>
 bool pmd_driver_t::GetLength(uint32_t & songLength, uint32_t & loopLength, uint32_t & songTicks, uint32_t & loopTicks) noexcept
 {
@@ -487,22 +578,28 @@ bool pmd_driver_t::GetLength(uint32_t & songLength, uint32_t & loopLength, uint3
 
             _OPNAW->SetReg(0x27, _State._FMChannel3Mode | 0x30); // Reset both timer A and B.
 
-            const uint32_t NextTick = _OPNAW->GetNextTick(); // in μs
+            const uint32_t NextTick = _OPNAW->GetNextTick(); // in clocks
 
             _OPNAW->AdvanceTimers(NextTick);
 
             _Position += NextTick;
         }
 
+        if (_TotalCommandCount > MaxCommandsPerSong)
+            _ErrorCode = ERR_SIMULATION_LIMIT;
+
+        if (_ErrorCode != ERR_SUCCESS) // Aborted
+            goto Stop;
+
         if ((_State._LoopCount == 1) && (songLength == 0)) // When looping
         {
-            songLength = (uint32_t) _Position / 1'000;
+            songLength = (uint32_t) ClocksToMs(_Position);
             songTicks  = GetPositionInTicks();
         }
         else
         if (_State._LoopCount == -1) // End without loop
         {
-            songLength = (uint32_t) _Position / 1'000; // in ms
+            songLength = (uint32_t) ClocksToMs(_Position); // in ms
             songTicks  = GetPositionInTicks(); // in ticks
 
             loopLength = 0; // in ms
@@ -513,7 +610,7 @@ bool pmd_driver_t::GetLength(uint32_t & songLength, uint32_t & loopLength, uint3
         else
         if (GetPositionInTicks() >= 65536) // Forced termination.
         {
-            songLength = (uint32_t) _Position / 1'000;
+            songLength = (uint32_t) ClocksToMs(_Position);
             songTicks  = GetPositionInTicks();
 
             loopLength = songLength;
@@ -524,7 +621,7 @@ bool pmd_driver_t::GetLength(uint32_t & songLength, uint32_t & loopLength, uint3
     }
     while (_State._LoopCount < 2);
 
-    loopLength = (uint32_t) (_Position / 1'000) - songLength; // in ms
+    loopLength = (uint32_t) ClocksToMs(_Position) - songLength; // in ms
     loopTicks  = GetPositionInTicks() - songTicks; // in ticks
 
 Stop:
@@ -536,55 +633,86 @@ Stop:
     _OPNAW->SetADPCMDelay(ADPCMDelay);
     _OPNAW->SetRhythmDelay(RSSDelay);
 
-    return true;
+    return (_ErrorCode == ERR_SUCCESS);
 }
 
 /// <summary>
-/// Gets the playback position (in ms)
+/// Compiles the song into a log of OPNA register writes by running the driver without synthesizing audio. The log covers the song and one loop.
+/// Returns false if the song was aborted (see GetErrorCode()).
 /// </summary>
-uint32_t pmd_driver_t::GetPosition() const noexcept
+bool pmd_driver_t::CompileRegisterLog(register_log_t & log)
 {
-    return (uint32_t) (_Position / 1'000);
-}
+    const uint64_t StartTime = ::GetTickCount64();
 
-/// <summary>
-/// Sets the playback position (in ms)
-/// </summary>
-void pmd_driver_t::SetPosition(uint32_t position)
-{
-    int64_t NewPosition = (int64_t) position * 1'000; // Convert ms to μs.
+    log.Clear();
 
-    if (_Position > NewPosition)
+    // Save the original delay values. The wait emulation synthesizes audio while registers are being written.
+    const int32_t FMDelay    = _OPNAW->GetFMDelay();
+    const int32_t SSGDelay   = _OPNAW->GetSSGDelay();
+    const int32_t ADPCMDelay = _OPNAW->GetADPCMDelay();
+    const int32_t RSSDelay   = _OPNAW->GetRSSDelay();
+
+    _OPNAW->SetFMDelay(0);
+    _OPNAW->SetSSGDelay(0);
+    _OPNAW->SetADPCMDelay(0);
+    _OPNAW->SetRhythmDelay(0);
+
+    SetRegisterLog(&log);
+
+    DriverStart();
+
+    uint32_t Time = 0; // in samples
+
+    while ((_ErrorCode == ERR_SUCCESS) && (_State._LoopCount != -1) && (_State._LoopCount < 2) && (GetPositionInTicks() < 65536))
     {
-        DriverStart();
+        // The registers are written by the timer interrupts at the start of the tick.
+        Time = (uint32_t) (_Position * register_log_t::SampleRate / OPNAClock);
 
-        _FramePtr = _SrcFrames;
+        log.SetTime(Time);
 
-        _FramesToDo = 0;
-        _Position = 0;
+        _Position += ProcessTimers();
+
+        if ((_State._LoopCount == 1) && (log.GetLoopTime() == register_log_t::NoLoop))
+            log.SetLoopTime(Time);
+
+        if (_TotalCommandCount > MaxCommandsPerSong)
+            _ErrorCode = ERR_SIMULATION_LIMIT;
     }
 
-    while (_Position < NewPosition)
-    {
-        if (_OPNAW->ReadStatus() & 0x01)
-            HandleTimerAInterrupt();
+    SetRegisterLog(nullptr);
 
-        if (_OPNAW->ReadStatus() & 0x02)
-            HandleTimerBInterrupt();
+    // The song ends where the second loop starts. Without a loop it ends after the last tick.
+    log.SetDuration((_State._LoopCount == 2) ? Time : (uint32_t) (_Position * register_log_t::SampleRate / OPNAClock));
 
-        _OPNAW->SetReg(0x27, _State._FMChannel3Mode | 0x30); // Timer Reset (Both timer A and B)
+    DriverStop();
 
-        const uint32_t TickCount = _OPNAW->GetNextTick();
+    // Restore the original delay values.
+    _OPNAW->SetFMDelay(FMDelay);
+    _OPNAW->SetSSGDelay(SSGDelay);
+    _OPNAW->SetADPCMDelay(ADPCMDelay);
+    _OPNAW->SetRhythmDelay(RSSDelay);
 
-        _OPNAW->AdvanceTimers(TickCount);
+    log.SetCompileTime((uint32_t) (::GetTickCount64() - StartTime));
 
-        _Position += TickCount;
-    }
+    return (_ErrorCode == ERR_SUCCESS);
+}
 
-    if (_State._LoopCount == -1)
-        Mute();
+/// <summary>
+/// Gets the playback position (in ms)
+/// </summary>
+uint32_t pmd_driver_t::GetPosition() const noexcept
+{
+    return (uint32_t) ClocksToMs(_Position);
+}
 
-    _OPNAW->ClearBuffer();
+/// <summary>
+/// Sets the playback position (in ms)
+/// </summary>
+void pmd_driver_t::SetPosition(uint32_t position)
+{
+    const int64_t NewPosition = (int64_t) position * OPNAClock / 1'000; // Convert ms to clocks.
+
+    Seek(_Position > NewPosition, [this, NewPosition] { return _Position < NewPosition; });
 }
 
 /// <summary>
@@ -600,16 +728,54 @@ uint32_t pmd_driver_t::GetPositionInTicks() const noexcept
 /// </summary>
 void pmd_driver_t::SetPositionInTicks(int tickCount)
 {
-    if (((_State._BarLength * _State._BarCounter) + _State._OpsCounter) > tickCount)
+    auto GetTicks = [this] { return (_State._BarLength * _State._BarCounter) + _State._OpsCounter; };
+
+    Seek(GetTicks() > tickCount, [GetTicks, tickCount] { return GetTicks() < tickCount; });
+}
+
+/// <summary>
+/// Runs the driver without synthesizing audio as long as the predicate returns true, optionally after restarting the song.
+/// The chip and the PCM drivers only log the writes and calls while the driver runs. The state at the position is replayed from the log once it has been reached (see register_log_t::Replay()).
+/// That leaves out the wait emulation. The notes held at the position start again.
+/// </summary>
+template<typename Predicate>
+void pmd_driver_t::Seek(bool restart, Predicate isBeforeTarget)
+{
+    // Save the original delay values. The wait emulation would synthesize audio while registers are being written.
+    const int32_t FMDelay    = _OPNAW->GetFMDelay();
+    const int32_t SSGDelay   = _OPNAW->GetSSGDelay();
+    const int32_t ADPCMDelay = _OPNAW->GetADPCMDelay();
+    const int32_t RSSDelay   = _OPNAW->GetRSSDelay();
+
+    _OPNAW->SetFMDelay(0);
+    _OPNAW->SetSSGDelay(0);
+    _OPNAW->SetADPCMDelay(0);
+    _OPNAW->SetRhythmDelay(0);
+
+    _SeekLog.Clear();
+    _SeekLog.SetLogOnly(true);
+
+    SetRegisterLog(&_SeekLog);
+
+    if (restart)
     {
         DriverStart();
 
         _FramePtr = _SrcFrames;
+
         _FramesToDo = 0;
+        _Position = 0;
     }
 
-    while (((_State._BarLength * _State._BarCounter) + _State._OpsCounter) < tickCount)
+    uint32_t Time = 0; // in samples
+
+    while (isBeforeTarget())
     {
+        // The registers are written by the timer interrupts at the start of the tick.
+        Time = (uint32_t) (_Position * register_log_t::SampleRate / OPNAClock);
+
+        _SeekLog.SetTime(Time);
+
         if (_OPNAW->ReadStatus() & 0x01)
             HandleTimerAInterrupt();
 
@@ -621,14 +787,38 @@ void pmd_driver_t::SetPositionInTicks(int tickCount)
         const uint32_t TickCount = _OPNAW->GetNextTick();
 
         _OPNAW->AdvanceTimers(TickCount);
+
+        _Position += TickCount;
     }
 
+    SetRegisterLog(nullptr);
+
+    _SeekLog.SetLogOnly(false);
+    _SeekLog.Replay(*_OPNAW, _PPZ8, _P86, _PPS, Time + 1); // Include the writes of the last tick.
+
+    // Restore the original delay values.
+    _OPNAW->SetFMDelay(FMDelay);
+    _OPNAW->SetSSGDelay(SSGDelay);
+    _OPNAW->SetADPCMDelay(ADPCMDelay);
+    _OPNAW->SetRhythmDelay(RSSDelay);
+
     if (_State._LoopCount == -1)
         Mute();
 
     _OPNAW->ClearBuffer();
 }
 
+/// <summary>
+/// Sets the log that receives the register writes of the OPNA and the calls of the PCM drivers. Specify nullptr to stop logging.
+/// </summary>
+void pmd_driver_t::SetRegisterLog(register_log_t * log) noexcept
+{
+    _OPNAW->SetRegisterLog(log);
+    _PPZ8->SetRegisterLog(log);
+    _P86->SetRegisterLog(log);
+    _PPS->SetRegisterLog(log);
+}
+
 /// <summary>
 /// Sets the PCM search paths.
 /// </summary>
@@ -654,14 +844,12 @@ void pmd_driver_t::SetSampleRate(uint32_t sampleRate) noexcept
 {
     if (sampleRate == FREQUENCY_55_5K || sampleRate == FREQUENCY_55_4K)
     {
-        _PCMSampleRate =
-        _PPZSampleRate = FREQUENCY_44_1K;
+        _PCMSampleRate = FREQUENCY_44_1K;
         _UseInterpolation = true;
     }
     else
     {
-        _PCMSampleRate =
-        _PPZSampleRate = sampleRate;
+        _PCMSampleRate = sampleRate;
         _UseInterpolation = false;
     }
 
@@ -669,7 +857,7 @@ void pmd_driver_t::SetSampleRate(uint32_t sampleRate) noexcept
 
     _P86->SetSampleRate(_PCMSampleRate, _UseInterpolationP86);
     _PPS->SetSampleRate(_PCMSampleRate, _UseInterpolationPPS);
-    _PPZ8->SetSampleRate(_PPZSampleRate, _UseInterpolationPPZ);
+    _PPZ8->SetSampleRate(_PCMSampleRate, _UseInterpolationPPZ);
 }
 
 /// <summary>
@@ -685,19 +873,6 @@ void pmd_driver_t::SetInterpolation(bool value)
     _OPNAW->Initialize(OPNAClock, _PCMSampleRate, _UseInterpolation);
 }
 
-/// <summary>
-/// Sets the output frequency at which raw PPZ data is synthesized (in Hz, for example 44100).
-/// </summary>
-void pmd_driver_t::SetPPZSampleRate(uint32_t sampleRate) noexcept
-{
-    if (sampleRate == _PPZSampleRate)
-        return;
-
-    _PPZSampleRate = sampleRate;
-
-    _PPZ8->SetSampleRate(sampleRate, _UseInterpolationPPZ);
-}
-
 /// <summary>
 /// Enables or disables PPZ interpolation.
 /// </summary>
@@ -705,7 +880,7 @@ void pmd_driver_t::SetPPZInterpolation(bool flag)
 {
     _UseInterpolationPPZ = flag;
 
-    _PPZ8->SetSampleRate(_PPZSampleRate, flag);
+    _PPZ8->SetSampleRate(_PCMSampleRate, flag);
 }
 
 /// <summary>
@@ -847,6 +1022,8 @@ int pmd_driver_t::DisableChannel(int channel)
 
     _Driver._FMSelector = OldFMSelector;
 
+    UpdateChannelMask();
+
     return ERR_SUCCESS;
 }
 
@@ -868,7 +1045,11 @@ int pmd_driver_t::EnableChannel(int channel)
     if (_State._Channels[channel]->_PartMask == 0x00)
         return ERR_NOT_MASKED;
 
-    if ((_State._Channels[channel]->_PartMask &= 0xFE) != 0)
+    _State._Channels[channel]->_PartMask &= 0xFE;
+
+    UpdateChannelMask();
+
+    if (_State._Channels[channel]->_PartMask != 0)
         return ERR_EFFECT_USED;
 
     if (!IsPlaying())
@@ -900,6 +1081,50 @@ int pmd_driver_t::EnableChannel(int channel)
     return ERR_SUCCESS;
 }
 
+/// <summary>
+/// Stops the emulation of the FM and SSG channels that the song never uses or that only serve disabled parts.
+/// </summary>
+void pmd_driver_t::UpdateChannelMask() noexcept
+{
+    uint32_t FMMasked  = 0;
+    uint32_t FMEnabled = 0;
+
+    uint32_t SSGMasked  = 0;
+    uint32_t SSGEnabled = 0;
+
+    // A chip channel can only be skipped if every part that plays on it is disabled. (c2-c4 share FM channel 3, the Effect part shares FM channel 6 and K shares SSG channel 3)
+    for (int i = 0; i < MaxChannels; ++i)
+    {
+        if (ChannelTable[i][0] < 0)
+            continue;
+
+        const bool IsMasked = (_State._Channels[i]->_PartMask & 0x01) != 0;
+
+        switch (ChannelTable[i][2])
+        {
+            case 0:
+            case 1:
+            {
+                const uint32_t Bit = 1u << (ChannelTable[i][1] - 1 + ((ChannelTable[i][2] == 1) ? 3 : 0));
+
+                (IsMasked ? FMMasked : FMEnabled) |= Bit;
+                break;
+            }
+
+            case 2:
+            case 4:
+            {
+                const uint32_t Bit = 1u << (ChannelTable[i][1] - 1);
+
+                (IsMasked ? SSGMasked : SSGEnabled) |= Bit;
+                break;
+            }
+        }
+    }
+
+    _OPNAW->SetChannelMask(_Usage.FMChannels & ~(FMMasked & ~FMEnabled), _Usage.SSGChannels & ~(SSGMasked & ~SSGEnabled));
+}
+
 /// <summary>
 /// Gets the text of the specified memo.
 /// </summary>
@@ -965,11 +1190,11 @@ void pmd_driver_t::Reset()
 
     ::memset(_SrcFrames, 0, sizeof(_SrcFrames));
     ::memset(_DstFrames, 0, sizeof(_SrcFrames));
-    ::memset(_TmpFrames, 0, sizeof(_TmpFrames));
 
     _FramePtr = _SrcFrames;
     
     _FramesToDo = 0;
+    _IsRenderingStems = false;
     _Position = 0;
     _FadeOutPosition = 0;
     _Seed = 0;
@@ -994,6 +1219,17 @@ void pmd_driver_t::Reset()
 
     _IsUsingP86 = false;
 
+    _Usage.SetAll();
+
+    _PartCount = 0;
+
+    _CommandCount = 0;
+    _PeakCommandCount = 0;
+    _TotalCommandCount = 0;
+    _ErrorCode = ERR_SUCCESS;
+
+    _Events = nullptr;
+
     _RhythmVolume = 0x3C;
 
     // Initialize the state.
@@ -1023,7 +1259,7 @@ void pmd_driver_t::Reset()
         _State._Channels[12] = &_FMExtensionChannels[1];
         _State._Channels[13] = &_FMExtensionChannels[2];
 
-        _State._Channels[14] = &_DummyChannel; // Unused
+        _State._Channels[DummyChannelNumber] = &_DummyChannel; // Unused
         _State._Channels[15] = &_SSGEffectChannel;
 
         _State._Channels[16] = &_PPZ8Channels[0];
@@ -1039,6 +1275,123 @@ void pmd_driver_t::Reset()
     _Driver._Flags = DriverIdle;
 }
 
+/// <summary>
+/// Handles the pending timer interrupts and advances the timers to the next one. Returns the time until the next interrupt (in clocks).
+/// </summary>
+uint32_t pmd_driver_t::ProcessTimers() noexcept
+{
+    if (_OPNAW->ReadStatus() & 0x01)
+        HandleTimerAInterrupt();
+
+    if (_OPNAW->ReadStatus() & 0x02)
+        HandleTimerBInterrupt();
+
+    _OPNAW->SetReg(0x27, _State._FMChannel3Mode | 0x30); // Reset both timer A and B.
+
+    const uint32_t NextTick = _OPNAW->GetNextTick(); // in clocks
+
+    _OPNAW->AdvanceTimers(NextTick);
+
+    return NextTick;
+}
+
+/// <summary>
+/// Advances the playback position by the specified number of clocks and returns the number of frames that cover them.
+/// The frame count is derived from the absolute position so the rounding of one tick is made up for by the next one.
+/// </summary>
+size_t pmd_driver_t::AdvancePosition(uint32_t clockCount) noexcept
+{
+    const int64_t FramePosition = _Position * _PCMSampleRate / OPNAClock;
+
+    _Position += clockCount;
+
+    return (size_t) ((_Position * _PCMSampleRate / OPNAClock) - FramePosition);
+}
+
+/// <summary>
+/// Renders the stems of the frames until the next timer interrupt.
+/// </summary>
+void pmd_driver_t::RenderStemsTick() noexcept
+{
+    const uint32_t NextTick = ProcessTimers(); // in clocks
+
+    _FramesToDo = AdvancePosition(NextTick);
+
+    frame32_t * Stems[StemCount];
+
+    for (size_t i = 0; i < StemCount; ++i)
+    {
+        Stems[i] = &_StemMixFrames[i * MaxFrames];
+
+        ::memset(Stems[i], 0, _FramesToDo * sizeof(frame32_t));
+    }
+
+    if (_Usage.UsesPPZ8)
+        _PPZ8->MixStems(&Stems[StemPPZ1], _FramesToDo);
+
+    {
+        sample_t * OPNAStems[opna_t::StemCount];
+
+        for (size_t i = 0; i < opna_t::StemCount; ++i)
+            OPNAStems[i] = (sample_t *) Stems[StemFM1 + i];
+
+        _OPNAW->MixStems(OPNAStems, _FramesToDo);
+
+        if (_UsePPSForDrums && _Usage.UsesSSGEffects)
+            _PPS->Mix(Stems[StemPPS], _FramesToDo);
+
+        if (_IsUsingP86 && _Usage.UsesADPCM)
+            _P86->Mix(Stems[StemADPCM], _FramesToDo);
+    }
+
+    const int32_t Factor = GetFadeOutFactor();
+
+    for (size_t i = 0; i < StemCount; ++i)
+        ConvertFrames(Stems[i], &_StemFrames[i * MaxFrames], _FramesToDo, Factor);
+}
+
+/// <summary>
+/// Gets the volume factor of the fade-out (1 << 10 is full volume) and requests a stop when the fade-out has finished. Returns -1 if no fade-out is in progress.
+/// </summary>
+int32_t pmd_driver_t::GetFadeOutFactor() noexcept
+{
+    if (_State._FadeOutSpeedHQ <= 0)
+        return -1;
+
+    const int64_t Elapsed = ClocksToMs(_Position - _FadeOutPosition); // in ms
+
+    const int32_t Factor = (_State._LoopCount != -1) ? (int32_t) ((1 << 10) * std::pow(512, -(double) Elapsed / _State._FadeOutSpeedHQ)) : 0;
+
+    // Fadeout end
+    if ((Elapsed > (int64_t) _State._FadeOutSpeedHQ) && _StopAfterFadeout)
+        _Driver._Flags |= DriverStopRequested;
+
+    return Factor;
+}
+
+/// <summary>
+/// Applies the fade-out to the mixed frames and converts them to 16-bit.
+/// </summary>
+void pmd_driver_t::ConvertFrames(const frame32_t * srcFrames, frame16_t * dstFrames, size_t frameCount, int32_t factor) noexcept
+{
+    if (factor >= 0)
+    {
+        for (size_t i = 0; i < frameCount; ++i)
+        {
+            dstFrames[i].Left  = (int16_t) std::clamp(srcFrames[i].Left  * factor >> 10, -32768, 32767);
+            dstFrames[i].Right = (int16_t) std::clamp(srcFrames[i].Right * factor >> 10, -32768, 32767);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < frameCount; ++i)
+        {
+            dstFrames[i].Left  = (int16_t) std::clamp(srcFrames[i].Left,  -32768, 32767);
+            dstFrames[i].Right = (int16_t) std::clamp(srcFrames[i].Right, -32768, 32767);
+        }
+    }
+}
+
 /// <summary>
 /// Starts the OPN interrupt.
 /// </summary>
@@ -1060,6 +1413,8 @@ void pmd_driver_t::StartOPNInterrupt()
 
     _RhythmMask = 0xFF;
 
+    UpdateChannelMask();
+
     InitializeState();
     InitializeOPNA();
 
@@ -1313,408 +1668,475 @@ void pmd_driver_t::HandleTimerBInterrupt()
 }
 
 /// <summary>
-/// Executes a command. The execution is the same for all sound sources.
+/// 5.2. Volume Setting 2, Set the volume finely, 0–127 (FM) / 0–255 (PCM), 0–15 (SSG, SSG rhythm, PPZ), Command 'V number'
 /// </summary>
-uint8_t * pmd_driver_t::ExecuteCommand(channel_t * channel, uint8_t * si, uint8_t command)
+template<> uint8_t * pmd_driver_t::CommonCommand<0xFD>(channel_t * channel, uint8_t * si)
 {
-    switch (command)
-    {
-        case 0xFF: si++; break;
-        case 0xFE: si++; break;
+    channel->_Volume = *si++;
 
-        // 5.2. Volume Setting 2, Set the volume finely, 0–127 (FM) / 0–255 (PCM), 0–15 (SSG, SSG rhythm, PPZ), Command 'V number'
-        case 0xFD:
-        {
-            channel->_Volume = *si++;
-            break;
-        }
+    return si;
+}
 
-        // 11.1. Tempo Setting 1 / 11.2. Tempo Setting 2
-        case 0xFC:
-        {
-            si = SetTempoCommand(si);
-            break;
-        }
+/// <summary>
+/// 11.1. Tempo Setting 1 / 11.2. Tempo Setting 2
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xFC>(channel_t *, uint8_t * si)
+{
+    return SetTempoCommand(si);
+}
 
-        // 4.10. Tie/Slur Setting, Connects the sound before and after as a tie (&). Keyoff will not be done on the previous note. 
-        case 0xFB:
-        {
-            _Driver._IsTieSet = true;
-            break;
-        }
+/// <summary>
+/// 4.10. Tie/Slur Setting, Connects the sound before and after as a tie (&). Keyoff will not be done on the previous note.
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xFB>(channel_t *, uint8_t * si)
+{
+    _Driver._IsTieSet = true;
 
-        // 7.1. Detune Setting, Sets the detune (frequency shift value), Command 'D number' / Command 'DD number'
-        case 0xFA:
-        {
-            channel->_DetuneValue = *(int16_t *) si;
-            si += 2;
-            break;
-        }
+    return si;
+}
 
-        // 10.1. Local Loop Setting, Start loop, Command '['
-        case 0xF9:
-        {
-            si = SetStartOfLoopCommand(channel, si);
-            break;
-        }
+/// <summary>
+/// 7.1. Detune Setting, Sets the detune (frequency shift value), Command 'D number' / Command 'DD number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xFA>(channel_t * channel, uint8_t * si)
+{
+    channel->_DetuneValue = *(int16_t *) si;
+    si += 2;
 
-        // 10.1. Local Loop Setting, End loop, Command ']'
-        case 0xF8:
-        {
-            si = SetEndOfLoopCommand(channel, si);
-            break;
-        }
+    return si;
+}
 
-        // 10.1. Local Loop Setting, Exit loop, Command ':'
-        case 0xF7:
-        {
-            si = ExitLoopCommand(channel, si);
-            break;
-        }
+/// <summary>
+/// 10.2. Global Loop Setting, Command 'L'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xF6>(channel_t * channel, uint8_t * si)
+{
+    channel->_LoopData = si;
 
-        // 10.2. Global Loop Setting, Command 'L'
-        case 0xF6:
-        {
-            channel->_LoopData = si;
+    // Prevent an endless loop.
+    if (*channel->_LoopData == 0x80)
+        channel->_LoopData = nullptr;
 
-            // Prevent an endless loop.
-            if (*channel->_LoopData == 0x80)
-                channel->_LoopData = nullptr;
-            break;
-        }
+    return si;
+}
 
-        // 4.14. Modulation Setting, Command '_ number'
-        case 0xF5:
-        {
-            channel->Transposition1 = *(int8_t *) si++;
-            break;
-        }
+/// <summary>
+/// 4.14. Modulation Setting, Command '_ number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xF5>(channel_t * channel, uint8_t * si)
+{
+    channel->Transposition1 = *(int8_t *) si++;
 
-        // 5.5. Relative Volume Change, Increase volume by 3dB.
-        case 0xF4:
-        {
-            channel->_Volume += 16;
+    return si;
+}
 
-            if (channel->_Volume > 255)
-                channel->_Volume = 255;
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Increase volume by 3dB.
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xF4>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume += 16;
+
+    if (channel->_Volume > 255)
+        channel->_Volume = 255;
+
+    return si;
+}
+
+/// <summary>
+/// 5.5. Relative Volume Change, Decrease volume by 3dB.
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xF3>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume -= 16;
+
+    if (channel->_Volume < 16)
+        channel->_Volume = 0;
+
+    return si;
+}
+
+/// <summary>
+/// 14.1. Rhythm Sound Source Shot/Dump Control
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xEB>(channel_t * channel, uint8_t * si)
+{
+    return RhythmControl(channel, si);
+}
 
-        // 5.5. Relative Volume Change, Decrease volume by 3dB.
-        case 0xF3:
-        {
-            channel->_Volume -= 16;
+/// <summary>
+/// 14.3. Rhythm Sound Source Individual Volume Setting, Set the volume for an individual rhythm channel, Command 'v number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xEA>(channel_t *, uint8_t * si)
+{
+    return RhythmSetVolume(si);
+}
 
-            if (channel->_Volume < 16)
-                channel->_Volume = 0;
-            break;
-        }
+/// <summary>
+/// 14.4. Rhythm Sound Source Output Position Setting, Command '\lb \ls \lc \lh \lt \li \mb \ms \mc \mh \mt \mi \rb \rs \rc \rh \rt \ri'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xE9>(channel_t *, uint8_t * si)
+{
+    return RhythmSetPan(si);
+}
 
-        // 9.1. Software LFO Setting, Set software LFO 1, Command 'MA number1, number2, number3, number4'
-        case 0xF2:
-        {
-            si = LFO1SetModulation(channel, si);
-            break;
-        }
+/// <summary>
+/// 14.2. Rhythm Sound Source Master Volume Setting, Sets the master volume of the rhythm sound source, Command 'V number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xE8>(channel_t *, uint8_t * si)
+{
+    return RhythmSetMasterVolume(si);
+}
 
-        // 9.3. Software LFO Switch, Controls on/off and keyon synchronization of the software LFO, Command '*A number'
-        case 0xF1:
-        {
-            si = LFO1SetSwitch(channel, si);
-            break;
-        }
+/// <summary>
+/// 4.14. Modulation Setting, Command '__ number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xE7>(channel_t * channel, uint8_t * si)
+{
+    channel->Transposition1 += *(int8_t *) si++;
 
-        // 8.1. SSG/PCM Software Envelope Setting, Sets a software envelope (only for OPN/OPNA's SSG/ADPCM channels), Command 'E number1, number2, number3, number4'
-        case 0xF0:
-        {
-            si = SSGSetEnvelope1(channel, si);
-            break;
-        }
+    return si;
+}
 
-        // 14.1. Rhythm Sound Source Shot/Dump Control
-        case 0xEB:
-        {
-            si = RhythmControl(si);
-            break;
-        }
+/// <summary>
+/// 14.2. Rhythm Sound Source Master Volume Setting
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xE6>(channel_t *, uint8_t * si)
+{
+    return RhythmSetRelativeMasterVolume(si);
+}
 
-        // 14.3. Rhythm Sound Source Individual Volume Setting, Set the volume for an individual rhythm channel, Command 'v number'
-        case 0xEA:
-        {
-            si = RhythmSetVolume(si);
-            break;
-        }
+/// <summary>
+/// 14.3. Rhythm Sound Source Individual Volume Setting
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xE5>(channel_t *, uint8_t * si)
+{
+    return RhythmSetRelativeVolume(si);
+}
 
-        // 14.4. Rhythm Sound Source Output Position Setting, Command '\lb \ls \lc \lh \lt \li \mb \ms \mc \mh \mt \mi \rb \rs \rc \rh \rt \ri'
-        case 0xE9:
-        {
-            si = RhythmSetPan(si);
-            break;
-        }
+/// <summary>
+/// 4.11. Whole Note Length Setting, Sets the length of a whole note. Equivalent to the #Zenlen command, Command 'C number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xDF>(channel_t *, uint8_t * si)
+{
+    _State._BarLength = *si++;
 
-        // 14.2. Rhythm Sound Source Master Volume Setting, Sets the master volume of the rhythm sound source, Command 'V number'
-        case 0xE8:
-        {
-            si = RhythmSetMasterVolume(si);
-            break;
-        }
+    return si;
+}
 
-        // 4.14. Modulation Setting, Command '__ number'
-        case 0xE7:
-        {
-            channel->Transposition1 += *(int8_t *) si++;
-            break;
-        }
+/// <summary>
+/// 15.9. Write to Status1, Command '~ number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xDC>(channel_t *, uint8_t * si)
+{
+    _Status1 = *si++;
 
-        // 14.2. Rhythm Sound Source Master Volume Setting
-        case 0xE6:
-        {
-            si = RhythmSetRelativeMasterVolume(si);
-            break;
-        }
+    return si;
+}
 
-        // 14.3. Rhythm Sound Source Individual Volume Setting
-        case 0xE5:
-        {
-            si = RhythmSetRelativeVolume(si);
-            break;
-        }
+/// <summary>
+/// 15.9. Write to Status1, Command '~ ±number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xDB>(channel_t *, uint8_t * si)
+{
+    _Status1 += *si++;
 
-        case 0xE4: si++; break;
-        case 0xE1: si++; break;
-        case 0xE0: si++; break;
+    return si;
+}
 
-        // 4.11. Whole Note Length Setting, Sets the length of a whole note. Equivalent to the #Zenlen command, Command 'C number'
-        case 0xDF:
-        {
-            _State._BarLength = *si++;
-            break;
-        }
+/// <summary>
+/// 9.7. LFO Depth Temporal Change Setting, Sets the temporal change of depth (depth A) of LFO 1, Command 'MDA number1[,±number2[,number3]]'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xD6>(channel_t * channel, uint8_t * si)
+{
+    channel->_LFO1DepthSpeedCounter1 =
+    channel->_LFO1DepthSpeedCounter2 = *si++;
+    channel->_LFO1Depth              = *(int8_t *) si++;
 
-        // 5.5. Relative Volume Change, Command '( ^%number'
-        case 0xDD:
-        {
-            si = DecreaseVolumeForNextNote(channel, si);
-            break;
-        }
+    return si;
+}
 
-        // 15.9. Write to Status1, Command '~ number'
-        case 0xDC:
-        {
-            _Status1 = *si++;
-            break;
-        }
+/// <summary>
+/// 7.1. Detune Setting, Sets the detune (frequency shift value), Command 'DD number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xD5>(channel_t * channel, uint8_t * si)
+{
+    channel->_DetuneValue += *(int16_t *) si;
+    si += 2;
 
-        // 15.9. Write to Status1, Command '~ ±number'
-        case 0xDB:
-        {
-            _Status1 += *si++;
-            break;
-        }
+    return si;
+}
 
-        case 0xD9: si++; break;
-        case 0xD8: si++; break;
-        case 0xD7: si++; break;
+/// <summary>
+/// 15.3. Fade Out Setting, Fades out from the specified position, Command 'F number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xD2>(channel_t *, uint8_t * si)
+{
+    _State._FadeOutSpeed      = *si++;
+    _State._IsFadeOutSpeedSet = true;
 
-        // 9.7. LFO Depth Temporal Change Setting, Sets the temporal change of depth (depth A) of LFO 1, Command 'MDA number1[,±number2[,number3]]'
-        case 0xD6:
-        {
-            channel->_LFO1DepthSpeedCounter1 =
-            channel->_LFO1DepthSpeedCounter2 = *si++;
-            channel->_LFO1Depth              = *(int8_t *) si++;
-            break;
-        }
+    return si;
+}
 
-        // 7.1. Detune Setting, Sets the detune (frequency shift value), Command 'DD number'
-        case 0xD5:
-        {
-            channel->_DetuneValue += *(int16_t *) si;
-            si += 2;
-            break;
-        }
+/// <summary>
+/// 9.2. Software LFO Waveform Setting, Sets the LFO waveform, Command 'MW number' / 'MWA number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xCB>(channel_t * channel, uint8_t * si)
+{
+    channel->_LFO1Waveform = *si++;
 
-        // 15.5. SSG Sound Effect Playback, Play SSG sound effect, Command 'n number'
-        case 0xD4:
-        {
-            si = SetSSGEffect(channel, si);
-            break;
-        }
+    return si;
+}
 
-        // 15.5. FM Sound Effect Playback, Play FM sound effect, Command 'N number'
-        case 0xD3:
-        {
-            si = SetFMEffect(channel, si);
-            break;
-        }
+/// <summary>
+/// 9.5. Software LFO Speed Setting, Set the LFO 1 speed, Command 'MXA number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xCA>(channel_t * channel, uint8_t * si)
+{
+    // If set to 0, the LFO speed is dependent on tempo. So if the tempo is slow the LFO will also be slow.
+    // If set to 1, change the LFO by the M MA MB commands to an extended specification that makes it constant speed independent of tempo.
+    channel->_ExtendMode = (channel->_ExtendMode & 0xFD) | ((*si++ & 0x01) << 1);
 
-        // 15.3. Fade Out Setting, Fades out from the specified position, Command 'F number'
-        case 0xD2:
-        {
-            _State._FadeOutSpeed      = *si++;
-            _State._IsFadeOutSpeedSet = true;
-            break;
-        }
+    return si;
+}
+
+/// <summary>
+/// 4.12. Sound Cut Setting 1, Shortens the sustain duration of following notes by x/8-th's of the actual note length. Valid range for x = 0 - 8, Command 'Q [%] numerical value'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xC4>(channel_t * channel, uint8_t * si)
+{
+    // Set Early Key Off Timeout Percentage. Stops note (length * pp / 100h) ticks early, added to value of command FE.
+    channel->EarlyKeyOffTimeoutPercentage = *si++;
 
-        case 0xD1: si++; break;
-        case 0xD0: si++; break;
-        case 0xCF: si++; break;
-        case 0xCE: si += 6; break;
+    return si;
+}
 
-        // 8.1. SSG/PCM Software Envelope Setting, Sets a software envelope (only for OPN/OPNA's SSG/ADPCM channels), Command 'E number1, number2, number3, number4, number5, number6'
-        case 0xCD:
-        {
-            si = SSGSetEnvelope2(channel, si);
-            break;
-        }
+/// <summary>
+/// 9.13. Hardware LFO Delay Setting, Sets the hardware LFO delay, Command '#D number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xC2>(channel_t * channel, uint8_t * si)
+{
+    channel->_LFO1DelayCounter =
+    channel->_LFO1Delay = *si++;
 
-        case 0xCC: si++; break;
+    LFOReset(channel);
 
-        // 9.2. Software LFO Waveform Setting, Sets the LFO waveform, Command 'MW number' / 'MWA number'
-        case 0xCB:
-        {
-            channel->_LFO1Waveform = *si++;
-            break;
-        }
+    return si;
+}
 
-        /// 9.5. Software LFO Speed Setting, Set the LFO 1 speed, Command 'MXA number'
-        case 0xCA:
-        {
-            // If set to 0, the LFO speed is dependent on tempo. So if the tempo is slow the LFO will also be slow.
-            // If set to 1, change the LFO by the M MA MB commands to an extended specification that makes it constant speed independent of tempo.
-            channel->_ExtendMode = (channel->_ExtendMode & 0xFD) | ((*si++ & 0x01) << 1);
-            break;
-        }
+/// <summary>
+/// 9.1. Software LFO Setting, Set software LFO 2, Command 'MB number1, number2, number3, number4'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xBF>(channel_t * channel, uint8_t * si)
+{
+    LFOSwap(channel);
 
-        case 0xC8: si += 3; break;
-        case 0xC7: si += 3; break;
-        case 0xC6: si += 6; break;
-        case 0xC5: si++; break;
+    si = LFO1SetModulation(channel, si);
 
-        // 4.12. Sound Cut Setting 1, Shortens the sustain duration of following notes by x/8-th's of the actual note length. Valid range for x = 0 - 8, Command 'Q [%] numerical value'
-        case 0xC4:
-        {
-            // Set Early Key Off Timeout Percentage. Stops note (length * pp / 100h) ticks early, added to value of command FE.
-            channel->EarlyKeyOffTimeoutPercentage = *si++;
-            break;
-        }
+    LFOSwap(channel);
 
-        // 9.13. Hardware LFO Delay Setting, Sets the hardware LFO delay, Command '#D number'
-        case 0xC2:
-        {
-            channel->_LFO1DelayCounter =
-            channel->_LFO1Delay = *si++;
+    return si;
+}
 
-            LFOReset(channel);
-            break;
-        }
+/// <summary>
+/// 9.7. LFO Depth Temporal Change Setting, Sets the temporal change of depth (depth A) of LFO 2, Command 'MDB number1[,±number2[,number3]]'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xBD>(channel_t * channel, uint8_t * si)
+{
+    LFOSwap(channel);
 
-        // 4.10. Tie/Slur Setting, Connects the sound before and after as a slur (&&). Keyoff will be done on the previous note. 
-        case 0xC1: break;
+    channel->_LFO1DepthSpeedCounter1 =
+    channel->_LFO1DepthSpeedCounter2 = *si++;
+    channel->_LFO1Depth              = *(int8_t *) si++;
 
-        // 9.1. Software LFO Setting, Set software LFO 2, Command 'MB number1, number2, number3, number4'
-        case 0xBF:
-        {
-            LFOSwap(channel);
+    LFOSwap(channel);
 
-            si = LFO1SetModulation(channel, si);
+    return si;
+}
 
-            LFOSwap(channel);
-            break;
-        }
+/// <summary>
+/// 9.2. Software LFO Waveform Setting, Sets the LFO waveform, Command 'MWB number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xBC>(channel_t * channel, uint8_t * si)
+{
+    LFOSwap(channel);
 
-        // 9.7. LFO Depth Temporal Change Setting, Sets the temporal change of depth (depth A) of LFO 2, Command 'MDB number1[,±number2[,number3]]'
-        case 0xBD:
-        {
-            LFOSwap(channel);
+    channel->_LFO1Waveform = *si++;
 
-            channel->_LFO1DepthSpeedCounter1 =
-            channel->_LFO1DepthSpeedCounter2 = *si++;
-            channel->_LFO1Depth              = *(int8_t *) si++;
+    LFOSwap(channel);
 
-            LFOSwap(channel);
-            break;
-        }
+    return si;
+}
 
-        // 9.2. Software LFO Waveform Setting, Sets the LFO waveform, Command 'MWB number'
-        case 0xBC:
-        {
-            LFOSwap(channel);
+/// <summary>
+/// 9.5. Software LFO Speed Setting, Set the LFO 2 speed, Command 'MXB number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xBB>(channel_t * channel, uint8_t * si)
+{
+    LFOSwap(channel);
 
-            channel->_LFO1Waveform = *si++;
+    // If set to 0, the LFO speed is dependent on tempo. So if the tempo is slow the LFO will also be slow.
+    // If set to 1, change the LFO by the M MA MB commands to an extended specification that makes it constant speed independent of tempo.
+    channel->_ExtendMode = (channel->_ExtendMode & 0xFD) | ((*si++ & 0x01) << 1);
 
-            LFOSwap(channel);
-            break;
-        }
+    LFOSwap(channel);
 
-        // 9.5. Software LFO Speed Setting, Set the LFO 2 speed, Command 'MXB number'
-        case 0xBB:
-        {
-            LFOSwap(channel);
+    return si;
+}
 
-            // If set to 0, the LFO speed is dependent on tempo. So if the tempo is slow the LFO will also be slow.
-            // If set to 1, change the LFO by the M MA MB commands to an extended specification that makes it constant speed independent of tempo.
-            channel->_ExtendMode = (channel->_ExtendMode & 0xFD) | ((*si++ & 0x01) << 1);
+/// <summary>
+/// 9.13. Hardware LFO Delay Setting, Sets the hardware LFO delay, Command '#D number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xB9>(channel_t * channel, uint8_t * si)
+{
+    LFOSwap(channel);
 
-            LFOSwap(channel);
-            break;
-        }
+    channel->_LFO1DelayCounter =
+    channel->_LFO1Delay = *si++;
 
-        case 0xBA: si++; break;
+    LFOReset(channel);
 
-        // 9.13. Hardware LFO Delay Setting, Sets the hardware LFO delay, Command '#D number'
-        case 0xB9:
-        {
-            LFOSwap(channel);
+    LFOSwap(channel);
 
-            channel->_LFO1DelayCounter =
-            channel->_LFO1Delay = *si++;
+    return si;
+}
 
-            LFOReset(channel);
+/// <summary>
+/// 9.6. Dedicated Rise/Fall LFO Setting, Selects the rise/fall-type software LFO and turns it on, Command 'MPA ±number1', Range -128–+127
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xB7>(channel_t * channel, uint8_t * si)
+{
+    return LFOSetRiseFallType(channel, si);
+}
 
-            LFOSwap(channel);
-            break;
-        }
+/// <summary>
+/// 4.13. Sound Cut Setting 2, Command 'q [number1][-[number2]] [,number3]' / Command 'q [l length[.]][-[l length]] [,l length[.]]'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xB3>(channel_t * channel, uint8_t * si)
+{
+    // Set Early Key Off Timeout 2. Stop note after n ticks or earlier depending on the result of B1/C4/FE happening first.
+    channel->_EarlyKeyOffTimeout2 = *si++;
 
-        case 0xB8: si += 2; break;
+    return si;
+}
 
-        /// 9.6. Dedicated Rise/Fall LFO Setting, Selects the rise/fall-type software LFO and turns it on, Command 'MPA ±number1', Range -128–+127
-        case 0xB7:
-        {
-            si = LFOSetRiseFallType(channel, si);
-            break;
-        }
+/// <summary>
+/// 4.16. Master Modulation Setting, Default global transpose, at the beginning of all channels except the rhythm channel, Command '_M number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xB2>(channel_t * channel, uint8_t * si)
+{
+    channel->Transposition2 = *(int8_t *) si++;
 
-        case 0xB6: si++; break;
-        case 0xB5: si += 2; break;
-        case 0xB4: si += 16; break;
+    return si;
+}
 
-        // 4.13. Sound Cut Setting 2, Command 'q [number1][-[number2]] [,number3]' / Command 'q [l length[.]][-[l length]] [,l length[.]]'
-        case 0xB3:
-        {
-            // Set Early Key Off Timeout 2. Stop note after n ticks or earlier depending on the result of B1/C4/FE happening first.
-            channel->_EarlyKeyOffTimeout2 = *si++;
-            break;
-        }
+/// <summary>
+/// 4.13. Sound Cut Setting 2, Command 'q [number1][-[number2]] [,number3]' / Command 'q [l length[.]][-[l length]] [,l length[.]]'
+/// </summary>
+template<> uint8_t * pmd_driver_t::CommonCommand<0xB1>(channel_t * channel, uint8_t * si)
+{
+    // Set Early Key Off Timeout Randomizer Range. (0..tt ticks, added to the value of command C4 and FE)
+    channel->EarlyKeyOffTimeoutRandomRange = *si++;
 
-        // 4.16. Master Modulation Setting, Default global transpose, at the beginning of all channels except the rhythm channel, Command '_M number'
-        case 0xB2:
-        {
-            channel->Transposition2 = *(int8_t *) si++;
-            break;
-        }
+    return si;
+}
 
-        // 4.13. Sound Cut Setting 2, Command 'q [number1][-[number2]] [,number3]' / Command 'q [l length[.]][-[l length]] [,l length[.]]'
-        case 0xB1:
-        {
-            // Set Early Key Off Timeout Randomizer Range. (0..tt ticks, added to the value of command C4 and FE)
-            channel->EarlyKeyOffTimeoutRandomRange = *si++;
-            break;
-        }
+/// <summary>
+/// Creates a command table. It starts with the handlers of the commands that execute the same for all sound sources and applies the specified handlers of a sound source on top.
+/// </summary>
+pmd_driver_t::command_table_t pmd_driver_t::CreateCommandTable(std::initializer_list<std::pair<uint8_t, command_handler_t>> handlers) noexcept
+{
+    static const std::pair<uint8_t, command_handler_t> CommonHandlers[] =
+    {
+        { 0xFF, &pmd_driver_t::SkipCommand<1> },
+        { 0xFE, &pmd_driver_t::SkipCommand<1> },
+        { 0xFD, &pmd_driver_t::CommonCommand<0xFD> },
+        { 0xFC, &pmd_driver_t::CommonCommand<0xFC> },
+        { 0xFB, &pmd_driver_t::CommonCommand<0xFB> },
+        { 0xFA, &pmd_driver_t::CommonCommand<0xFA> },
+        { 0xF9, &pmd_driver_t::SetStartOfLoopCommand }, // 10.1. Local Loop Setting, Start loop, Command '['
+        { 0xF8, &pmd_driver_t::SetEndOfLoopCommand }, // 10.1. Local Loop Setting, End loop, Command ']'
+        { 0xF7, &pmd_driver_t::ExitLoopCommand }, // 10.1. Local Loop Setting, Exit loop, Command ':'
+        { 0xF6, &pmd_driver_t::CommonCommand<0xF6> },
+        { 0xF5, &pmd_driver_t::CommonCommand<0xF5> },
+        { 0xF4, &pmd_driver_t::CommonCommand<0xF4> },
+        { 0xF3, &pmd_driver_t::CommonCommand<0xF3> },
+        { 0xF2, &pmd_driver_t::LFO1SetModulation }, // 9.1. Software LFO Setting, Set software LFO 1, Command 'MA number1, number2, number3, number4'
+        { 0xF1, &pmd_driver_t::LFO1SetSwitch }, // 9.3. Software LFO Switch, Controls on/off and keyon synchronization of the software LFO, Command '*A number'
+        { 0xF0, &pmd_driver_t::SSGSetEnvelope1 }, // 8.1. SSG/PCM Software Envelope Setting, Sets a software envelope (only for OPN/OPNA's SSG/ADPCM channels), Command 'E number1, number2, number3, number4'
+        { 0xEB, &pmd_driver_t::CommonCommand<0xEB> },
+        { 0xEA, &pmd_driver_t::CommonCommand<0xEA> },
+        { 0xE9, &pmd_driver_t::CommonCommand<0xE9> },
+        { 0xE8, &pmd_driver_t::CommonCommand<0xE8> },
+        { 0xE7, &pmd_driver_t::CommonCommand<0xE7> },
+        { 0xE6, &pmd_driver_t::CommonCommand<0xE6> },
+        { 0xE5, &pmd_driver_t::CommonCommand<0xE5> },
+        { 0xE4, &pmd_driver_t::SkipCommand<1> },
+        { 0xE1, &pmd_driver_t::SkipCommand<1> },
+        { 0xE0, &pmd_driver_t::SkipCommand<1> },
+        { 0xDF, &pmd_driver_t::CommonCommand<0xDF> },
+        { 0xDD, &pmd_driver_t::DecreaseVolumeForNextNote }, // 5.5. Relative Volume Change, Command '( ^%number'
+        { 0xDC, &pmd_driver_t::CommonCommand<0xDC> },
+        { 0xDB, &pmd_driver_t::CommonCommand<0xDB> },
+        { 0xD9, &pmd_driver_t::SkipCommand<1> },
+        { 0xD8, &pmd_driver_t::SkipCommand<1> },
+        { 0xD7, &pmd_driver_t::SkipCommand<1> },
+        { 0xD6, &pmd_driver_t::CommonCommand<0xD6> },
+        { 0xD5, &pmd_driver_t::CommonCommand<0xD5> },
+        { 0xD4, &pmd_driver_t::SetSSGEffect }, // 15.5. SSG Sound Effect Playback, Play SSG sound effect, Command 'n number'
+        { 0xD3, &pmd_driver_t::SetFMEffect }, // 15.5. FM Sound Effect Playback, Play FM sound effect, Command 'N number'
+        { 0xD2, &pmd_driver_t::CommonCommand<0xD2> },
+        { 0xD1, &pmd_driver_t::SkipCommand<1> },
+        { 0xD0, &pmd_driver_t::SkipCommand<1> },
+        { 0xCF, &pmd_driver_t::SkipCommand<1> },
+        { 0xCE, &pmd_driver_t::SkipCommand<6> },
+        { 0xCD, &pmd_driver_t::SSGSetEnvelope2 }, // 8.1. SSG/PCM Software Envelope Setting, Sets a software envelope (only for OPN/OPNA's SSG/ADPCM channels), Command 'E number1, number2, number3, number4, number5, number6'
+        { 0xCC, &pmd_driver_t::SkipCommand<1> },
+        { 0xCB, &pmd_driver_t::CommonCommand<0xCB> },
+        { 0xCA, &pmd_driver_t::CommonCommand<0xCA> },
+        { 0xC8, &pmd_driver_t::SkipCommand<3> },
+        { 0xC7, &pmd_driver_t::SkipCommand<3> },
+        { 0xC6, &pmd_driver_t::SkipCommand<6> },
+        { 0xC5, &pmd_driver_t::SkipCommand<1> },
+        { 0xC4, &pmd_driver_t::CommonCommand<0xC4> },
+        { 0xC2, &pmd_driver_t::CommonCommand<0xC2> },
+        { 0xC1, &pmd_driver_t::SkipCommand<0> }, // 4.10. Tie/Slur Setting, Connects the sound before and after as a slur (&&). Keyoff will be done on the previous note.
+        { 0xBF, &pmd_driver_t::CommonCommand<0xBF> },
+        { 0xBD, &pmd_driver_t::CommonCommand<0xBD> },
+        { 0xBC, &pmd_driver_t::CommonCommand<0xBC> },
+        { 0xBB, &pmd_driver_t::CommonCommand<0xBB> },
+        { 0xBA, &pmd_driver_t::SkipCommand<1> },
+        { 0xB9, &pmd_driver_t::CommonCommand<0xB9> },
+        { 0xB8, &pmd_driver_t::SkipCommand<2> },
+        { 0xB7, &pmd_driver_t::CommonCommand<0xB7> },
+        { 0xB6, &pmd_driver_t::SkipCommand<1> },
+        { 0xB5, &pmd_driver_t::SkipCommand<2> },
+        { 0xB4, &pmd_driver_t::SkipCommand<16> },
+        { 0xB3, &pmd_driver_t::CommonCommand<0xB3> },
+        { 0xB2, &pmd_driver_t::CommonCommand<0xB2> },
+        { 0xB1, &pmd_driver_t::CommonCommand<0xB1> },
+    };
+
+    command_table_t Table;
+
+    Table.fill(&pmd_driver_t::UnknownCommand);
+
+    for (const auto & [ Command, Handler ] : CommonHandlers)
+        Table[Command] = Handler;
+
+    for (const auto & [ Command, Handler ] : handlers)
+        Table[Command] = Handler;
+
+    return Table;
+}
 
-        default:
-            si--;
-            *si = 0x80;
-    }
+/// <summary>
+/// Ends the part on an unknown command by replacing the command with an end-of-part marker.
+/// </summary>
+uint8_t * pmd_driver_t::UnknownCommand(channel_t *, uint8_t * si)
+{
+    si--;
+    *si = 0x80;
 
     return si;
 }
@@ -1898,6 +2320,9 @@ uint8_t * pmd_driver_t::SetTempoCommand(uint8_t * si)
         ConvertMetronomeTempoToTimerBTempo();
     }
 
+    if (_Events != nullptr)
+        RecordEvent(EventSong, event_type_t::Tempo, _State._MetronomeTempo);
+
     return si;
 }
 
@@ -2351,6 +2776,30 @@ void pmd_driver_t::InitializeChannels()
         if (Offsets[0] != sizeof(uint16_t) * MaxParts) // 0x0018
             _State._InstrumentData = _State._MData + Offsets[12];
     }
+
+    BuildInstrumentIndex();
+}
+
+/// <summary>
+/// Indexes the FM instrument definitions of the song by instrument number. Each definition is a number followed by 25 bytes of data. The first definition with a number wins.
+/// </summary>
+void pmd_driver_t::BuildInstrumentIndex() noexcept
+{
+    ::memset(_State._InstrumentIndex, 0, sizeof(_State._InstrumentIndex));
+
+    if (_State._InstrumentData == nullptr)
+        return;
+
+    const uint8_t * Tail = _MData + sizeof(_MData) - 26;
+
+    for (uint8_t * Data = _State._InstrumentData; Data < _MData + sizeof(_MData); Data += 26)
+    {
+        if ((Data > Tail) && (Data != _State._InstrumentData))
+            break;
+
+        if (_State._InstrumentIndex[Data[0]] == nullptr)
+            _State._InstrumentIndex[Data[0]] = Data + 1;
+    }
 }
 
 /// <summary>
@@ -2606,19 +3055,35 @@ void pmd_driver_t::WritePCMData(uint16_t startAddress, uint16_t stopAddress, con
 }
 
 /// <summary>
-/// Finds a PCM sample in the specified search path.
+/// Finds a PCM sample in the specified search path. The search paths are looked up in a cached directory index instead of probing the file system for every path.
 /// </summary>
 void pmd_driver_t::FindFile(const WCHAR * filename, WCHAR * filePath, size_t size) const noexcept
 {
     filePath[0] = '\0';
 
+    // Files in a mounted bundle take precedence and don't require any file system access. The path of the entry is returned so the file can be found again, e.g. when the song is packed again.
+    if (_File->GetBundle() != nullptr)
+    {
+        const uint8_t * Data;
+        size_t Size;
+        const WCHAR * Name;
+
+        if (_File->GetBundle()->Find(filename, Data, Size, &Name) && (Size > 0))
+        {
+            ::wcscpy_s(filePath, size, Name);
+
+            return;
+        }
+    }
+
     WCHAR FilePath[MAX_PATH];
 
-    for (size_t i = 0; i < _SearchPath.size(); ++i)
+    for (const auto & SearchPath : _SearchPath)
     {
-        CombinePath(FilePath, _countof(FilePath), _SearchPath[i].c_str(), filename);
+        if (directory_index_t::GetFileSize(SearchPath, filename) <= 0)
+            continue;
 
-        if (_File->GetFileSize(FilePath) > 0)
+        if (CombinePath(FilePath, _countof(FilePath), SearchPath.c_str(), filename))
             ::wcscpy_s(filePath, size, FilePath);
     }
 }
@@ -1,11 +1,16 @@
 
-/** $VER: PMDDriver.h (2026.01.07) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
+/** $VER: PMDDriver.h (2026.10.19) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
 
 #pragma once
 
 #include <pch.h>
 
+#include <array>
+#include <initializer_list>
+#include <utility>
+
 #include "Driver.h"
+#include "Bundle.h"
 
 #include "OPNAW.h"
 
@@ -15,6 +20,7 @@
 
 #include "State.h"
 #include "Effect.h"
+#include "Event.h"
 
 typedef int32_t sample_t;
 
@@ -27,8 +33,48 @@ struct sample_bank_t
 };
 #pragma pack(pop)
 
+/// <summary>
+/// Identifies the stems rendered by pmd_driver_t::RenderStems().
+/// </summary>
+enum stem_t
+{
+    StemFM1, StemFM2, StemFM3, StemFM4, StemFM5, StemFM6,   // FM 3 includes the FM3 extension parts.
+    StemSSG1, StemSSG2, StemSSG3,
+    StemADPCM,                                              // ADPCM and P86
+    StemRhythm,
+    StemPPZ1, StemPPZ2, StemPPZ3, StemPPZ4, StemPPZ5, StemPPZ6, StemPPZ7, StemPPZ8,
+    StemPPS,
+
+    StemCount
+};
+
 #pragma warning(disable: 4820) // x bytes padding added after last data member
 
+/// <summary>
+/// Describes the sound sources and chip channels a song can ever use. Determined once when the song is loaded.
+/// </summary>
+struct source_usage_t
+{
+    uint32_t FMChannels;        // Bit mask of FM channel 1-6
+    uint32_t SSGChannels;       // Bit mask of SSG channel 1-3
+
+    bool UsesFMExtension;       // FM3 extension parts
+    bool UsesADPCM;             // ADPCM or P86 part
+    bool UsesSSGEffects;        // SSG effects and SSG or PPS drums
+    bool UsesPPZ8;              // PPZ8 parts
+
+    void SetAll() noexcept
+    {
+        FMChannels = 0x3F;
+        SSGChannels = 0x07;
+
+        UsesFMExtension = true;
+        UsesADPCM = true;
+        UsesSSGEffects = true;
+        UsesPPZ8 = true;
+    }
+};
+
 class pmd_driver_t
 {
 public:
@@ -39,16 +85,25 @@ public:
 
     static bool IsPMD(const uint8_t * data, size_t size) noexcept;
 
-    int32_t Load(const uint8_t * data, size_t size) noexcept;
+    int32_t Load(const uint8_t * data, size_t size, size_t songIndex = 0) noexcept;
 
     void Start() noexcept;
     void Stop() noexcept;
 
     void Render(int16_t * sampleData, size_t sampleCount) noexcept;
+    bool RenderStems(int16_t * const * stemData, size_t sampleCount) noexcept;
 
     uint32_t GetLoopNumber() const noexcept;
 
     bool GetLength(uint32_t & songLength, uint32_t & loopLength, uint32_t & songTicks, uint32_t & loopTicks) noexcept;
+    bool GetEvents(std::vector<event_t> & events, uint32_t loopCount);
+    bool CompileRegisterLog(register_log_t & log);
+
+    // Writes a compiled register log as a VGM file, including the contents of the ADPCM RAM.
+    bool WriteVGM(const register_log_t & log, const WCHAR * filePath) const
+    {
+        return log.WriteVGM(filePath, OPNAClock, _OPNAW->GetADPCMRAM());
+    }
 
     uint32_t GetPosition() const noexcept;
     void SetPosition(uint32_t position);
@@ -60,8 +115,6 @@ public:
     
     void SetSampleRate(uint32_t value) noexcept;
     void SetInterpolation(bool flag);
-
-    void SetPPZSampleRate(uint32_t value) noexcept;
     void SetPPZInterpolation(bool flag);
 
     void SetFadeOutSpeed(int speed);
@@ -132,6 +185,29 @@ public:
         return _IsPlaying;
     }
 
+    // Gets the error that aborted the song, if any.
+    int32_t GetErrorCode() const noexcept
+    {
+        return _ErrorCode;
+    }
+
+    // Gets the largest number of commands executed in a single tick since the song was started.
+    uint32_t GetPeakCommandCount() const noexcept
+    {
+        return _PeakCommandCount;
+    }
+
+    // Gets the number of commands executed since the song was started.
+    uint64_t GetTotalCommandCount() const noexcept
+    {
+        return _TotalCommandCount;
+    }
+
+    static const uint32_t MaxCommandsPerTick = 0x10000;     // Number of commands all parts may execute in a single tick
+    static const uint64_t MaxCommandsPerSong = 0x2000000;   // Number of commands GetLength() may execute
+
+    static const uint8_t DummyChannelNumber = 14;           // Number of the unused channel (see GetChannel())
+
     bool GetMemo(const uint8_t * data, size_t size, int al, char * text, size_t textSize);
 
     channel_t * GetChannel(int channelNumber) const noexcept;
@@ -143,19 +219,58 @@ private:
     void InitializeOPNA();
 
     void DriverMain() noexcept;
+    void BuildPartTable() noexcept;
+    bool CountCommand() noexcept;
+
+    void SetRegisterLog(register_log_t * log) noexcept;
+    template<typename Predicate> void Seek(bool restart, Predicate isBeforeTarget);
+
+    void RecordEvent(uint8_t channelNumber, event_type_t type, int32_t value);
+    void RecordKeyOn(const channel_t * channel, int32_t value);
+    void RecordKeyOff(const channel_t * channel);
+    uint8_t GetChannelNumber(const channel_t * channel) const noexcept;
     void DriverStart() noexcept;
     void DriverStop() noexcept;
 
-    uint8_t * ExecuteCommand(channel_t * channel, uint8_t * si, uint8_t command);
+    // Executes a command of a part. Indexed by command byte; the handler receives the operands and returns the position after them.
+    using command_handler_t = uint8_t * (pmd_driver_t::*)(channel_t * channel, uint8_t * si);
+    using command_table_t = std::array<command_handler_t, 256>;
+
+    static command_table_t CreateCommandTable(std::initializer_list<std::pair<uint8_t, command_handler_t>> handlers) noexcept;
+
+    template<uint8_t command> uint8_t * CommonCommand(channel_t * channel, uint8_t * si);
+    uint8_t * UnknownCommand(channel_t * channel, uint8_t * si);
+
+    // Skips the operands of a command that has no effect on a sound source.
+    template<size_t operandSize> uint8_t * SkipCommand(channel_t *, uint8_t * si) noexcept
+    {
+        return si + operandSize;
+    }
 
     void Mute();
+    void UpdateChannelMask() noexcept;
+    bool AnalyzeSourceUsage(size_t size) noexcept;
     void InitializeChannels();
+    void BuildInstrumentIndex() noexcept;
     void InitializeTimers();
     void ConvertTimerBTempoToMetronomeTempo();
     void ConvertMetronomeTempoToTimerBTempo();
     void SetTimerBTempo();
     void HandleTimerAInterrupt();
     void HandleTimerBInterrupt();
+    uint32_t ProcessTimers() noexcept;
+    size_t AdvancePosition(uint32_t clockCount) noexcept;
+
+    // Converts a number of OPNA clocks to ms.
+    static int64_t ClocksToMs(int64_t clocks) noexcept
+    {
+        return clocks * 1'000 / OPNAClock;
+    }
+
+    void RenderStemsTick() noexcept;
+    int32_t GetFadeOutFactor() noexcept;
+    static void ConvertFrames(const frame32_t * srcFrames, frame16_t * dstFrames, size_t frameCount, int32_t factor) noexcept;
+
     void IncreaseBarCounter();
 
     void GetText(const uint8_t * data, size_t size, int al, char * text, size_t max) const noexcept;
@@ -167,6 +282,7 @@ private:
     void FMMain(channel_t * channel) noexcept;
 
     uint8_t * FMExecuteCommand(channel_t * channel, uint8_t * si);
+    template<uint8_t command> uint8_t * FMCommand(channel_t * channel, uint8_t * si);
 
     void FMKeyOn(channel_t * channel);
     void FMKeyOff(channel_t * channel);
@@ -209,6 +325,7 @@ private:
     void SSGMain(channel_t * channel);
 
     uint8_t * SSGExecuteCommand(channel_t * channel, uint8_t * si);
+    template<uint8_t command> uint8_t * SSGCommand(channel_t * channel, uint8_t * si);
     uint8_t * SSGDecreaseVolume(channel_t * channel, uint8_t * si);
     uint8_t * SSGSetEnvelope1(channel_t * channel, uint8_t * si);
     uint8_t * SSGSetEnvelope2(channel_t * channel, uint8_t * si);
@@ -232,6 +349,7 @@ private:
     void ADPCMMain(channel_t * channel);
 
     uint8_t * ADPCMExecuteCommand(channel_t * channel, uint8_t * si);
+    template<uint8_t command> uint8_t * ADPCMCommand(channel_t * channel, uint8_t * si);
     uint8_t * ADPCMDecreaseVolume(channel_t * channel, uint8_t * si);
     uint8_t * ADPCMSetInstrument(channel_t * channel, uint8_t * si);
     uint8_t * ADPCMSetPortamento(channel_t * channel, uint8_t * si);
@@ -253,11 +371,12 @@ private:
     void RhythmMain(channel_t * channel);
 
     uint8_t * RhythmExecuteCommand(channel_t * channel, uint8_t * si);
+    template<uint8_t command> uint8_t * RhythmCommand(channel_t * channel, uint8_t * si);
     uint8_t * RhythmDecreaseVolume(channel_t * channel, uint8_t * si);
     uint8_t * RhythmSetChannelMask(channel_t * channel, uint8_t * si) noexcept;
     uint8_t * RhythmKeyOn(channel_t * channel, int32_t note, uint8_t * rhythmData, bool * success) noexcept;
 
-    uint8_t * RhythmControl(uint8_t * si);
+    uint8_t * RhythmControl(channel_t * channel, uint8_t * si);
     uint8_t * RhythmSetVolume(uint8_t * si);
     uint8_t * RhythmSetPan(uint8_t * si);
     uint8_t * RhythmSetMasterVolume(uint8_t * si);
@@ -271,6 +390,7 @@ private:
     void P86Main(channel_t * channel);
 
     uint8_t * P86ExecuteCommand(channel_t * channel, uint8_t * si);
+    template<uint8_t command> uint8_t * P86Command(channel_t * channel, uint8_t * si);
     uint8_t * P86SetInstrument(channel_t * channel, uint8_t * si);
     uint8_t * P86SetRepeat(channel_t * channel, uint8_t * si);
     uint8_t * P86SetPan1(channel_t * channel, uint8_t * si);
@@ -292,6 +412,7 @@ private:
     uint8_t * PPZ8Initialize(channel_t * channel, uint8_t * si);
 
     uint8_t * PPZ8ExecuteCommand(channel_t * channel, uint8_t * si);
+    template<uint8_t command> uint8_t * PPZ8Command(channel_t * channel, uint8_t * si);
     uint8_t * PPZ8DecreaseVolume(channel_t * channel, uint8_t * si);
     uint8_t * PPZ8SethannelMask(channel_t * channel, uint8_t * si) noexcept;
     uint8_t * PPZ8SetInstrument(channel_t * channel, uint8_t * si);
@@ -388,6 +509,9 @@ private:
     void Fade();
 
 private:
+    int32_t LoadInternal(const uint8_t * data, size_t size) noexcept;
+    static bool HasValidPartOffsets(const uint8_t * data, size_t size) noexcept;
+
     int LoadPPC(const WCHAR * filename);
     int LoadPPCInternal(uint8_t * data, size_t size) noexcept;
 
@@ -407,8 +531,9 @@ private:
     bool _UsePPSForDrums;           // Use the PPS to play drum instruments for the K/R commands.
     bool _UseSSGForDrums;           // Use the SSG to play drum instruments for the K/R commands.
 
+    source_usage_t _Usage;          // Sound sources and channels used by the loaded song
+
     uint32_t _PCMSampleRate;        // PCM output frequency (11k, 22k, 44k, 55k)
-    uint32_t _PPZSampleRate;        // PPZ output frequency
 
     bool _UseInterpolation;
 
@@ -420,6 +545,13 @@ private:
 
     static const uint8_t _DummyRhythmData = 0xFF;
 
+    static const command_table_t _FMCommands;       // Command handlers of each sound source, indexed by command byte
+    static const command_table_t _SSGCommands;
+    static const command_table_t _ADPCMCommands;
+    static const command_table_t _RhythmCommands;
+    static const command_table_t _P86Commands;
+    static const command_table_t _PPZ8Commands;
+
     uint8_t _Version;               // File version. 0x00 for standard .M or .M2 files targeting PC-98/PC-88/X68000 systems, Must be 0xFF for files targeting FM Towns hardware.
 
     state_t _State;
@@ -440,6 +572,40 @@ private:
 
     channel_t _DummyChannel;
 
+    /// <summary>
+    /// Binds a part to the main function of its sound source.
+    /// </summary>
+    struct part_t
+    {
+        void (pmd_driver_t::* Main)(channel_t * channel);
+        channel_t * Channel;
+        int32_t ChannelNumber;      // Value of _Driver._CurrentChannel while the part is processed
+        int32_t FMSelector;         // Value of _Driver._FMSelector while the part is processed
+    };
+
+    part_t _Parts[MaxSSGChannels + MaxFMChannels + MaxFMExtensionChannels + 2 + MaxPPZ8Channels];
+    size_t _PartCount;
+
+    uint32_t _CommandCount;         // Number of commands executed in the current tick
+    uint32_t _PeakCommandCount;     // Largest number of commands executed in a single tick
+    uint64_t _TotalCommandCount;    // Number of commands executed since the driver was started
+    int32_t _ErrorCode;             // ERR_COMMAND_LIMIT or ERR_SIMULATION_LIMIT if the song was aborted
+
+    /// <summary>
+    /// The last instrument and volume reported for a channel by GetEvents().
+    /// </summary>
+    struct event_state_t
+    {
+        int32_t InstrumentNumber;
+        int32_t Volume;
+        bool IsKeyOn;
+    };
+
+    register_log_t _SeekLog;        // Receives the register writes and PCM driver calls while seeking
+
+    std::vector<event_t> * _Events; // Receives the events while GetEvents() runs the driver; nullptr otherwise
+    event_state_t _EventStates[MaxChannels];
+
     int32_t _FMSlotKey1[3];
     int32_t _FMSlotKey2[3];
 
@@ -447,7 +613,9 @@ private:
 
     frame16_t _SrcFrames[MaxFrames];
     frame32_t _DstFrames[MaxFrames];
-    frame32_t _TmpFrames[MaxFrames];
+
+    std::vector<frame16_t> _StemFrames;     // StemCount buffers of MaxFrames frames, allocated by the first call to RenderStems()
+    std::vector<frame32_t> _StemMixFrames;  // StemCount buffers of MaxFrames frames
 
     uint8_t _MData[64 * 1024];      // Contents of the .M or .M2 file
     uint8_t _VData[ 8 * 1024];
@@ -482,8 +650,9 @@ private:
 
     frame16_t * _FramePtr;
     size_t _FramesToDo;
+    bool _IsRenderingStems;         // True if _FramePtr and _FramesToDo refer to the stem buffers of RenderStems() instead of _SrcFrames
 
-    int64_t _Position;              // Time from start of playing (in μs)
+    int64_t _Position;              // Time from start of playing (in OPNA clocks)
     int64_t _FadeOutPosition;       // SetFadeOutDurationHQ start time
     int32_t _Seed;                  // Random seed
 
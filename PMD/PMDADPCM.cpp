@@ -1,5 +1,5 @@
 
-/** $VER: PMDADPCM.cpp (2026.01.07) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
+/** $VER: PMDADPCM.cpp (2026.10.19) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
 
 #include <pch.h>
 
@@ -45,6 +45,12 @@ void pmd_driver_t::ADPCMMain(channel_t * channel)
         {
             if ((*si != 0xDA) && (*si > 0x80))
             {
+                if (!CountCommand())
+                {
+                    channel->_Data = si;
+                    return;
+                }
+
                 si = ADPCMExecuteCommand(channel, si);
             }
             else
@@ -191,121 +197,97 @@ uint8_t * pmd_driver_t::ADPCMExecuteCommand(channel_t * channel, uint8_t * si)
 {
     const uint8_t Command = *si++;
 
-    switch (Command)
-    {
-        // 6.1. Instrument Number Setting, Command '@[@] insnum' / Command '@[@] insnum[,number1[,number2[,number3]]]'
-        case 0xFF:
-        {
-            si = ADPCMSetInstrument(channel, si);
-            break;
-        }
-
-        // 4.12. Sound Cut Setting 1, Command 'Q [%] numerical value' / 4.13. Sound Cut Setting 2, Command 'q [number1][-[number2]] [,number3]' / Command 'q [l length[.]][-[l length]] [,l length[.]]'
-        case 0xFE:
-        {
-            channel->_EarlyKeyOffTimeout1 = *si++;
-            break;
-        }
-
-        // 15.1. FM Chip Direct Output, Direct register write. Writes val to address reg of the YM2608's internal memory, Command 'y number1, number2'
-        case 0xEF:
-        {
-            _OPNAW->SetReg((uint32_t) (0x100 + si[0]), si[1]);
-            si += 2;
-            break;
-        }
-
-        case 0xEE: si++; break;
-        case 0xED: si++; break;
-
-        // 13.1. Pan setting 1
-        case 0xEC:
-            si = ADPCMSetPan1(channel, si);
-            break;
-
-        // 5.5. Relative Volume Change, Command ') %number'
-        case 0xE3:
-        {
-            channel->_Volume += *si++;
+    return (this->*_ADPCMCommands[Command])(channel, si);
+}
 
-            if (channel->_Volume > 255)
-                channel->_Volume = 255;
-            break;
-        }
+/// <summary>
+/// 4.12. Sound Cut Setting 1, Command 'Q [%] numerical value' / 4.13. Sound Cut Setting 2, Command 'q [number1][-[number2]] [,number3]' / Command 'q [l length[.]][-[l length]] [,l length[.]]'
+/// </summary>
+template<> uint8_t * pmd_driver_t::ADPCMCommand<0xFE>(channel_t * channel, uint8_t * si)
+{
+    channel->_EarlyKeyOffTimeout1 = *si++;
 
-        // 5.5. Relative Volume Change, Command '( %number'
-        case 0xE2:
-        {
-            channel->_Volume -= *si++;
+    return si;
+}
 
-            if (channel->_Volume < 0)
-                channel->_Volume = 0;
-            break;
-        }
+/// <summary>
+/// 15.1. FM Chip Direct Output, Direct register write. Writes val to address reg of the YM2608's internal memory, Command 'y number1, number2'
+/// </summary>
+template<> uint8_t * pmd_driver_t::ADPCMCommand<0xEF>(channel_t *, uint8_t * si)
+{
+    _OPNAW->SetReg((uint32_t) (0x100 + si[0]), si[1]);
+    si += 2;
 
-        // 5.5. Relative Volume Change, Command ') ^%number'
-        case 0xDE:
-        {
-            si = IncreaseVolumeForNextNote(channel, si, 255);
-            break;
-        }
+    return si;
+}
 
-        // 4.3. Portamento Setting
-        case 0xDA:
-        {
-            si = ADPCMSetPortamento(channel, si);
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Command ') %number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::ADPCMCommand<0xE3>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume += *si++;
 
-        // 6.1.5. Instrument Number Setting/PCM Channels Case, Set PCM Repeat.
-        case 0xCE:
-        {
-            si = ADPCMSetRepeat(channel, si);
-            break;
-        }
+    if (channel->_Volume > 255)
+        channel->_Volume = 255;
 
-        // 8.2. Software Envelope Speed Setting, Set SSG Extend Mode (bit 2), Command 'EX number'
-        case 0xC9:
-        {
-            channel->_ExtendMode = (channel->_ExtendMode & 0xFB) | ((*si++ & 0x01) << 2);
-            break;
-        }
+    return si;
+}
 
-        // 13.2. Pan Setting 2
-        case 0xC3:
-        {
-            si = ADPCMSetPan2(channel, si);
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Command '( %number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::ADPCMCommand<0xE2>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume -= *si++;
 
-        // 15.7. Channel Mask Control, Sets the channel mask to on or off, Command 'm number'
-        case 0xC0:
-        {
-            si = ADPCMSetChannelMask(channel, si);
-            break;
-        }
+    if (channel->_Volume < 0)
+        channel->_Volume = 0;
 
-        // 9.3. Software LFO Switch, Controls on/off and keyon synchronization of the software LFO, Command '*B number'
-        case 0xBE:
-        {
-            si = LFO2SetSwitch(channel, si);
-            break;
-        }
+    return si;
+}
 
-        // 2.25. PPZ8 Channel Extension, Extends the PPZ8 channels with the notated channels, Command '#PPZExtend notation1[notation2[notation3]... (up to 8)]]'
-        case 0xB4:
-        {
-            si = PPZ8Initialize(channel, si);
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Command ') ^%number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::ADPCMCommand<0xDE>(channel_t * channel, uint8_t * si)
+{
+    return IncreaseVolumeForNextNote(channel, si, 255);
+}
 
-        default:
-            si = ExecuteCommand(channel, si, Command);
-    }
+/// <summary>
+/// 8.2. Software Envelope Speed Setting, Set SSG Extend Mode (bit 2), Command 'EX number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::ADPCMCommand<0xC9>(channel_t * channel, uint8_t * si)
+{
+    channel->_ExtendMode = (channel->_ExtendMode & 0xFB) | ((*si++ & 0x01) << 2);
 
     return si;
 }
 
+/// <summary>
+/// The handlers of the ADPCM commands, indexed by command byte. The other commands are executed like on every sound source.
+/// </summary>
+const pmd_driver_t::command_table_t pmd_driver_t::_ADPCMCommands = pmd_driver_t::CreateCommandTable(
+{
+    { 0xFF, &pmd_driver_t::ADPCMSetInstrument }, // 6.1. Instrument Number Setting, Command '@[@] insnum' / Command '@[@] insnum[,number1[,number2[,number3]]]'
+    { 0xFE, &pmd_driver_t::ADPCMCommand<0xFE> },
+    { 0xEF, &pmd_driver_t::ADPCMCommand<0xEF> },
+    { 0xEE, &pmd_driver_t::SkipCommand<1> },
+    { 0xED, &pmd_driver_t::SkipCommand<1> },
+    { 0xEC, &pmd_driver_t::ADPCMSetPan1 }, // 13.1. Pan setting 1
+    { 0xE3, &pmd_driver_t::ADPCMCommand<0xE3> },
+    { 0xE2, &pmd_driver_t::ADPCMCommand<0xE2> },
+    { 0xDE, &pmd_driver_t::ADPCMCommand<0xDE> },
+    { 0xDA, &pmd_driver_t::ADPCMSetPortamento }, // 4.3. Portamento Setting
+    { 0xCE, &pmd_driver_t::ADPCMSetRepeat }, // 6.1.5. Instrument Number Setting/PCM Channels Case, Set PCM Repeat.
+    { 0xC9, &pmd_driver_t::ADPCMCommand<0xC9> },
+    { 0xC3, &pmd_driver_t::ADPCMSetPan2 }, // 13.2. Pan Setting 2
+    { 0xC0, &pmd_driver_t::ADPCMSetChannelMask }, // 15.7. Channel Mask Control, Sets the channel mask to on or off, Command 'm number'
+    { 0xBE, &pmd_driver_t::LFO2SetSwitch }, // 9.3. Software LFO Switch, Controls on/off and keyon synchronization of the software LFO, Command '*B number'
+    { 0xB4, &pmd_driver_t::PPZ8Initialize }, // 2.25. PPZ8 Channel Extension, Extends the PPZ8 channels with the notated channels, Command '#PPZExtend notation1[notation2[notation3]... (up to 8)]]'
+});
+
 /// <summary>
 ///
 /// </summary>
@@ -492,6 +474,9 @@ void pmd_driver_t::ADPCMKeyOn(channel_t * channel)
     if (channel->_Tone == 0xFF)
         return;
 
+    if (_Events != nullptr)
+        RecordKeyOn(channel, channel->_Tone);
+
     _OPNAW->SetReg(0x101, 0x02); // Set ADPCM Control 2: PAN UNSET / x8 bit mode
     _OPNAW->SetReg(0x100, 0x21); // Set ADPCM Control 1
 
@@ -0,0 +1,122 @@
+
+/** $VER: PMDEvents.cpp (2026.10.19) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
+
+#include <pch.h>
+
+#include "PMD.h"
+
+/// <summary>
+/// Runs the driver without synthesizing audio and collects the musical events of all channels until the song has looped the specified number of times, has ended or has been aborted.
+/// Returns false if the song was aborted (see GetErrorCode()).
+/// </summary>
+bool pmd_driver_t::GetEvents(std::vector<event_t> & events, uint32_t loopCount)
+{
+    events.clear();
+
+    DriverStart();
+
+    // Save the original delay values. The wait emulation synthesizes audio while registers are being written.
+    const int32_t FMDelay    = _OPNAW->GetFMDelay();
+    const int32_t SSGDelay   = _OPNAW->GetSSGDelay();
+    const int32_t ADPCMDelay = _OPNAW->GetADPCMDelay();
+    const int32_t RSSDelay   = _OPNAW->GetRSSDelay();
+
+    _OPNAW->SetFMDelay(0);
+    _OPNAW->SetSSGDelay(0);
+    _OPNAW->SetADPCMDelay(0);
+    _OPNAW->SetRhythmDelay(0);
+
+    for (auto & State : _EventStates)
+        State = { -1, -1, false };
+
+    _Events = &events;
+
+    RecordEvent(EventSong, event_type_t::Tempo, _State._MetronomeTempo);
+
+    while ((_ErrorCode == ERR_SUCCESS) && (_State._LoopCount != -1) && ((uint32_t) _State._LoopCount < loopCount) && (GetPositionInTicks() < 65536))
+    {
+        _Position += ProcessTimers();
+
+        if (_TotalCommandCount > MaxCommandsPerSong)
+            _ErrorCode = ERR_SIMULATION_LIMIT;
+    }
+
+    _Events = nullptr;
+
+    DriverStop();
+
+    // Restore the original delay values.
+    _OPNAW->SetFMDelay(FMDelay);
+    _OPNAW->SetSSGDelay(SSGDelay);
+    _OPNAW->SetADPCMDelay(ADPCMDelay);
+    _OPNAW->SetRhythmDelay(RSSDelay);
+
+    return (_ErrorCode == ERR_SUCCESS);
+}
+
+/// <summary>
+/// Adds an event at the current position to the event stream.
+/// </summary>
+void pmd_driver_t::RecordEvent(uint8_t channelNumber, event_type_t type, int32_t value)
+{
+    _Events->push_back({ GetPositionInTicks(), (uint32_t) ClocksToMs(_Position), channelNumber, type, (uint16_t) value });
+}
+
+/// <summary>
+/// Adds a key on event to the event stream, preceded by the instrument and volume of the channel if they changed since its previous key on.
+/// </summary>
+void pmd_driver_t::RecordKeyOn(const channel_t * channel, int32_t value)
+{
+    const uint8_t ChannelNumber = GetChannelNumber(channel);
+
+    auto & State = _EventStates[ChannelNumber];
+
+    if (channel->InstrumentNumber != State.InstrumentNumber)
+    {
+        RecordEvent(ChannelNumber, event_type_t::Instrument, channel->InstrumentNumber);
+
+        State.InstrumentNumber = channel->InstrumentNumber;
+    }
+
+    if (channel->_Volume != State.Volume)
+    {
+        RecordEvent(ChannelNumber, event_type_t::Volume, channel->_Volume);
+
+        State.Volume = channel->_Volume;
+    }
+
+    RecordEvent(ChannelNumber, event_type_t::KeyOn, value);
+
+    State.IsKeyOn = true;
+}
+
+/// <summary>
+/// Adds a key off event to the event stream unless the channel has already been keyed off.
+/// </summary>
+void pmd_driver_t::RecordKeyOff(const channel_t * channel)
+{
+    const uint8_t ChannelNumber = GetChannelNumber(channel);
+
+    auto & State = _EventStates[ChannelNumber];
+
+    if (!State.IsKeyOn)
+        return;
+
+    RecordEvent(ChannelNumber, event_type_t::KeyOff, 0);
+
+    State.IsKeyOn = false;
+}
+
+/// <summary>
+/// Gets the number of the specified channel (see GetChannel()).
+/// </summary>
+uint8_t pmd_driver_t::GetChannelNumber(const channel_t * channel) const noexcept
+{
+    for (size_t i = 0; i < _countof(_State._Channels); ++i)
+    {
+        if (_State._Channels[i] == channel)
+            return (uint8_t) i;
+    }
+
+    return DummyChannelNumber;
+}
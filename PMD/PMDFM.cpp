@@ -1,5 +1,5 @@
 
-/** $VER: PMDFM.cpp (2026.01.07) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
+/** $VER: PMDFM.cpp (2026.10.19) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
 
 #include <pch.h>
 
@@ -46,6 +46,12 @@ void pmd_driver_t::FMMain(channel_t * channel) noexcept
         {
             if ((*si > 0x80) && (*si != 0xDA))
             {
+                if (!CountCommand())
+                {
+                    channel->_Data = si;
+                    return;
+                }
+
                 si = FMExecuteCommand(channel, si);
             }
             else
@@ -222,223 +228,186 @@ uint8_t * pmd_driver_t::FMExecuteCommand(channel_t * channel, uint8_t * si)
 {
     const uint8_t Command = *si++;
 
-    switch (Command)
-    {
-        // 6.1. Instrument Number Setting, Command '@[@] insnum' / Command '@[@] insnum[,number1[,number2[,number3]]]'
-        case 0xFF:
-        {
-            si = SetFMInstrument(channel, si);
-            break;
-        }
-
-        // 4.12. Sound Cut Setting 1, Command 'Q [%] numerical value' / 4.13. Sound Cut Setting 2, Command 'q [number1][-[number2]] [,number3]' / Command 'q [l length[.]][-[l length]] [,l length[.]]'
-        case 0xFE:
-        {
-            channel->_EarlyKeyOffTimeout1 = *si++;
-            channel->EarlyKeyOffTimeoutRandomRange = 0;
-            break;
-        }
-
-        // 5.5. Relative Volume Change, Increase volume by 3dB.
-        case 0xF4:
-        {
-            channel->_Volume += 4;
-
-            if (channel->_Volume > 127)
-                channel->_Volume = 127;
-            break;
-        }
-
-        // 5.5. Relative Volume Change, Decrease volume by 3dB.
-        case 0xF3:
-        {
-            channel->_Volume -= 4;
-
-            if (channel->_Volume < 4)
-                channel->_Volume = 0;
-            break;
-        }
-
-        // 9.3. Software LFO Switch, Controls on/off and keyon synchronization of the software LFO, Command '*A number'
-        case 0xF1:
-        {
-            si = LFO1SetSwitch(channel, si);
-
-            SetFMChannelLFOs(channel);
-            break;
-        }
-
-        case 0xF0: si += 4; break;
+    return (this->*_FMCommands[Command])(channel, si);
+}
 
-        // 15.1. FM Chip Direct Output, Direct register write. Writes val to address reg of the YM2608's internal memory, Command 'y number1, number2'
-        case 0xEF:
-        {
-            _OPNAW->SetReg((uint32_t) (_Driver._FMSelector + si[0]), si[1]);
-            si += 2;
-            break;
-        }
+/// <summary>
+/// 4.12. Sound Cut Setting 1, Command 'Q [%] numerical value' / 4.13. Sound Cut Setting 2, Command 'q [number1][-[number2]] [,number3]' / Command 'q [l length[.]][-[l length]] [,l length[.]]'
+/// </summary>
+template<> uint8_t * pmd_driver_t::FMCommand<0xFE>(channel_t * channel, uint8_t * si)
+{
+    channel->_EarlyKeyOffTimeout1 = *si++;
+    channel->EarlyKeyOffTimeoutRandomRange = 0;
 
-        case 0xEE: si++; break;
-        case 0xED: si++; break;
+    return si;
+}
 
-        // 13.1. Pan setting 1
-        case 0xEC:
-            si = SetFMPan1(channel, si);
-            break;
+/// <summary>
+/// 5.5. Relative Volume Change, Increase volume by 3dB.
+/// </summary>
+template<> uint8_t * pmd_driver_t::FMCommand<0xF4>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume += 4;
 
-        // 9.13. Hardware LFO Delay Setting, Set hardware LFO delay. Command '#D number' / Command '#D l length[.]', Range: (number) 0–255 / (length) 1–255, divisible by the whole note length
-        case 0xE4:
-            channel->_HardwareLFODelay = *si++;
-            break;
+    if (channel->_Volume > 127)
+        channel->_Volume = 127;
 
-        // 5.5. Relative Volume Change, Command ') %number'
-        case 0xE3:
-        {
-            channel->_Volume += *si++;
+    return si;
+}
 
-            if (channel->_Volume > 127)
-                channel->_Volume = 127;
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Decrease volume by 3dB.
+/// </summary>
+template<> uint8_t * pmd_driver_t::FMCommand<0xF3>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume -= 4;
 
-        // 5.5. Relative Volume Change, Command '( %number'
-        case 0xE2:
-        {
-            channel->_Volume -= *si++;
+    if (channel->_Volume < 4)
+        channel->_Volume = 0;
 
-            if (channel->_Volume < 0)
-                channel->_Volume = 0;
-            break;
-        }
+    return si;
+}
 
-        // 9.10. Hardware LFO Speed/Delay Setting, Command 'H number1[, number2]'
-        case 0xE1:
-        {
-            si = SetHardwareLFO_PMS_AMS(channel, si);
-            break;
-        }
+/// <summary>
+/// 9.3. Software LFO Switch, Controls on/off and keyon synchronization of the software LFO, Command '*A number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::FMCommand<0xF1>(channel_t * channel, uint8_t * si)
+{
+    si = LFO1SetSwitch(channel, si);
 
-        // 9.11. Hardware LFO Switch/Depth Setting (OPNA), Command "# number1, [number2]": Sets the hardware LFO on (1) or off (0). (OPNA FM sound source only). Number2 = depth. Can be omitted only when switch is 0.
-        case 0xE0:
-        {
-            // Set the hardware LFO frequency (Speed) (LFO FREQ CONTROL, 0: 3.98 Hz, 1: 5.56 Hz, 2: 6.02 Hz, 3: 6.37 Hz, 4: 6.88 Hz, 5: 9.63 Hz, 6: 48.1 Hz, 7: 72.2 Hz)
-            _OPNAW->SetReg(0x22, *si++);
-            break;
-        }
+    SetFMChannelLFOs(channel);
 
-        // 5.5. Relative Volume Change, Command ') ^%number'
-        case 0xDE:
-        {
-            si = IncreaseVolumeForNextNote(channel, si, 128);
-            break;
-        }
+    return si;
+}
 
-        // 4.3. Portamento Setting
-        case 0xDA:
-        {
-            si = SetFMPortamentoCommand(channel, si);
-            break;
-        }
+/// <summary>
+/// 15.1. FM Chip Direct Output, Direct register write. Writes val to address reg of the YM2608's internal memory, Command 'y number1, number2'
+/// </summary>
+template<> uint8_t * pmd_driver_t::FMCommand<0xEF>(channel_t *, uint8_t * si)
+{
+    _OPNAW->SetReg((uint32_t) (_Driver._FMSelector + si[0]), si[1]);
+    si += 2;
 
-        // 6.2. FM Slot Use Setting, Specifies the slot position (operators) to be used for performance/definition, Command 's number'
-        case 0xCF:
-        {
-            si = SetFMSlotCommand(channel, si);
-            break;
-        }
+    return si;
+}
 
-        case 0xCD: si += 5; break;
+/// <summary>
+/// 9.13. Hardware LFO Delay Setting, Set hardware LFO delay. Command '#D number' / Command '#D l length[.]', Range: (number) 0–255 / (length) 1–255, divisible by the whole note length
+/// </summary>
+template<> uint8_t * pmd_driver_t::FMCommand<0xE4>(channel_t * channel, uint8_t * si)
+{
+    channel->_HardwareLFODelay = *si++;
 
-        case 0xC9: si++; break;
+    return si;
+}
 
-        // 7.2. FM Channel 3 Per-Slot Detune Setting, Set an absolute detune, Command 'sd slotnum, number'
-        case 0xC8:
-        {
-            si = SetFMAbsoluteDetuneCommand(channel, si);
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Command ') %number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::FMCommand<0xE3>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume += *si++;
 
-        // 7.2. FM Channel 3 Per-Slot Detune Setting, Set a detune relative to the previous value, Command 'sdd slotnum, number'
-        case 0xC7:
-        {
-            si = SetFMRelativeDetuneCommand(channel, si);
-            break;
-        }
+    if (channel->_Volume > 127)
+        channel->_Volume = 127;
 
-        // 2.20. FM Channel 3 Expansion, Expands the 3rd FM channel by creating new channels with the notated letter, Command '#FM3Extend notation1[notation2[notation3]]]'
-        case 0xC6:
-        {
-            si = SetFMChannel3ModeEx(channel, si);
-            break;
-        }
+    return si;
+}
 
-        // 9.4. Software LFO Slot Setting, Sets the slot number to apply the effect of the software LFO to, Command 'MMA slotnum' (FM Sound Source only)
-        case 0xC5:
-        {
-            si = LFO1SetSlotMask(channel, si);
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Command '( %number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::FMCommand<0xE2>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume -= *si++;
 
-        // 13.2. Pan Setting 2
-        case 0xC3:
-        {
-            si = SetFMPan2(channel, si);
-            break;
-        }
+    if (channel->_Volume < 0)
+        channel->_Volume = 0;
 
-        // 15.7. Channel Mask Control, Sets the channel mask to on or off, Command 'm number'
-        case 0xC0:
-        {
-            si = SetFMChannelMaskCommand(channel, si);
-            break;
-        }
+    return si;
+}
 
-        // 9.3. Software LFO Switch, Controls on/off and keyon synchronization of the software LFO, Command '*B number'
-        case 0xBE:
-        {
-            si = LFO2SetSwitch(channel, si);
+/// <summary>
+/// 9.11. Hardware LFO Switch/Depth Setting (OPNA), Command "# number1, [number2]": Sets the hardware LFO on (1) or off (0). (OPNA FM sound source only). Number2 = depth. Can be omitted only when switch is 0.
+/// </summary>
+template<> uint8_t * pmd_driver_t::FMCommand<0xE0>(channel_t *, uint8_t * si)
+{
+    // Set the hardware LFO frequency (Speed) (LFO FREQ CONTROL, 0: 3.98 Hz, 1: 5.56 Hz, 2: 6.02 Hz, 3: 6.37 Hz, 4: 6.88 Hz, 5: 9.63 Hz, 6: 48.1 Hz, 7: 72.2 Hz)
+    _OPNAW->SetReg(0x22, *si++);
 
-            SetFMChannelLFOs(channel);
-            break;
-        }
+    return si;
+}
 
-        // 9.4. Software LFO Slot Setting, Sets the slot number to apply the effect of the software LFO to, Commmand 'MMB slotnum' (FM Sound Source only)
-        case 0xBA:
-        {
-            si = LFO2SetSlotMask(channel, si);
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Command ') ^%number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::FMCommand<0xDE>(channel_t * channel, uint8_t * si)
+{
+    return IncreaseVolumeForNextNote(channel, si, 128);
+}
 
-        // 6.3. FM TL Setting, Sets the TL (True Level, or operator volume) value of an FM instrument.
-        case 0xB8:
-        {
-            si = SetFMTrueLevelCommand(channel, si);
-            break;
-        }
+/// <summary>
+/// 9.3. Software LFO Switch, Controls on/off and keyon synchronization of the software LFO, Command '*B number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::FMCommand<0xBE>(channel_t * channel, uint8_t * si)
+{
+    si = LFO2SetSwitch(channel, si);
 
-        // 6.4. FM FB Setting, Sets the FB (Feedback) value of an FM instrument.
-        case 0xB6:
-        {
-            si = SetFMFeedbackLoopCommand(channel, si);
-            break;
-        }
+    SetFMChannelLFOs(channel);
 
-        // 12.3. Keyon Delay Per Slot Setting, Delays the KeyOn of specified slots, Command 'sk number1[, number2]'
-        case 0xB5:
-        {
-            channel->_FMSlotDelayMask = (~(*si++) << 4) & 0xF0;
-            channel->_FMSlotDelayCounter =
-            channel->_SlotDelay = *si++;
-            break;
-        }
+    return si;
+}
 
-        default:
-            si = ExecuteCommand(channel, si, Command);
-    }
+/// <summary>
+/// 12.3. Keyon Delay Per Slot Setting, Delays the KeyOn of specified slots, Command 'sk number1[, number2]'
+/// </summary>
+template<> uint8_t * pmd_driver_t::FMCommand<0xB5>(channel_t * channel, uint8_t * si)
+{
+    channel->_FMSlotDelayMask = (~(*si++) << 4) & 0xF0;
+    channel->_FMSlotDelayCounter =
+    channel->_SlotDelay = *si++;
 
     return si;
 }
 
+/// <summary>
+/// The handlers of the FM commands, indexed by command byte. The other commands are executed like on every sound source.
+/// </summary>
+const pmd_driver_t::command_table_t pmd_driver_t::_FMCommands = pmd_driver_t::CreateCommandTable(
+{
+    { 0xFF, &pmd_driver_t::SetFMInstrument }, // 6.1. Instrument Number Setting, Command '@[@] insnum' / Command '@[@] insnum[,number1[,number2[,number3]]]'
+    { 0xFE, &pmd_driver_t::FMCommand<0xFE> },
+    { 0xF4, &pmd_driver_t::FMCommand<0xF4> },
+    { 0xF3, &pmd_driver_t::FMCommand<0xF3> },
+    { 0xF1, &pmd_driver_t::FMCommand<0xF1> },
+    { 0xF0, &pmd_driver_t::SkipCommand<4> },
+    { 0xEF, &pmd_driver_t::FMCommand<0xEF> },
+    { 0xEE, &pmd_driver_t::SkipCommand<1> },
+    { 0xED, &pmd_driver_t::SkipCommand<1> },
+    { 0xEC, &pmd_driver_t::SetFMPan1 }, // 13.1. Pan setting 1
+    { 0xE4, &pmd_driver_t::FMCommand<0xE4> },
+    { 0xE3, &pmd_driver_t::FMCommand<0xE3> },
+    { 0xE2, &pmd_driver_t::FMCommand<0xE2> },
+    { 0xE1, &pmd_driver_t::SetHardwareLFO_PMS_AMS }, // 9.10. Hardware LFO Speed/Delay Setting, Command 'H number1[, number2]'
+    { 0xE0, &pmd_driver_t::FMCommand<0xE0> },
+    { 0xDE, &pmd_driver_t::FMCommand<0xDE> },
+    { 0xDA, &pmd_driver_t::SetFMPortamentoCommand }, // 4.3. Portamento Setting
+    { 0xCF, &pmd_driver_t::SetFMSlotCommand }, // 6.2. FM Slot Use Setting, Specifies the slot position (operators) to be used for performance/definition, Command 's number'
+    { 0xCD, &pmd_driver_t::SkipCommand<5> },
+    { 0xC9, &pmd_driver_t::SkipCommand<1> },
+    { 0xC8, &pmd_driver_t::SetFMAbsoluteDetuneCommand }, // 7.2. FM Channel 3 Per-Slot Detune Setting, Set an absolute detune, Command 'sd slotnum, number'
+    { 0xC7, &pmd_driver_t::SetFMRelativeDetuneCommand }, // 7.2. FM Channel 3 Per-Slot Detune Setting, Set a detune relative to the previous value, Command 'sdd slotnum, number'
+    { 0xC6, &pmd_driver_t::SetFMChannel3ModeEx }, // 2.20. FM Channel 3 Expansion, Expands the 3rd FM channel by creating new channels with the notated letter, Command '#FM3Extend notation1[notation2[notation3]]]'
+    { 0xC5, &pmd_driver_t::LFO1SetSlotMask }, // 9.4. Software LFO Slot Setting, Sets the slot number to apply the effect of the software LFO to, Command 'MMA slotnum' (FM Sound Source only)
+    { 0xC3, &pmd_driver_t::SetFMPan2 }, // 13.2. Pan Setting 2
+    { 0xC0, &pmd_driver_t::SetFMChannelMaskCommand }, // 15.7. Channel Mask Control, Sets the channel mask to on or off, Command 'm number'
+    { 0xBE, &pmd_driver_t::FMCommand<0xBE> },
+    { 0xBA, &pmd_driver_t::LFO2SetSlotMask }, // 9.4. Software LFO Slot Setting, Sets the slot number to apply the effect of the software LFO to, Commmand 'MMB slotnum' (FM Sound Source only)
+    { 0xB8, &pmd_driver_t::SetFMTrueLevelCommand }, // 6.3. FM TL Setting, Sets the TL (True Level, or operator volume) value of an FM instrument.
+    { 0xB6, &pmd_driver_t::SetFMFeedbackLoopCommand }, // 6.4. FM FB Setting, Sets the FB (Feedback) value of an FM instrument.
+    { 0xB5, &pmd_driver_t::FMCommand<0xB5> },
+});
+
 /// <summary>
 /// Completely muting the [PartB] part (TL=127 and RR=15 and KEY-OFF). cy=1 ･･･ All slots are neiromasked
 /// </summary>
@@ -618,6 +587,10 @@ void pmd_driver_t::FMKeyOn(channel_t * channel)
     if (channel->_Tone == 0xFF)
         return;
 
+    // The slots of a note with a slot delay are keyed on twice, without a key off in between.
+    if ((_Events != nullptr) && !_EventStates[GetChannelNumber(channel)].IsKeyOn)
+        RecordKeyOn(channel, channel->_Tone);
+
     int32_t Index = _Driver._CurrentChannel - 1;
 
     if (_Driver._FMSelector == 0x000)
@@ -652,6 +625,9 @@ void pmd_driver_t::FMKeyOff(channel_t * channel)
     if (channel->_Tone == 0xFF)
         return;
 
+    if (_Events != nullptr)
+        RecordKeyOff(channel);
+
     int32_t Index = _Driver._CurrentChannel - 1;
 
     if (_Driver._FMSelector == 0x000)
@@ -1709,17 +1685,9 @@ uint8_t * pmd_driver_t::GetFMInstrumentDefinition(channel_t * channel, int instr
             return _State._EData;
     }
 
-    uint8_t * Data = _State._InstrumentData;
-
-    while (Data[0] != instrumentNumber)
-    {
-        Data += 26;
-
-        if (Data > _MData + sizeof(_MData) - 26)
-            return _State._InstrumentData + 1; // Return the first definition if not found.
-    }
+    uint8_t * Data = ((uint32_t) instrumentNumber < _countof(_State._InstrumentIndex)) ? _State._InstrumentIndex[instrumentNumber] : nullptr;
 
-    return Data + 1;
+    return (Data != nullptr) ? Data : _State._InstrumentData + 1; // Return the first definition if not found.
 }
 
 // Reset the tone of the FM sound source
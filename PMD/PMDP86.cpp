@@ -1,5 +1,5 @@
 
-// $VER: PMDP86.cpp (2026.01.07) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara)
+// $VER: PMDP86.cpp (2026.10.19) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara)
 
 #include <pch.h>
 
@@ -43,6 +43,12 @@ void pmd_driver_t::P86Main(channel_t * channel)
         {
             if (*si > 0x80)
             {
+                if (!CountCommand())
+                {
+                    channel->_Data = si;
+                    return;
+                }
+
                 si = P86ExecuteCommand(channel, si);
             }
             else
@@ -178,144 +184,128 @@ uint8_t * pmd_driver_t::P86ExecuteCommand(channel_t * channel, uint8_t * si)
 {
     const uint8_t Command = *si++;
 
-    switch (Command)
-    {
-        // 6.1. Instrument Number Setting, Command '@[@] insnum' / Command '@[@] insnum[,number1[,number2[,number3]]]'
-        case 0xFF:
-        {
-            si = P86SetInstrument(channel, si);
-            break;
-        }
-
-        // 4.12. Sound Cut Setting 1, Command 'Q [%] numerical value' / 4.13. Sound Cut Setting 2, Command 'q [number1][-[number2]] [,number3]' / Command 'q [l length[.]][-[l length]] [,l length[.]]'
-        case 0xFE:
-        {
-            channel->_EarlyKeyOffTimeout1 = *si++;
-            break;
-        }
-
-        // 15.1. FM Chip Direct Output, Direct register write. Writes val to address reg of the YM2608's internal memory, Command 'y number1, number2'
-        case 0xEF:
-        {
-            _OPNAW->SetReg((uint32_t) (0x100 + si[0]), si[1]);
-            si += 2;
-            break;
-        }
-
-        case 0xEE: si++; break;
-        case 0xED: si++; break;
-
-        // 13.1. Pan setting 1
-        case 0xEC:
-            si = P86SetPan1(channel, si);
-            break;
-
-        // 5.5. Relative Volume Change, Command ') %number'
-        case 0xE3:
-        {
-            channel->_Volume += *si++;
+    return (this->*_P86Commands[Command])(channel, si);
+}
 
-            if (channel->_Volume > 255)
-                channel->_Volume = 255;
-            break;
-        }
+/// <summary>
+/// 4.12. Sound Cut Setting 1, Command 'Q [%] numerical value' / 4.13. Sound Cut Setting 2, Command 'q [number1][-[number2]] [,number3]' / Command 'q [l length[.]][-[l length]] [,l length[.]]'
+/// </summary>
+template<> uint8_t * pmd_driver_t::P86Command<0xFE>(channel_t * channel, uint8_t * si)
+{
+    channel->_EarlyKeyOffTimeout1 = *si++;
 
-        // 5.5. Relative Volume Change, Command '( %number'
-        case 0xE2:
-        {
-            channel->_Volume -= *si++;
+    return si;
+}
 
-            if (channel->_Volume < 0)
-                channel->_Volume = 0;
-            break;
-        }
+/// <summary>
+/// 15.1. FM Chip Direct Output, Direct register write. Writes val to address reg of the YM2608's internal memory, Command 'y number1, number2'
+/// </summary>
+template<> uint8_t * pmd_driver_t::P86Command<0xEF>(channel_t *, uint8_t * si)
+{
+    _OPNAW->SetReg((uint32_t) (0x100 + si[0]), si[1]);
+    si += 2;
 
-        // 5.5. Relative Volume Change, Command ') ^%number'
-        case 0xDE:
-        {
-            si = IncreaseVolumeForNextNote(channel, si, 255);
-            break;
-        }
+    return si;
+}
 
-        case 0xDA: si++; break;
+/// <summary>
+/// 5.5. Relative Volume Change, Command ') %number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::P86Command<0xE3>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume += *si++;
 
-        // 15.5. SSG Sound Effect Playback, Play SSG sound effect, Command 'n number'
-        case 0xD4:
-        {
-            si = SetSSGEffect(channel, si);
-            break;
-        }
+    if (channel->_Volume > 255)
+        channel->_Volume = 255;
 
-        // 15.5. FM Sound Effect Playback, Play FM sound effect, Command 'N number'
-        case 0xD3:
-        {
-            si = SetFMEffect(channel, si);
-            break;
-        }
+    return si;
+}
 
-        // 15.3. Fade Out Setting, Fades out from the specified position, Command 'F number'
-        case 0xD2:
-        {
-            _State._FadeOutSpeed = *si++;
-            _State._IsFadeOutSpeedSet = true;
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Command '( %number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::P86Command<0xE2>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume -= *si++;
 
-        // 6.1.5. Instrument Number Setting/PCM Channels Case, Set PCM Repeat.
-        case 0xCE:
-        {
-            si = P86SetRepeat(channel, si);
-            break;
-        }
+    if (channel->_Volume < 0)
+        channel->_Volume = 0;
 
-        // Set SSG Extend Mode (bit 1).
-        case 0xCA:
-            channel->_ExtendMode = (channel->_ExtendMode & 0xFD) | ((*si++ & 0x01) << 1);
-            break;
+    return si;
+}
 
-        // 8.2. Software Envelope Speed Setting, Set SSG Extend Mode (bit 2), Command 'EX number'
-        case 0xC9:
-        {
-            channel->_ExtendMode = (channel->_ExtendMode & 0xFB) | ((*si++ & 0x01) << 2);
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Command ') ^%number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::P86Command<0xDE>(channel_t * channel, uint8_t * si)
+{
+    return IncreaseVolumeForNextNote(channel, si, 255);
+}
 
-        // 13.2. Pan Setting 2
-        case 0xC3:
-        {
-            si = P86SetPan2(channel, si);
-            break;
-        }
+/// <summary>
+/// 15.3. Fade Out Setting, Fades out from the specified position, Command 'F number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::P86Command<0xD2>(channel_t *, uint8_t * si)
+{
+    _State._FadeOutSpeed = *si++;
+    _State._IsFadeOutSpeedSet = true;
 
-        // 15.7. Channel Mask Control, Sets the channel mask to on or off, Command 'm number'
-        case 0xC0:
-        {
-            si = P86SetChannelMask(channel, si);
-            break;
-        }
+    return si;
+}
 
-        case 0xBF: si += 4; break;
-        case 0xBE: si++; break;
-        case 0xBD: si += 2; break;
-        case 0xBC: si++; break;
-        case 0xBB: si++; break;
-        case 0xBA: si++; break;
-        case 0xB9: si++; break;
+/// <summary>
+/// Set SSG Extend Mode (bit 1).
+/// </summary>
+template<> uint8_t * pmd_driver_t::P86Command<0xCA>(channel_t * channel, uint8_t * si)
+{
+    channel->_ExtendMode = (channel->_ExtendMode & 0xFD) | ((*si++ & 0x01) << 1);
 
-        // 2.25. PPZ8 Channel Extension, Extends the PPZ8 channels with the notated channels, Command '#PPZExtend notation1[notation2[notation3]... (up to 8)]]'
-        case 0xB4:
-        {
-            si = PPZ8Initialize(channel, si);
-            break;
-        }
+    return si;
+}
 
-        default:
-            si = ExecuteCommand(channel, si, Command);
-    }
+/// <summary>
+/// 8.2. Software Envelope Speed Setting, Set SSG Extend Mode (bit 2), Command 'EX number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::P86Command<0xC9>(channel_t * channel, uint8_t * si)
+{
+    channel->_ExtendMode = (channel->_ExtendMode & 0xFB) | ((*si++ & 0x01) << 2);
 
     return si;
 }
 
+/// <summary>
+/// The handlers of the P86 commands, indexed by command byte. The other commands are executed like on every sound source.
+/// </summary>
+const pmd_driver_t::command_table_t pmd_driver_t::_P86Commands = pmd_driver_t::CreateCommandTable(
+{
+    { 0xFF, &pmd_driver_t::P86SetInstrument }, // 6.1. Instrument Number Setting, Command '@[@] insnum' / Command '@[@] insnum[,number1[,number2[,number3]]]'
+    { 0xFE, &pmd_driver_t::P86Command<0xFE> },
+    { 0xEF, &pmd_driver_t::P86Command<0xEF> },
+    { 0xEE, &pmd_driver_t::SkipCommand<1> },
+    { 0xED, &pmd_driver_t::SkipCommand<1> },
+    { 0xEC, &pmd_driver_t::P86SetPan1 }, // 13.1. Pan setting 1
+    { 0xE3, &pmd_driver_t::P86Command<0xE3> },
+    { 0xE2, &pmd_driver_t::P86Command<0xE2> },
+    { 0xDE, &pmd_driver_t::P86Command<0xDE> },
+    { 0xDA, &pmd_driver_t::SkipCommand<1> },
+    { 0xD4, &pmd_driver_t::SetSSGEffect }, // 15.5. SSG Sound Effect Playback, Play SSG sound effect, Command 'n number'
+    { 0xD3, &pmd_driver_t::SetFMEffect }, // 15.5. FM Sound Effect Playback, Play FM sound effect, Command 'N number'
+    { 0xD2, &pmd_driver_t::P86Command<0xD2> },
+    { 0xCE, &pmd_driver_t::P86SetRepeat }, // 6.1.5. Instrument Number Setting/PCM Channels Case, Set PCM Repeat.
+    { 0xCA, &pmd_driver_t::P86Command<0xCA> },
+    { 0xC9, &pmd_driver_t::P86Command<0xC9> },
+    { 0xC3, &pmd_driver_t::P86SetPan2 }, // 13.2. Pan Setting 2
+    { 0xC0, &pmd_driver_t::P86SetChannelMask }, // 15.7. Channel Mask Control, Sets the channel mask to on or off, Command 'm number'
+    { 0xBF, &pmd_driver_t::SkipCommand<4> },
+    { 0xBE, &pmd_driver_t::SkipCommand<1> },
+    { 0xBD, &pmd_driver_t::SkipCommand<2> },
+    { 0xBC, &pmd_driver_t::SkipCommand<1> },
+    { 0xBB, &pmd_driver_t::SkipCommand<1> },
+    { 0xBA, &pmd_driver_t::SkipCommand<1> },
+    { 0xB9, &pmd_driver_t::SkipCommand<1> },
+    { 0xB4, &pmd_driver_t::PPZ8Initialize }, // 2.25. PPZ8 Channel Extension, Extends the PPZ8 channels with the notated channels, Command '#PPZExtend notation1[notation2[notation3]... (up to 8)]]'
+});
+
 #pragma region(Commands)
 /// <summary>
 ///
@@ -460,6 +450,9 @@ void pmd_driver_t::P86KeyOn(channel_t * channel)
     if (channel->_Tone == 0xFF)
         return;
 
+    if (_Events != nullptr)
+        RecordKeyOn(channel, channel->_Tone);
+
     _P86->Start();
 }
 
@@ -1,5 +1,5 @@
 
-/** $VER: PMDPPZ8.cpp (2026.01.07) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
+/** $VER: PMDPPZ8.cpp (2026.10.19) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
 
 #include <pch.h>
 
@@ -45,6 +45,12 @@ void pmd_driver_t::PPZ8Main(channel_t * channel)
         {
             if ((*si != 0xDA) && (*si > 0x80))
             {
+                if (!CountCommand())
+                {
+                    channel->_Data = si;
+                    return;
+                }
+
                 si = PPZ8ExecuteCommand(channel, si);
             }
             else
@@ -189,114 +195,96 @@ uint8_t * pmd_driver_t::PPZ8ExecuteCommand(channel_t * channel, uint8_t * si)
 {
     const uint8_t Command = *si++;
 
-    switch (Command)
-    {
-        // 6.1. Instrument Number Setting, Command '@[@] insnum' / Command '@[@] insnum[,number1[,number2[,number3]]]'
-        case 0xFF:
-        {
-            si = PPZ8SetInstrument(channel, si);
-            break;
-        }
-
-        // 4.12. Sound Cut Setting 1, Command 'Q [%] numerical value' / 4.13. Sound Cut Setting 2, Command 'q [number1][-[number2]] [,number3]' / Command 'q [l length[.]][-[l length]] [,l length[.]]'
-        case 0xFE:
-        {
-            channel->_EarlyKeyOffTimeout1 = *si++;
-            break;
-        }
-
-        // 15.1. FM Chip Direct Output, Direct register write. Writes val to address reg of the YM2608's internal memory, Command 'y number1, number2'
-        case 0xEF:
-        {
-            _OPNAW->SetReg((uint32_t) (_Driver._FMSelector + si[0]), si[1]);
-            si += 2;
-            break;
-        }
-
-        case 0xEE: si++; break;
-        case 0xED: si++; break;
-
-        // 13.1. Pan setting 1
-        case 0xEC:
-            si = PPZ8SetPan1(channel, si);
-            break;
+    return (this->*_PPZ8Commands[Command])(channel, si);
+}
 
-        // 5.5. Relative Volume Change, Command ') %number'
-        case 0xE3:
-        {
-            channel->_Volume += *si++;
+/// <summary>
+/// 4.12. Sound Cut Setting 1, Command 'Q [%] numerical value' / 4.13. Sound Cut Setting 2, Command 'q [number1][-[number2]] [,number3]' / Command 'q [l length[.]][-[l length]] [,l length[.]]'
+/// </summary>
+template<> uint8_t * pmd_driver_t::PPZ8Command<0xFE>(channel_t * channel, uint8_t * si)
+{
+    channel->_EarlyKeyOffTimeout1 = *si++;
 
-            if (channel->_Volume > 255)
-                channel->_Volume = 255;
-            break;
-        }
+    return si;
+}
 
-        // 5.5. Relative Volume Change, Command '( %number'
-        case 0xE2:
-        {
-            channel->_Volume -= *si++;
+/// <summary>
+/// 15.1. FM Chip Direct Output, Direct register write. Writes val to address reg of the YM2608's internal memory, Command 'y number1, number2'
+/// </summary>
+template<> uint8_t * pmd_driver_t::PPZ8Command<0xEF>(channel_t *, uint8_t * si)
+{
+    _OPNAW->SetReg((uint32_t) (_Driver._FMSelector + si[0]), si[1]);
+    si += 2;
 
-            if (channel->_Volume < 0)
-                channel->_Volume = 0;
-            break;
-        }
+    return si;
+}
 
-        // 5.5. Relative Volume Change, Command ') ^%number'
-        case 0xDE:
-        {
-            si = IncreaseVolumeForNextNote(channel, si, 255);
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Command ') %number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::PPZ8Command<0xE3>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume += *si++;
 
-        // 4.3. Portamento Setting
-        case 0xDA:
-        {
-            si = PPZ8SetPortamento(channel, si);
-            break;
-        }
+    if (channel->_Volume > 255)
+        channel->_Volume = 255;
 
-        // 6.1.5. Instrument Number Setting/PCM Channels Case, Set PCM Repeat.
-        case 0xCE:
-        {
-            si = PPZ8SetRepeat(channel, si);
-            break;
-        }
+    return si;
+}
 
-        // 8.2. Software Envelope Speed Setting, Set SSG Extend Mode (bit 2), Command 'EX number'
-        case 0xC9:
-        {
-            channel->_ExtendMode = (channel->_ExtendMode & 0xFB) | ((*si++ & 0x01) << 2);
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Command '( %number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::PPZ8Command<0xE2>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume -= *si++;
 
-        // 13.2. Pan Setting 2
-        case 0xC3:
-        {
-            si = PPZ8SetPan2(channel, si);
-            break;
-        }
+    if (channel->_Volume < 0)
+        channel->_Volume = 0;
 
-        // 15.7. Channel Mask Control, Sets the channel mask to on or off, Command 'm number'
-        case 0xC0:
-        {
-            si = PPZ8SethannelMask(channel, si);
-            break;
-        }
+    return si;
+}
 
-        // 9.3. Software LFO Switch, Controls on/off and keyon synchronization of the software LFO, Command '*B number'
-        case 0xBE:
-        {
-            si = LFO2SetSwitch(channel, si);
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Command ') ^%number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::PPZ8Command<0xDE>(channel_t * channel, uint8_t * si)
+{
+    return IncreaseVolumeForNextNote(channel, si, 255);
+}
 
-        default:
-            si = ExecuteCommand(channel, si, Command);
-    }
+/// <summary>
+/// 8.2. Software Envelope Speed Setting, Set SSG Extend Mode (bit 2), Command 'EX number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::PPZ8Command<0xC9>(channel_t * channel, uint8_t * si)
+{
+    channel->_ExtendMode = (channel->_ExtendMode & 0xFB) | ((*si++ & 0x01) << 2);
 
     return si;
 }
 
+/// <summary>
+/// The handlers of the PPZ8 commands, indexed by command byte. The other commands are executed like on every sound source.
+/// </summary>
+const pmd_driver_t::command_table_t pmd_driver_t::_PPZ8Commands = pmd_driver_t::CreateCommandTable(
+{
+    { 0xFF, &pmd_driver_t::PPZ8SetInstrument }, // 6.1. Instrument Number Setting, Command '@[@] insnum' / Command '@[@] insnum[,number1[,number2[,number3]]]'
+    { 0xFE, &pmd_driver_t::PPZ8Command<0xFE> },
+    { 0xEF, &pmd_driver_t::PPZ8Command<0xEF> },
+    { 0xEE, &pmd_driver_t::SkipCommand<1> },
+    { 0xED, &pmd_driver_t::SkipCommand<1> },
+    { 0xEC, &pmd_driver_t::PPZ8SetPan1 }, // 13.1. Pan setting 1
+    { 0xE3, &pmd_driver_t::PPZ8Command<0xE3> },
+    { 0xE2, &pmd_driver_t::PPZ8Command<0xE2> },
+    { 0xDE, &pmd_driver_t::PPZ8Command<0xDE> },
+    { 0xDA, &pmd_driver_t::PPZ8SetPortamento }, // 4.3. Portamento Setting
+    { 0xCE, &pmd_driver_t::PPZ8SetRepeat }, // 6.1.5. Instrument Number Setting/PCM Channels Case, Set PCM Repeat.
+    { 0xC9, &pmd_driver_t::PPZ8Command<0xC9> },
+    { 0xC3, &pmd_driver_t::PPZ8SetPan2 }, // 13.2. Pan Setting 2
+    { 0xC0, &pmd_driver_t::PPZ8SethannelMask }, // 15.7. Channel Mask Control, Sets the channel mask to on or off, Command 'm number'
+    { 0xBE, &pmd_driver_t::LFO2SetSwitch }, // 9.3. Software LFO Switch, Controls on/off and keyon synchronization of the software LFO, Command '*B number'
+});
+
 #pragma region(Commands)
 /// <summary>
 ///
@@ -461,6 +449,9 @@ void pmd_driver_t::PPZ8KeyOn(channel_t * channel)
     if (channel->_Tone == 0xFF)
         return;
 
+    if (_Events != nullptr)
+        RecordKeyOn(channel, channel->_Tone);
+
     if ((channel->InstrumentNumber & 0x80) == 0)
         _PPZ8->Play((size_t) _Driver._CurrentChannel, 0, channel->InstrumentNumber,        0, 0);
     else
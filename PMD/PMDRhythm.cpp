@@ -1,5 +1,5 @@
 
-/** $VER: PMDRhythm.cpp (2026.01.07) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
+/** $VER: PMDRhythm.cpp (2026.10.19) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
 
 #include <pch.h>
 
@@ -40,6 +40,13 @@ void pmd_driver_t::RhythmMain(channel_t * channel)
             {
                 if (Note & 0x80)
                 {
+                    // Commands embedded in a rhythm pattern.
+                    if ((Note & 0x40) && !CountCommand())
+                    {
+                        _State._RhythmData = Data - 1;
+                        return;
+                    }
+
                     Data = RhythmKeyOn(channel, Note, Data, &EndOfRhythmData);
 
                     if (!EndOfRhythmData)
@@ -69,6 +76,13 @@ void pmd_driver_t::RhythmMain(channel_t * channel)
         {
             while ((Note = *si++) != 0x80)
             {
+                // Pattern references count as well: a part that only references empty patterns never consumes time.
+                if (!CountCommand())
+                {
+                    channel->_Data = si - 1;
+                    return;
+                }
+
                 if (Note < 0x80)
                 {
                     channel->_Data = si;
@@ -88,6 +102,9 @@ void pmd_driver_t::RhythmMain(channel_t * channel)
 
             if (Data != nullptr)
             {
+                if (!CountCommand())
+                    return;
+
                 // Start executing a loop.
                 si = (uint8_t *) Data;
 
@@ -117,112 +134,125 @@ uint8_t * pmd_driver_t::RhythmExecuteCommand(channel_t * channel, uint8_t * si)
 {
     const uint8_t Command = *si++;
 
-    switch (Command)
-    {
-        case 0xF5: si++; break;
-
-        // 5.5. Relative Volume Change, Increase volume by 3dB.
-        case 0xF4:
-        {
-            if (channel->_Volume < 15)
-                channel->_Volume++;
-            break;
-        }
-
-        // 5.5. Relative Volume Change, Decrease volume by 3dB.
-        case 0xF3:
-        {
-            if (channel->_Volume > 0)
-                channel->_Volume--;
-            break;
-        }
+    return (this->*_RhythmCommands[Command])(channel, si);
+}
 
-        case 0xF2: si += 4; break;
+/// <summary>
+/// 5.5. Relative Volume Change, Increase volume by 3dB.
+/// </summary>
+template<> uint8_t * pmd_driver_t::RhythmCommand<0xF4>(channel_t * channel, uint8_t * si)
+{
+    if (channel->_Volume < 15)
+        channel->_Volume++;
 
-        // 9.3. Software LFO Switch, Command '*A number'
-        case 0xF1:
-        {
-            si = RhythmSetLFOControl(channel, si);
-            break;
-        }
+    return si;
+}
 
-        case 0xF0: si += 4; break;
+/// <summary>
+/// 5.5. Relative Volume Change, Decrease volume by 3dB.
+/// </summary>
+template<> uint8_t * pmd_driver_t::RhythmCommand<0xF3>(channel_t * channel, uint8_t * si)
+{
+    if (channel->_Volume > 0)
+        channel->_Volume--;
 
-        // 15.1. FM Chip Direct Output, Direct register write. Writes val to address reg of the YM2608's internal memory, Command 'y number1, number2'
-        case 0xEF:
-        {
-            _OPNAW->SetReg(si[0], si[1]);
-            si += 2;
-            break;
-        }
+    return si;
+}
 
-        case 0xEE: si++; break;
-        case 0xED: si++; break;
-        case 0xEC: si++; break;
-        case 0xE7: si++; break;
+/// <summary>
+/// 9.3. Software LFO Switch, Command '*A number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::RhythmCommand<0xF1>(channel_t * channel, uint8_t * si)
+{
+    return RhythmSetLFOControl(channel, si);
+}
 
-        // 5.5. Relative Volume Change, Command ') %number'
-        case 0xE3:
-        {
-            channel->_Volume += *si++;
+/// <summary>
+/// 15.1. FM Chip Direct Output, Direct register write. Writes val to address reg of the YM2608's internal memory, Command 'y number1, number2'
+/// </summary>
+template<> uint8_t * pmd_driver_t::RhythmCommand<0xEF>(channel_t *, uint8_t * si)
+{
+    _OPNAW->SetReg(si[0], si[1]);
+    si += 2;
 
-            if (channel->_Volume > 16)
-                channel->_Volume = 16;
-            break;
-        }
+    return si;
+}
 
-        // 5.5. Relative Volume Change, Command '( %number'
-        case 0xE2:
-        {
-            channel->_Volume -= *si++;
+/// <summary>
+/// 5.5. Relative Volume Change, Command ') %number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::RhythmCommand<0xE3>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume += *si++;
 
-            if (channel->_Volume < 0)
-                channel->_Volume = 0;
-            break;
-        }
+    if (channel->_Volume > 16)
+        channel->_Volume = 16;
 
-        // 5.5. Relative Volume Change, Command ') ^%number'
-        case 0xDE:
-        {
-            si = IncreaseVolumeForNextNote(channel, si, 15);
-            break;
-        }
+    return si;
+}
 
-        case 0xDA: si++; break;
-        case 0xD6: si += 2; break;
-        case 0xCD: si += 5; break;
-        case 0xCB: si++; break;
-        case 0xCA: si++; break;
-        case 0xC9: si++; break;
-        case 0xC4: si++; break;
-        case 0xC3: si += 2; break;
-        case 0xC2: si++; break;
-
-        // 15.7. Channel Mask Control, Sets the channel mask to on or off, Command 'm number'
-        case 0xC0:
-        {
-            si = RhythmSetChannelMask(channel, si);
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Command '( %number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::RhythmCommand<0xE2>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume -= *si++;
 
-        case 0xBF: si += 4; break;
-        case 0xBE: si++; break;
-        case 0xBD: si += 2; break;
-        case 0xBC: si++; break;
-        case 0xBB: si++; break;
-        case 0xB9: si++; break;
-        case 0xB7: si++; break;
-        case 0xB3: si++; break;
-        case 0xB2: si++; break;
-        case 0xB1: si++; break;
-
-        default:
-            si = ExecuteCommand(channel, si, Command);
-    }
+    if (channel->_Volume < 0)
+        channel->_Volume = 0;
 
     return si;
 }
 
+/// <summary>
+/// 5.5. Relative Volume Change, Command ') ^%number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::RhythmCommand<0xDE>(channel_t * channel, uint8_t * si)
+{
+    return IncreaseVolumeForNextNote(channel, si, 15);
+}
+
+/// <summary>
+/// The handlers of the rhythm commands, indexed by command byte. The other commands are executed like on every sound source.
+/// </summary>
+const pmd_driver_t::command_table_t pmd_driver_t::_RhythmCommands = pmd_driver_t::CreateCommandTable(
+{
+    { 0xF5, &pmd_driver_t::SkipCommand<1> },
+    { 0xF4, &pmd_driver_t::RhythmCommand<0xF4> },
+    { 0xF3, &pmd_driver_t::RhythmCommand<0xF3> },
+    { 0xF2, &pmd_driver_t::SkipCommand<4> },
+    { 0xF1, &pmd_driver_t::RhythmCommand<0xF1> },
+    { 0xF0, &pmd_driver_t::SkipCommand<4> },
+    { 0xEF, &pmd_driver_t::RhythmCommand<0xEF> },
+    { 0xEE, &pmd_driver_t::SkipCommand<1> },
+    { 0xED, &pmd_driver_t::SkipCommand<1> },
+    { 0xEC, &pmd_driver_t::SkipCommand<1> },
+    { 0xE7, &pmd_driver_t::SkipCommand<1> },
+    { 0xE3, &pmd_driver_t::RhythmCommand<0xE3> },
+    { 0xE2, &pmd_driver_t::RhythmCommand<0xE2> },
+    { 0xDE, &pmd_driver_t::RhythmCommand<0xDE> },
+    { 0xDA, &pmd_driver_t::SkipCommand<1> },
+    { 0xD6, &pmd_driver_t::SkipCommand<2> },
+    { 0xCD, &pmd_driver_t::SkipCommand<5> },
+    { 0xCB, &pmd_driver_t::SkipCommand<1> },
+    { 0xCA, &pmd_driver_t::SkipCommand<1> },
+    { 0xC9, &pmd_driver_t::SkipCommand<1> },
+    { 0xC4, &pmd_driver_t::SkipCommand<1> },
+    { 0xC3, &pmd_driver_t::SkipCommand<2> },
+    { 0xC2, &pmd_driver_t::SkipCommand<1> },
+    { 0xC0, &pmd_driver_t::RhythmSetChannelMask }, // 15.7. Channel Mask Control, Sets the channel mask to on or off, Command 'm number'
+    { 0xBF, &pmd_driver_t::SkipCommand<4> },
+    { 0xBE, &pmd_driver_t::SkipCommand<1> },
+    { 0xBD, &pmd_driver_t::SkipCommand<2> },
+    { 0xBC, &pmd_driver_t::SkipCommand<1> },
+    { 0xBB, &pmd_driver_t::SkipCommand<1> },
+    { 0xB9, &pmd_driver_t::SkipCommand<1> },
+    { 0xB7, &pmd_driver_t::SkipCommand<1> },
+    { 0xB3, &pmd_driver_t::SkipCommand<1> },
+    { 0xB2, &pmd_driver_t::SkipCommand<1> },
+    { 0xB1, &pmd_driver_t::SkipCommand<1> },
+});
+
 /// <summary>
 ///
 /// </summary>
@@ -254,6 +284,9 @@ uint8_t * pmd_driver_t::RhythmKeyOn(channel_t * channel, int32_t note, uint8_t *
             return rhythmData;
 
         _State._RhythmData = rhythmData;
+
+        if (_Events != nullptr)
+            RecordKeyOn(channel, note);
     }
 
     if (_UseSSGForDrums)
@@ -361,7 +394,7 @@ uint8_t * pmd_driver_t::RhythmDecreaseVolume(channel_t *, uint8_t * si)
 /// Starts/stops the drum channels of the RSS (Rhythm Sound Source).
 /// 14.1. Rhythm Sound Source Shot/Dump Control, Command "\b", "\s", "\c", "\h", "\t", "\i", "\bp", "\sp", "\cp", "\hp", "\tp", "\ip"
 /// </summary>
-uint8_t * pmd_driver_t::RhythmControl(uint8_t * si)
+uint8_t * pmd_driver_t::RhythmControl(channel_t * channel, uint8_t * si)
 {
     const uint32_t ChannelMask = (uint8_t) (*si++ & _RhythmMask);
 
@@ -377,6 +410,9 @@ uint8_t * pmd_driver_t::RhythmControl(uint8_t * si)
 
     if (ChannelMask < 0x80)
     {
+        if (_Events != nullptr)
+            RecordEvent(GetChannelNumber(channel), event_type_t::RhythmShot, (int32_t) ChannelMask);
+
         if (ChannelMask & 0x01)
         {
             _OPNAW->SetReg(0x18, (uint32_t) _State._RhythmPanAndVolumes[0]); // Rhytm Part: Set Output Select / Instrument Level
@@ -1,5 +1,5 @@
 
-/** $VER: PMDSSG.cpp (2026.01.07) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
+/** $VER: PMDSSG.cpp (2026.10.19) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
 
 #include <pch.h>
 
@@ -59,6 +59,12 @@ void pmd_driver_t::SSGMain(channel_t * channel)
             else
             if ((*si != 0xDA) && (*si > 0x80))
             {
+                if (!CountCommand())
+                {
+                    channel->_Data = si;
+                    return;
+                }
+
                 si = SSGExecuteCommand(channel, si);
             }
             else
@@ -212,140 +218,175 @@ uint8_t * pmd_driver_t::SSGExecuteCommand(channel_t * channel, uint8_t * si)
 {
     const uint8_t Command = *si++;
 
-    switch (Command)
-    {
-        // 4.12. Sound Cut Setting 1, Command 'Q [%] numerical value' / 4.13. Sound Cut Setting 2, Command 'q [number1][-[number2]] [,number3]' / Command 'q [l length[.]][-[l length]] [,l length[.]]'
-        case 0xFE:
-        {
-            channel->_EarlyKeyOffTimeout1 = *si++;
-            channel->EarlyKeyOffTimeoutRandomRange = 0;
-            break;
-        }
+    return (this->*_SSGCommands[Command])(channel, si);
+}
 
-        // 5.5. Relative Volume Change, Increase volume by 3dB.
-        case 0xF4:
-        {
-            if (channel->_Volume < 15)
-                channel->_Volume++;
-            break;
-        }
+/// <summary>
+/// 4.12. Sound Cut Setting 1, Command 'Q [%] numerical value' / 4.13. Sound Cut Setting 2, Command 'q [number1][-[number2]] [,number3]' / Command 'q [l length[.]][-[l length]] [,l length[.]]'
+/// </summary>
+template<> uint8_t * pmd_driver_t::SSGCommand<0xFE>(channel_t * channel, uint8_t * si)
+{
+    channel->_EarlyKeyOffTimeout1 = *si++;
+    channel->EarlyKeyOffTimeoutRandomRange = 0;
 
-        // 5.5. Relative Volume Change, Decrease volume by 3dB.
-        case 0xF3:
-        {
-            if (channel->_Volume > 0)
-                channel->_Volume--;
-            break;
-        }
+    return si;
+}
 
-        // 15.1. FM Chip Direct Output, Direct register write. Writes val to address reg of the YM2608's internal memory, Command 'y number1, number2'
-        case 0xEF:
-        {
-            _OPNAW->SetReg(si[0], si[1]);
-            si += 2;
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Increase volume by 3dB.
+/// </summary>
+template<> uint8_t * pmd_driver_t::SSGCommand<0xF4>(channel_t * channel, uint8_t * si)
+{
+    if (channel->_Volume < 15)
+        channel->_Volume++;
 
-        // 6.6. Noise frequency setting, Command 'w number'
-        case 0xEE:
-        {
-            _SSGNoiseFrequency = *si++;
-            break;
-        }
+    return si;
+}
 
-        // 6.5. SSG/OPM Tone/Noise Output Selection, Command 'P number'
-        case 0xED:
-        {
-            channel->_SSGMask = *si++;
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Decrease volume by 3dB.
+/// </summary>
+template<> uint8_t * pmd_driver_t::SSGCommand<0xF3>(channel_t * channel, uint8_t * si)
+{
+    if (channel->_Volume > 0)
+        channel->_Volume--;
 
-        case 0xEC: si++; break;
+    return si;
+}
 
-        // 5.5. Relative Volume Change, Command ') %number'
-        case 0xE3:
-        {
-            channel->_Volume += *si++;
+/// <summary>
+/// 15.1. FM Chip Direct Output, Direct register write. Writes val to address reg of the YM2608's internal memory, Command 'y number1, number2'
+/// </summary>
+template<> uint8_t * pmd_driver_t::SSGCommand<0xEF>(channel_t *, uint8_t * si)
+{
+    _OPNAW->SetReg(si[0], si[1]);
+    si += 2;
 
-            if (channel->_Volume > 15)
-                channel->_Volume = 15;
-            break;
-        }
+    return si;
+}
 
-        // 5.5. Relative Volume Change, Command ') %number'
-        case 0xE2:
-        {
-            channel->_Volume -= *si++;
+/// <summary>
+/// 6.6. Noise frequency setting, Command 'w number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::SSGCommand<0xEE>(channel_t *, uint8_t * si)
+{
+    _SSGNoiseFrequency = *si++;
 
-            if (channel->_Volume < 0)
-                channel->_Volume = 0;
-            break;
-        }
+    return si;
+}
 
-        // 5.5. Relative Volume Change, Command ') ^%number'
-        case 0xDE:
-        {
-            si = IncreaseVolumeForNextNote(channel, si, 15);
-            break;
-        }
+/// <summary>
+/// 6.5. SSG/OPM Tone/Noise Output Selection, Command 'P number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::SSGCommand<0xED>(channel_t * channel, uint8_t * si)
+{
+    channel->_SSGMask = *si++;
 
-        // 4.3. Portamento Setting
-        case 0xDA:
-        {
-            si = SSGSetPortamento(channel, si);
-            break;
-        }
+    return si;
+}
 
-        // 6.6. Noise Frequency Setting, Command 'w ±number'
-        case 0xD0:
-        {
-            si = SSGSetNoiseFrequency(si);
-            break;
-        }
+/// <summary>
+/// 5.5. Relative Volume Change, Command ') %number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::SSGCommand<0xE3>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume += *si++;
 
-        // 7.3. SSG Pitch Interval Correction Setting, Selects whether or not to adjust the SSG pitch interval, Set SSG Extend Mode (bit 0), Command 'DX number'
-        case 0xCC:
-        {
-            channel->_ExtendMode = (channel->_ExtendMode & 0xFE) | (*si++ & 0x01);
-            break;
-        }
+    if (channel->_Volume > 15)
+        channel->_Volume = 15;
 
-        // 8.2. Software Envelope Speed Setting, Set SSG Extend Mode (bit 2), Command 'EX number'
-        case 0xC9:
-        {
-            channel->_ExtendMode = (channel->_ExtendMode & 0xFB) | ((*si++ & 0x01) << 2);
-            break;
-        }
+    return si;
+}
 
-        case 0xC3: si += 2; break;
+/// <summary>
+/// 5.5. Relative Volume Change, Command ') %number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::SSGCommand<0xE2>(channel_t * channel, uint8_t * si)
+{
+    channel->_Volume -= *si++;
 
-        // 15.7. Channel Mask Control, Sets the channel mask to on or off, Command 'm number'
-        case 0xC0:
-        {
-            si = SSGSetChannelMask(channel, si);
-            break;
-        }
+    if (channel->_Volume < 0)
+        channel->_Volume = 0;
 
-        // 9.3. Software LFO Switch, Controls on/off and keyon synchronization of the software LFO, Command '*B number'
-        case 0xBE:
-        {
-            channel->_HardwareLFO = (channel->_HardwareLFO & 0x8F) | ((*si++ & 0x07) << 4);
+    return si;
+}
 
-            LFOSwap(channel);
+/// <summary>
+/// 5.5. Relative Volume Change, Command ') ^%number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::SSGCommand<0xDE>(channel_t * channel, uint8_t * si)
+{
+    return IncreaseVolumeForNextNote(channel, si, 15);
+}
+
+/// <summary>
+/// 6.6. Noise Frequency Setting, Command 'w ±number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::SSGCommand<0xD0>(channel_t *, uint8_t * si)
+{
+    return SSGSetNoiseFrequency(si);
+}
 
-            LFOReset(channel);
+/// <summary>
+/// 7.3. SSG Pitch Interval Correction Setting, Selects whether or not to adjust the SSG pitch interval, Set SSG Extend Mode (bit 0), Command 'DX number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::SSGCommand<0xCC>(channel_t * channel, uint8_t * si)
+{
+    channel->_ExtendMode = (channel->_ExtendMode & 0xFE) | (*si++ & 0x01);
 
-            LFOSwap(channel);
-            break;
-        }
+    return si;
+}
 
-        default:
-            si = ExecuteCommand(channel, si, Command);
-    }
+/// <summary>
+/// 8.2. Software Envelope Speed Setting, Set SSG Extend Mode (bit 2), Command 'EX number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::SSGCommand<0xC9>(channel_t * channel, uint8_t * si)
+{
+    channel->_ExtendMode = (channel->_ExtendMode & 0xFB) | ((*si++ & 0x01) << 2);
+
+    return si;
+}
+
+/// <summary>
+/// 9.3. Software LFO Switch, Controls on/off and keyon synchronization of the software LFO, Command '*B number'
+/// </summary>
+template<> uint8_t * pmd_driver_t::SSGCommand<0xBE>(channel_t * channel, uint8_t * si)
+{
+    channel->_HardwareLFO = (channel->_HardwareLFO & 0x8F) | ((*si++ & 0x07) << 4);
+
+    LFOSwap(channel);
+
+    LFOReset(channel);
+
+    LFOSwap(channel);
 
     return si;
 }
 
+/// <summary>
+/// The handlers of the SSG commands, indexed by command byte. The other commands are executed like on every sound source.
+/// </summary>
+const pmd_driver_t::command_table_t pmd_driver_t::_SSGCommands = pmd_driver_t::CreateCommandTable(
+{
+    { 0xFE, &pmd_driver_t::SSGCommand<0xFE> },
+    { 0xF4, &pmd_driver_t::SSGCommand<0xF4> },
+    { 0xF3, &pmd_driver_t::SSGCommand<0xF3> },
+    { 0xEF, &pmd_driver_t::SSGCommand<0xEF> },
+    { 0xEE, &pmd_driver_t::SSGCommand<0xEE> },
+    { 0xED, &pmd_driver_t::SSGCommand<0xED> },
+    { 0xEC, &pmd_driver_t::SkipCommand<1> },
+    { 0xE3, &pmd_driver_t::SSGCommand<0xE3> },
+    { 0xE2, &pmd_driver_t::SSGCommand<0xE2> },
+    { 0xDE, &pmd_driver_t::SSGCommand<0xDE> },
+    { 0xDA, &pmd_driver_t::SSGSetPortamento }, // 4.3. Portamento Setting
+    { 0xD0, &pmd_driver_t::SSGCommand<0xD0> },
+    { 0xCC, &pmd_driver_t::SSGCommand<0xCC> },
+    { 0xC9, &pmd_driver_t::SSGCommand<0xC9> },
+    { 0xC3, &pmd_driver_t::SkipCommand<2> },
+    { 0xC0, &pmd_driver_t::SSGSetChannelMask }, // 15.7. Channel Mask Control, Sets the channel mask to on or off, Command 'm number'
+    { 0xBE, &pmd_driver_t::SSGCommand<0xBE> },
+});
+
 /// <summary>
 ///
 /// </summary>
@@ -553,6 +594,9 @@ void pmd_driver_t::SSGKeyOn(channel_t * channel)
     if (channel->_Tone == 0xFF)
         return;
 
+    if (_Events != nullptr)
+        RecordKeyOn(channel, channel->_Tone);
+
     // Enable tone or noise mode for channel A, B or C.
     int32_t ah = (1 << (_Driver._CurrentChannel - 1)) | (1 << (_Driver._CurrentChannel + 2));
 
@@ -581,6 +625,9 @@ void pmd_driver_t::SSGKeyOff(channel_t * channel)
     if (channel->_Tone == 0xFF)
         return;
 
+    if (_Events != nullptr)
+        RecordKeyOff(channel);
+
     if (channel->_SSGEnvelopFlag != -1)
         channel->_SSGEnvelopFlag = 2;
     else
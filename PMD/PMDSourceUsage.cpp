@@ -0,0 +1,313 @@
+
+/** $VER: PMDSourceUsage.cpp (2026.10.19) PMD driver (Based on PMDWin code by C60 / Masahiro Kajihara) **/
+
+#include <pch.h>
+
+#include "PMD.h"
+
+/// <summary>
+/// Identifies the command set a part is decoded with.
+/// </summary>
+enum class part_type_t
+{
+    FM,
+    SSG,
+    ADPCM,
+    P86,
+    Rhythm,
+    PPZ8,
+};
+
+/// <summary>
+/// Gets the number of operand bytes of a command or -1 if the command is unknown. The driver ends a part on an unknown command.
+/// </summary>
+static int32_t GetCommandLength(part_type_t type, const uint8_t * si) noexcept
+{
+    switch (si[0])
+    {
+        // Tempo: 'T' takes 1 byte, 't', 'T±' and 't±' take a prefix and a value.
+        case 0xFC: return (si[1] < 0xFB) ? 1 : 2;
+
+        // Channel mask: values of 2 and higher select an individual sound source volume command with an operand.
+        case 0xC0:
+        {
+            if (si[1] < 2)
+                return 1;
+
+            return (si[1] >= 0xF5) ? 2 : -1;
+        }
+
+        // Portamento: the P86 and rhythm parts skip the note pair.
+        case 0xDA: return ((type == part_type_t::P86) || (type == part_type_t::Rhythm)) ? 1 : 3;
+
+        case 0xFB: case 0xF6: case 0xF4: case 0xF3: case 0xC1:
+            return 0;
+
+        case 0xFF: case 0xFE: case 0xFD: case 0xF5: case 0xF1: case 0xEE: case 0xED: case 0xEC: case 0xEB: case 0xEA: case 0xE9: case 0xE8: case 0xE7: case 0xE6: case 0xE4: case 0xE3: case 0xE2: case 0xE1: case 0xE0:
+        case 0xDF: case 0xDE: case 0xDD: case 0xDC: case 0xDB: case 0xD9: case 0xD8: case 0xD7: case 0xD4: case 0xD3: case 0xD2: case 0xD1: case 0xD0:
+        case 0xCF: case 0xCC: case 0xCB: case 0xCA: case 0xC9: case 0xC5: case 0xC4: case 0xC2:
+        case 0xBE: case 0xBC: case 0xBB: case 0xBA: case 0xB9: case 0xB7: case 0xB6: case 0xB3: case 0xB2: case 0xB1:
+            return 1;
+
+        case 0xFA: case 0xF9: case 0xF7: case 0xEF: case 0xE5: case 0xD6: case 0xD5: case 0xC3: case 0xBD: case 0xB8: case 0xB5:
+            return 2;
+
+        case 0xC8: case 0xC7:
+            return 3;
+
+        case 0xF8: case 0xF2: case 0xF0: case 0xBF:
+            return 4;
+
+        case 0xCD:
+            return 5;
+
+        case 0xCE: case 0xC6:
+            return 6;
+
+        case 0xB4:
+            return 16;
+
+        default:
+            return -1;
+    }
+}
+
+/// <summary>
+/// Adds a part that is started by a command of another part, unless it is not set or has been added before.
+/// </summary>
+static void AddPart(std::vector<std::pair<size_t, part_type_t>> & parts, uint16_t offset, part_type_t type)
+{
+    if ((offset != 0) && (std::find(parts.begin(), parts.end(), std::make_pair((size_t) offset, type)) == parts.end()))
+        parts.push_back({ offset, type });
+}
+
+/// <summary>
+/// Determines which sound sources and chip channels the loaded song can ever use by scanning the command streams of all its parts once.
+/// Returns false if a part runs past the end of the song, a command is cut off or a loop command does not refer to its counterpart.
+/// </summary>
+bool pmd_driver_t::AnalyzeSourceUsage(size_t size) noexcept
+{
+    _Usage = { };
+
+    const uint8_t * Data = &_MData[1];
+    const size_t Size = size - 1;
+
+    const uint8_t Version = _MData[0];
+    const uint16_t * Offsets = (const uint16_t *) Data;
+
+    std::vector<std::pair<size_t, part_type_t>> Parts;
+
+    for (size_t i = 0; i < MaxFMChannels; ++i)
+        Parts.push_back({ Offsets[i], part_type_t::FM });
+
+    // The SSG, ADPCM and rhythm parts only exist in .M or .M2 files targeting PC-98/PC-88/X68000 systems.
+    if (Version == 0x00)
+    {
+        for (size_t i = 0; i < MaxSSGChannels; ++i)
+            Parts.push_back({ Offsets[MaxFMChannels + i], part_type_t::SSG });
+
+        Parts.push_back({ Offsets[MaxFMChannels + MaxSSGChannels],     _IsUsingP86 ? part_type_t::P86 : part_type_t::ADPCM });
+        Parts.push_back({ Offsets[MaxFMChannels + MaxSSGChannels + 1], part_type_t::Rhythm });
+    }
+
+    // The command at each position of the song. The loop commands are checked against it once all parts have been scanned.
+    std::vector<uint8_t> Commands(Size);
+    std::vector<std::pair<size_t, uint8_t>> LoopTargets;
+
+    // The parts are processed as a work list because the FM3 extension and PPZ8 parts are started by commands in other parts.
+    for (size_t j = 0; j < Parts.size(); ++j)
+    {
+        const auto [ Offset, Type ] = Parts[j];
+
+        if (Offset >= Size)
+        {
+            _Usage.SetAll();
+
+            return false;
+        }
+
+        if (Data[Offset] == 0x80)
+            continue;
+
+        switch (Type)
+        {
+            case part_type_t::FM:
+            {
+                // The FM3 extension parts are added after the standard parts.
+                if (j < MaxFMChannels)
+                    _Usage.FMChannels |= 1u << j;
+                else
+                {
+                    _Usage.FMChannels |= 0x04;
+                    _Usage.UsesFMExtension = true;
+                }
+                break;
+            }
+
+            case part_type_t::SSG:
+            {
+                _Usage.SSGChannels |= 1u << (j - MaxFMChannels);
+                break;
+            }
+
+            case part_type_t::ADPCM:
+            case part_type_t::P86:
+            {
+                _Usage.UsesADPCM = true;
+                break;
+            }
+
+            // The rhythm patterns play SSG drums on SSG channel 3 or PPS drums.
+            case part_type_t::Rhythm:
+            {
+                _Usage.UsesSSGEffects = true;
+                _Usage.SSGChannels |= 0x04;
+                break;
+            }
+
+            case part_type_t::PPZ8:
+            {
+                _Usage.UsesPPZ8 = true;
+                break;
+            }
+        }
+
+        size_t i = Offset;
+        bool IsValid = true;
+
+        // A part ends with an end marker or an unknown command. Something has to follow every other command.
+        while (IsValid && (Data[i] != 0x80))
+        {
+            const uint8_t Command = Data[i];
+
+            if (i + 1 >= Size)
+            {
+                IsValid = false;
+                break;
+            }
+
+            if (Command < 0x80)
+            {
+                // The rhythm part only refers to a rhythm pattern.
+                if (Type == part_type_t::Rhythm)
+                {
+                    const size_t Entry = (size_t) Offsets[MaxFMChannels + MaxSSGChannels + 2] + (size_t) Command * 2;
+
+                    IsValid = (Entry + 2 <= Size) && (*(const uint16_t *) &Data[Entry] < Size);
+
+                    i += 1;
+                }
+                else
+                {
+                    // Note and length
+                    IsValid = (i + 2 < Size);
+
+                    i += 2;
+                }
+
+                continue;
+            }
+
+            const int32_t Length = GetCommandLength(Type, &Data[i]);
+
+            // The driver ends a part on an unknown command.
+            if (Length < 0)
+                break;
+
+            if (i + 1 + (size_t) Length >= Size)
+            {
+                IsValid = false;
+                break;
+            }
+
+            Commands[i] = Command;
+
+            const uint8_t * si = &Data[i + 1];
+
+            switch (Command)
+            {
+                // FM channel 3 extension
+                case 0xC6:
+                {
+                    if (Type != part_type_t::FM)
+                        break;
+
+                    for (size_t k = 0; k < MaxFMExtensionChannels; ++k)
+                        AddPart(Parts, ((const uint16_t *) si)[k], part_type_t::FM);
+                    break;
+                }
+
+                // PPZ8 initialization
+                case 0xB4:
+                {
+                    if ((Type != part_type_t::ADPCM) && (Type != part_type_t::P86))
+                        break;
+
+                    for (size_t k = 0; k < MaxPPZ8Channels; ++k)
+                        AddPart(Parts, ((const uint16_t *) si)[k], part_type_t::PPZ8);
+                    break;
+                }
+
+                // SSG sound effect. Played on SSG channel 3 or by the PPS.
+                case 0xD4:
+                {
+                    _Usage.UsesSSGEffects = true;
+                    _Usage.SSGChannels |= 0x04;
+                    break;
+                }
+
+                // Direct register write. Any channel can be keyed on.
+                case 0xEF:
+                {
+                    _Usage.FMChannels  = 0x3F;
+                    _Usage.SSGChannels = 0x07;
+                    break;
+                }
+
+                // Start of loop: refers to the operands of the end of the loop.
+                case 0xF9:
+                {
+                    LoopTargets.push_back({ *(const uint16_t *) si, 0xF8 });
+                    break;
+                }
+
+                // End of loop: refers to the operand of the start of the loop.
+                case 0xF8:
+                {
+                    LoopTargets.push_back({ *(const uint16_t *) (si + 2), 0xF9 });
+                    break;
+                }
+
+                // Exit loop: refers to the operands of the end of the loop.
+                case 0xF7:
+                {
+                    LoopTargets.push_back({ *(const uint16_t *) si, 0xF8 });
+                    break;
+                }
+            }
+
+            i += 1 + (size_t) Length;
+        }
+
+        if (!IsValid)
+        {
+            _Usage.SetAll();
+
+            return false;
+        }
+    }
+
+    for (const auto & [ Target, Command ] : LoopTargets)
+    {
+        if ((Target == 0) || (Target > Size) || (Commands[Target - 1] != Command))
+        {
+            _Usage.SetAll();
+
+            return false;
+        }
+    }
+
+    UpdateChannelMask();
+
+    return true;
+}
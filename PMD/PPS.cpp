@@ -1,11 +1,12 @@
 
-/** $VER: PPS.cpp (2026.01.07) PCM driver for the SSG (Software-controlled Sound Generator) / Original Programmed by NaoNeko / Modified by Kaja / Windows Converted by C60 **/
+/** $VER: PPS.cpp (2026.10.19) PCM driver for the SSG (Software-controlled Sound Generator) / Original Programmed by NaoNeko / Modified by Kaja / Windows Converted by C60 **/
 
 #include <pch.h>
 
 #include "PPS.h"
+#include "RegisterLog.h"
 
-pps_t::pps_t(File * file) : _File(file), _Samples()
+pps_t::pps_t(File * file) : _File(file), _RegisterLog(), _EmitTable(), _Samples()
 {
     Reset();
 }
@@ -78,6 +79,9 @@ void pps_t::Reset()
 /// </summary>
 bool pps_t::Stop(void)
 {
+    if ((_RegisterLog != nullptr) && _RegisterLog->Add(pcm_call_t::PPSStop))
+        return true;
+
     _IsPlaying = false;
 
     _Data1 = nullptr;
@@ -94,6 +98,9 @@ bool pps_t::Stop(void)
 /// </summary>
 bool pps_t::Start(int sampleNumber, int toneShift, int volumeShift)
 {
+    if ((_RegisterLog != nullptr) && _RegisterLog->Add(pcm_call_t::PPSStart, sampleNumber, toneShift, volumeShift))
+        return true;
+
     const auto & PPSSample = _Header.PPSSamples[sampleNumber];
 
     if (PPSSample._Offset == 0)
@@ -301,19 +308,27 @@ bool pps_t::SetSampleRate(uint32_t sampleRate, bool useInterpolation)
 }
 
 /// <summary>
-/// Sets the volume.
+/// Sets the volume. The emit tables are shared by all instances.
 /// </summary>
 void pps_t::SetVolume(int volume)
 {
-    double Base = 0x4000 * 2 / 3.0 * std::pow(10.0, volume / 40.0);
+    if ((_RegisterLog != nullptr) && _RegisterLog->Add(pcm_call_t::PPSSetVolume, volume))
+        return;
 
-    for (int32_t i = 15; i >= 1; --i)
+    const auto & Table = shared_table_t<emit_table_t, pps_t>::Get(volume, [volume](emit_table_t & table)
     {
-        _EmitTable[i] = (int32_t) Base;
-        Base /= 1.189207115;
-    }
+        double Base = 0x4000 * 2 / 3.0 * std::pow(10.0, volume / 40.0);
+
+        for (int32_t i = 15; i >= 1; --i)
+        {
+            table.Values[i] = (int32_t) Base;
+            Base /= 1.189207115;
+        }
+
+        table.Values[0] = 0;
+    });
 
-    _EmitTable[0] = 0;
+    _EmitTable = Table.Values;
 }
 
 /// <summary>
@@ -345,9 +360,7 @@ void pps_t::Mix(frame32_t * frames, size_t frameCount) noexcept
     if (!_IsPlaying && (_KeyOffVolume == 0))
         return;
 
-    auto Samples = (sample_t *) frames;
-
-    for (size_t i = 0; i < frameCount; ++i)
+    auto Fetch = [this]() noexcept -> sample_t
     {
         int l1, l2, h1, h2;
 
@@ -379,15 +392,15 @@ void pps_t::Mix(frame32_t * frames, size_t frameCount) noexcept
         else
             h1 = h2 = 0;
 
-        sample_t Sample = _UseInterpolation ? (_EmitTable[l1] * (0x10000 - _DataXOr1) + _EmitTable[l2] * _DataXOr1 + _EmitTable[h1] * (0x10000 - _DataXOr2) + _EmitTable[h2] * _DataXOr2) / 0x10000 : (_EmitTable[l1] + _EmitTable[h1]);
+        const sample_t Sample = _UseInterpolation ? (_EmitTable[l1] * (0x10000 - _DataXOr1) + _EmitTable[l2] * _DataXOr1 + _EmitTable[h1] * (0x10000 - _DataXOr2) + _EmitTable[h2] * _DataXOr2) / 0x10000 : (_EmitTable[l1] + _EmitTable[h1]);
 
         _KeyOffVolume = (_KeyOffVolume * 255) / 256;
 
-        Sample += _KeyOffVolume;
-
-        *Samples++ += Sample;
-        *Samples++ += Sample;
+        return Sample + _KeyOffVolume;
+    };
 
+    auto Advance = [this]() noexcept -> bool
+    {
         if (_Size2 > 1)
         {
             _DataXOr2 += _TickXOr2;
@@ -473,5 +486,9 @@ void pps_t::Mix(frame32_t * frames, size_t frameCount) noexcept
                 _Data2 = nullptr;
             }
         }
-    }
+
+        return true;
+    };
+
+    voice_mixer::Mix<false>((sample_t *) frames, frameCount, voice_mixer::pan_center_t(), Fetch, Advance);
 }
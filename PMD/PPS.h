@@ -1,9 +1,10 @@
 
-/** $VER: PPS.h (2026.01.07) PCM driver for the SSG (Software-controlled Sound Generator) / Original Programmed by NaoNeko / Modified by Kaja / Windows Converted by C60 **/
+/** $VER: PPS.h (2026.10.19) PCM driver for the SSG (Software-controlled Sound Generator) / Original Programmed by NaoNeko / Modified by Kaja / Windows Converted by C60 **/
 
 #pragma once
 
 #include "OPNA.h"
+#include "SharedTable.h"
 
 #define PPS_VERSION     "0.37"
 
@@ -36,6 +37,8 @@ struct PPSHEADER
 
 const size_t PPSHEADERSIZE = (sizeof(uint16_t) * 2 + sizeof(uint8_t) * 2) * MAX_PPS;
 
+class register_log_t;
+
 #pragma warning(disable: 4820) // 'x' bytes padding added after data member 'y'
 
 /// <summary>
@@ -56,6 +59,8 @@ public:
     bool SetSampleRate(uint32_t r, bool ip);
     void SetVolume(int volume);
 
+    void SetRegisterLog(register_log_t * log) noexcept { _RegisterLog = log; } // Sets the log that receives the calls that affect playback. Specify nullptr to stop logging. See register_log_t::SetLogOnly().
+
     void Mix(frame32_t * frames, size_t frameCount) noexcept;
 
     int Load(const WCHAR * filePath);
@@ -64,8 +69,14 @@ private:
     void Reset(void);
     void ReadHeader(File * file, PPSHEADER & ph);
 
+    struct emit_table_t
+    {
+        sample_t Values[16];
+    };
+
 private:
     File * _File;
+    register_log_t * _RegisterLog;
 
     PPSHEADER _Header;
     WCHAR _FilePath[_MAX_PATH];
@@ -73,7 +84,7 @@ private:
     int _SampleRate;
     bool _UseInterpolation;
 
-    sample_t _EmitTable[16];
+    const sample_t * _EmitTable;
 
     sample_t * _Samples;
 
@@ -1,9 +1,10 @@
 
-/** $VER: PPZ8.h (2026.01.07) PC-98's 86 soundboard's 8 PCM driver (Programmed by UKKY / Based on Windows conversion by C60) **/
+/** $VER: PPZ8.h (2026.10.19) PC-98's 86 soundboard's 8 PCM driver (Programmed by UKKY / Based on Windows conversion by C60) **/
 
 #pragma once
 
 #include "OPNA.h"
+#include "SharedTable.h"
 
 #define PPZ8_VERSION        "1.07"
 
@@ -108,6 +109,8 @@ public:
     bool _IsPVI;
 };
 
+class register_log_t;
+
 #pragma warning(disable: 4820) // 'x' bytes padding added after data member 'y'
 
 /// <summary>
@@ -172,13 +175,18 @@ public:
 //  FIFOBUFF_SET; // 1AH (PPZ8)FIFOﾊﾞｯﾌｧの変更
 //  RATE_SET; // 1BH (PPZ8)WSS詳細ﾚｰﾄ設定
 
+    void SetRegisterLog(register_log_t * log) noexcept { _RegisterLog = log; } // Sets the log that receives the calls that affect playback. Specify nullptr to stop logging. See register_log_t::SetLogOnly().
+
     void Mix(frame32_t * frames, size_t frameCount) noexcept;
+    void MixStems(frame32_t * const * frames, size_t frameCount) noexcept;
 
 public:
     ppz_bank_t _PPZBanks[2];
 
 private:
-    void MoveSamplePointer(ppz_channel_t & channel) const noexcept;
+    void MixChannel(ppz_channel_t & channel, frame32_t * frames, size_t frameCount) noexcept;
+    template<int32_t PanValue, bool UseInterpolation>
+    void MixRuns(ppz_channel_t & channel, frame32_t * frames, size_t frameCount) const noexcept;
 
     void InitializeInternal() noexcept;
 
@@ -186,8 +194,14 @@ private:
     void ReadHeader(File * file, PZIHEADER & pziheader);
     void ReadHeader(File * file, PVIHEADER & pviheader);
 
+    struct volume_table_t
+    {
+        sample_t Rows[16 + 15][256]; // One row per sum of channel volume and master volume.
+    };
+
 private:
     File * _File;
+    register_log_t * _RegisterLog;
 
     bool _EmulateADPCM; // Should channel 8 emulate ADPCM?
     bool _UseInterpolation;
@@ -198,5 +212,5 @@ private:
     int32_t _Volume;
     int32_t _SampleRate;
 
-    sample_t _VolumeTable[16][256];
+    const sample_t (* _VolumeTable)[256]; // Row 0 of the shared volume table, offset by the master volume.
 };
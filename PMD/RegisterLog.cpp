@@ -0,0 +1,308 @@
+
+/** $VER: RegisterLog.cpp (2026.10.19) Timestamped log of OPNA register writes **/
+
+#include <pch.h>
+
+#include "RegisterLog.h"
+#include "OPNA.h"
+#include "PPZ8.h"
+#include "P86.h"
+#include "PPS.h"
+
+/// <summary>
+/// Removes all writes from the log.
+/// </summary>
+void register_log_t::Clear() noexcept
+{
+    _Entries.clear();
+    _Calls.clear();
+
+    _Time = 0;
+    _Duration = 0;
+    _LoopTime = NoLoop;
+    _CompileTime = 0;
+    _Mode = 0xFF;
+
+    ::memset(_Values, 0xFF, sizeof(_Values));
+}
+
+/// <summary>
+/// Adds a register write at the current time.
+/// </summary>
+void register_log_t::Add(uint32_t reg, uint32_t value)
+{
+    if (reg < _countof(_Values))
+        _Values[reg] = (int16_t) (value & 0xFF);
+
+    // The log provides its own timing. Of the timer registers only the channel 3 mode in register 0x27 is kept.
+    if ((reg >= 0x24) && (reg <= 0x27))
+    {
+        if (reg != 0x27)
+            return;
+
+        value &= 0xC0;
+
+        if (value == _Mode)
+            return;
+
+        _Mode = value;
+    }
+
+    _Entries.push_back({ _Time, (uint16_t) reg, (uint8_t) value, 0 });
+}
+
+/// <summary>
+/// Adds a call of a software PCM driver at the current time. Returns true if the driver should not execute the call (see SetLogOnly()).
+/// </summary>
+bool register_log_t::Add(pcm_call_t function, int32_t arg1, int32_t arg2, int32_t arg3, int32_t arg4, int32_t arg5)
+{
+    _Calls.push_back({ _Time, function, { }, { arg1, arg2, arg3, arg4, arg5 } });
+
+    return _IsLogOnly;
+}
+
+/// <summary>
+/// Gets the last value written to the specified register. Returns false if the register has not been written since the log was cleared.
+/// </summary>
+bool register_log_t::GetValue(uint32_t reg, uint32_t & value) const noexcept
+{
+    if ((reg >= _countof(_Values)) || (_Values[reg] < 0))
+        return false;
+
+    value = (uint32_t) _Values[reg];
+
+    return true;
+}
+
+/// <summary>
+/// Gets the index of the first write at or after the specified time (in samples).
+/// </summary>
+size_t register_log_t::Find(uint32_t time) const noexcept
+{
+    const auto it = std::lower_bound(_Entries.begin(), _Entries.end(), time, [](const entry_t & entry, uint32_t time) { return entry.Time < time; });
+
+    return (size_t) (it - _Entries.begin());
+}
+
+/// <summary>
+/// Brings a chip and the PCM drivers to the state they have at the specified time (in samples) by replaying the writes and calls before it. Specify nullptr for the PCM drivers that should be left alone.
+/// The chip only receives the last value of each register, followed by the key on/off state of each FM channel and the ADPCM control. The notes held at that time start again, the same as when the driver had written the registers without synthesizing audio.
+/// Rhythm key ons (0x10) are one-shots and are dropped. The timer control (0x27) is left alone because the timers belong to whoever drives the chip.
+/// The PCM driver calls are replayed in order. The drivers don't advance between calls so the samples that are still playing at that time start again.
+/// </summary>
+void register_log_t::Replay(opna_t & chip, ppz8_t * ppz8, p86_t * p86, pps_t * pps, uint32_t time) const
+{
+    const size_t Count = Find(time);
+
+    int16_t Values[0x200];
+    int16_t KeyOnOff[8]; // Last write to 0x28 of each channel
+    uint32_t Prescaler = 0;
+
+    ::memset(Values, 0xFF, sizeof(Values));
+    ::memset(KeyOnOff, 0xFF, sizeof(KeyOnOff));
+
+    for (size_t i = 0; i < Count; ++i)
+    {
+        const entry_t & Entry = _Entries[i];
+
+        if (Entry.Register == 0x28)
+            KeyOnOff[Entry.Value & 0x07] = Entry.Value;
+        else
+        {
+            if ((Entry.Register >= 0x2D) && (Entry.Register <= 0x2F))
+                Prescaler = Entry.Register; // Only the last one selected counts.
+
+            Values[Entry.Register] = Entry.Value;
+        }
+    }
+
+    if (Prescaler != 0)
+        chip.SetReg(Prescaler, (uint32_t) Values[Prescaler]);
+
+    auto IsFrequency = [](uint32_t reg) { return ((reg & 0xF0) == 0xA0) && ((reg & 0x03) != 0x03); };
+
+    for (uint32_t Register = 0; Register < _countof(Values); ++Register)
+    {
+        if (Values[Register] < 0)
+            continue;
+
+        if ((Register == 0x10) || (Register == 0x27) || ((Register >= 0x2D) && (Register <= 0x2F)) || (Register == 0x100) || (Register == 0x108))
+            continue; // Rhythm key on, timer control, prescaler (already written), ADPCM control (written last) and ADPCM data port
+
+        if (IsFrequency(Register))
+        {
+            // The upper half of a frequency only takes effect when the lower half is written. Write it right before its lower half.
+            if (Register & 0x04)
+            {
+                if (Values[Register & ~0x04u] >= 0)
+                    continue;
+            }
+            else
+            if (Values[Register | 0x04] >= 0)
+                chip.SetReg(Register | 0x04, (uint32_t) Values[Register | 0x04]);
+        }
+
+        chip.SetReg(Register, (uint32_t) Values[Register]);
+    }
+
+    // The start bit restarts the ADPCM sample that was playing. The start address and the rate have been written above.
+    if (Values[0x100] >= 0)
+        chip.SetReg(0x100, (uint32_t) Values[0x100]);
+
+    for (const int16_t Value : KeyOnOff)
+    {
+        if (Value >= 0)
+            chip.SetReg(0x28, (uint32_t) Value);
+    }
+
+    const auto End = std::lower_bound(_Calls.begin(), _Calls.end(), time, [](const call_t & call, uint32_t time) { return call.Time < time; });
+
+    for (auto Call = _Calls.begin(); Call < End; ++Call)
+    {
+        const int32_t * Args = Call->Arguments;
+
+        switch (Call->Function)
+        {
+            case pcm_call_t::PPZ8Play:            if (ppz8 != nullptr) ppz8->Play((size_t) Args[0], Args[1], Args[2], (uint16_t) Args[3], (uint16_t) Args[4]); break;
+            case pcm_call_t::PPZ8Stop:            if (ppz8 != nullptr) ppz8->Stop((size_t) Args[0]); break;
+            case pcm_call_t::PPZ8SetInstrument:   if (ppz8 != nullptr) ppz8->SetInstrument((size_t) Args[0], (size_t) Args[1], (size_t) Args[2]); break;
+            case pcm_call_t::PPZ8SetVolume:       if (ppz8 != nullptr) ppz8->SetVolume((size_t) Args[0], Args[1]); break;
+            case pcm_call_t::PPZ8SetPitch:        if (ppz8 != nullptr) ppz8->SetPitch((size_t) Args[0], (uint32_t) Args[1]); break;
+            case pcm_call_t::PPZ8SetLoop:         if (ppz8 != nullptr) ppz8->SetLoop((size_t) Args[0], (size_t) Args[1], (size_t) Args[2], Args[3], Args[4]); break;
+            case pcm_call_t::PPZ8SetPan:          if (ppz8 != nullptr) ppz8->SetPan((size_t) Args[0], Args[1]); break;
+            case pcm_call_t::PPZ8SetMasterVolume: if (ppz8 != nullptr) ppz8->SetVolume(Args[0]); break;
+
+            case pcm_call_t::P86Start:            if (p86 != nullptr) p86->Start(); break;
+            case pcm_call_t::P86Stop:             if (p86 != nullptr) p86->Stop(); break;
+            case pcm_call_t::P86Keyoff:           if (p86 != nullptr) p86->Keyoff(); break;
+            case pcm_call_t::P86SetVolume:        if (p86 != nullptr) p86->SetVolume(Args[0]); break;
+            case pcm_call_t::P86SetPitch:         if (p86 != nullptr) p86->SetPitch(Args[0], (uint32_t) Args[1]); break;
+            case pcm_call_t::P86SetPan:           if (p86 != nullptr) p86->SetPan(Args[0], Args[1]); break;
+            case pcm_call_t::P86SelectSample:     if (p86 != nullptr) p86->SelectSample(Args[0]); break;
+            case pcm_call_t::P86SetLoop:          if (p86 != nullptr) p86->SetLoop(Args[0], Args[1], Args[2], Args[3] != 0); break;
+
+            case pcm_call_t::PPSStart:            if (pps != nullptr) pps->Start(Args[0], Args[1], Args[2]); break;
+            case pcm_call_t::PPSStop:             if (pps != nullptr) pps->Stop(); break;
+            case pcm_call_t::PPSSetVolume:        if (pps != nullptr) pps->SetVolume(Args[0]); break;
+        }
+    }
+}
+
+/// <summary>
+/// Writes the log as a VGM 1.51 file. The contents of the ADPCM RAM are stored in a data block because they are loaded before the song starts.
+/// The calls of the PCM drivers are left out: VGM has no way to represent the PPZ8, P86 and PPS.
+/// </summary>
+bool register_log_t::WriteVGM(const WCHAR * filePath, uint32_t clockSpeed, const std::vector<uint8_t> & adpcmRAM) const
+{
+    std::vector<uint8_t> Data(0x100);
+
+    auto Set32 = [&Data](size_t offset, uint32_t value)
+    {
+        Data[offset    ] = (uint8_t) (value      );
+        Data[offset + 1] = (uint8_t) (value >>  8);
+        Data[offset + 2] = (uint8_t) (value >> 16);
+        Data[offset + 3] = (uint8_t) (value >> 24);
+    };
+
+    auto Add8 = [&Data](uint32_t value)
+    {
+        Data.push_back((uint8_t) value);
+    };
+
+    auto Add32 = [&Data](uint32_t value)
+    {
+        for (int i = 0; i < 32; i += 8)
+            Data.push_back((uint8_t) (value >> i));
+    };
+
+    uint32_t Time = 0;
+
+    auto Wait = [&Time, &Add8](uint32_t time)
+    {
+        while (Time < time)
+        {
+            const uint32_t Samples = std::min(time - Time, 0xFFFFu);
+
+            Add8(0x61); // Wait n samples
+            Add8(Samples & 0xFF);
+            Add8(Samples >> 8);
+
+            Time += Samples;
+        }
+    };
+
+    ::memcpy(Data.data(), "Vgm ", 4);
+
+    Set32(0x08, 0x151);         // Version
+    Set32(0x34, 0x100 - 0x34);  // Relative offset of the VGM data
+    Set32(0x48, clockSpeed);    // YM2608 clock
+
+    if (!adpcmRAM.empty())
+    {
+        Add8(0x67); // Data block
+        Add8(0x66);
+        Add8(0x81); // YM2608 DELTA-T ROM/RAM data
+        Add32((uint32_t) adpcmRAM.size() + 8);
+        Add32((uint32_t) adpcmRAM.size()); // Size of the RAM
+        Add32(0);                           // Start address
+
+        Data.insert(Data.end(), adpcmRAM.begin(), adpcmRAM.end());
+    }
+
+    const bool HasLoop = (_LoopTime != NoLoop) && (_LoopTime < _Duration);
+
+    size_t LoopOffset = 0;
+
+    for (const auto & Entry : _Entries)
+    {
+        // Writes at the end belong to the next pass through the loop.
+        if (Entry.Time >= _Duration)
+            break;
+
+        if (HasLoop && (LoopOffset == 0) && (Entry.Time >= _LoopTime))
+        {
+            Wait(_LoopTime);
+
+            LoopOffset = Data.size();
+        }
+
+        Wait(Entry.Time);
+
+        Add8((Entry.Register < 0x100) ? 0x56 : 0x57); // YM2608 port 0 or 1
+        Add8(Entry.Register & 0xFF);
+        Add8(Entry.Value);
+    }
+
+    if (HasLoop && (LoopOffset == 0))
+    {
+        Wait(_LoopTime);
+
+        LoopOffset = Data.size();
+    }
+
+    Wait(_Duration);
+
+    Add8(0x66); // End of sound data
+
+    Set32(0x04, (uint32_t) Data.size() - 0x04); // Relative offset of the end of the file
+    Set32(0x18, _Duration);                     // Total number of samples
+
+    if (HasLoop)
+    {
+        Set32(0x1C, (uint32_t) LoopOffset - 0x1C); // Relative offset of the loop point
+        Set32(0x20, _Duration - _LoopTime);         // Number of samples in the loop
+    }
+
+    HANDLE hFile = ::CreateFileW(filePath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    DWORD BytesWritten = 0;
+
+    const bool Success = ::WriteFile(hFile, Data.data(), (DWORD) Data.size(), &BytesWritten, nullptr) && (BytesWritten == Data.size());
+
+    ::CloseHandle(hFile);
+
+    return Success;
+}
@@ -0,0 +1,127 @@
+
+/** $VER: RegisterLog.h (2026.10.19) Timestamped log of OPNA register writes **/
+
+#pragma once
+
+#include <windows.h>
+
+#include <stdint.h>
+
+#include <vector>
+
+class opna_t;
+class ppz8_t;
+class p86_t;
+class pps_t;
+
+#pragma warning(disable: 4820) // x bytes padding added after last data member
+
+/// <summary>
+/// Identifies a call of one of the software PCM drivers (PPZ8, P86 and PPS). The comments list the arguments.
+/// </summary>
+enum class pcm_call_t : uint8_t
+{
+    PPZ8Play,           // Channel, bank, sample, start, stop
+    PPZ8Stop,           // Channel
+    PPZ8SetInstrument,  // Channel, bank, instrument
+    PPZ8SetVolume,      // Channel, volume
+    PPZ8SetPitch,       // Channel, pitch
+    PPZ8SetLoop,        // Channel, bank, instrument, loop start, loop end
+    PPZ8SetPan,         // Channel, pan
+    PPZ8SetMasterVolume,// Volume
+
+    P86Start,
+    P86Stop,
+    P86Keyoff,
+    P86SetVolume,       // Volume
+    P86SetPitch,        // Sample rate index, pitch
+    P86SetPan,          // Flags, value
+    P86SelectSample,    // Sample
+    P86SetLoop,         // Loop start, loop end, release start, ADPCM compatibility
+
+    PPSStart,           // Sample, tone shift, volume shift
+    PPSStop,
+    PPSSetVolume,       // Volume
+};
+
+/// <summary>
+/// Implements a timestamped log of the register writes of an OPNA and of the calls of the software PCM drivers. A song compiled into a log can be replayed up to any position without running the driver or be exported as a VGM file.
+/// </summary>
+class register_log_t
+{
+public:
+    register_log_t() noexcept : _IsLogOnly() { Clear(); }
+
+    /// <summary>
+    /// Represents a register write (8 bytes).
+    /// </summary>
+    struct entry_t
+    {
+        uint32_t Time;      // in samples at SampleRate
+        uint16_t Register;  // 0x000-0x1FF
+        uint8_t Value;
+        uint8_t Reserved;
+    };
+
+    /// <summary>
+    /// Represents a call of a software PCM driver (28 bytes).
+    /// </summary>
+    struct call_t
+    {
+        uint32_t Time;      // in samples at SampleRate
+        pcm_call_t Function;
+        uint8_t Reserved[3];
+        int32_t Arguments[5];
+    };
+
+    void Clear() noexcept;
+    void Add(uint32_t reg, uint32_t value);
+    bool Add(pcm_call_t function, int32_t arg1 = 0, int32_t arg2 = 0, int32_t arg3 = 0, int32_t arg4 = 0, int32_t arg5 = 0);
+
+    bool GetValue(uint32_t reg, uint32_t & value) const noexcept;
+
+    size_t Find(uint32_t time) const noexcept;
+    void Replay(opna_t & chip, ppz8_t * ppz8, p86_t * p86, pps_t * pps, uint32_t time) const;
+
+    bool WriteVGM(const WCHAR * filePath, uint32_t clockSpeed, const std::vector<uint8_t> & adpcmRAM) const;
+
+    // Sets the time of the writes that are added next (in samples).
+    void SetTime(uint32_t time) noexcept { _Time = time; }
+
+    const std::vector<entry_t> & GetEntries() const noexcept { return _Entries; }
+    const std::vector<call_t> & GetCalls() const noexcept { return _Calls; }
+
+    // Gets the size of the log (in bytes).
+    size_t GetSize() const noexcept { return (_Entries.size() * sizeof(entry_t)) + (_Calls.size() * sizeof(call_t)); }
+
+    // Gets whether the devices only add their writes and calls to the log without executing them. Only the timer registers still reach the OPNA.
+    bool IsLogOnly() const noexcept { return _IsLogOnly; }
+    void SetLogOnly(bool value) noexcept { _IsLogOnly = value; }
+
+    uint32_t GetDuration() const noexcept { return _Duration; }
+    void SetDuration(uint32_t time) noexcept { _Duration = time; }
+
+    uint32_t GetLoopTime() const noexcept { return _LoopTime; }
+    void SetLoopTime(uint32_t time) noexcept { _LoopTime = time; }
+
+    // Gets the time it took to compile the log (in ms).
+    uint32_t GetCompileTime() const noexcept { return _CompileTime; }
+    void SetCompileTime(uint32_t time) noexcept { _CompileTime = time; }
+
+    static const uint32_t SampleRate = 44100; // The rate of the timestamps, the same as the one used by VGM files.
+    static const uint32_t NoLoop = ~0u;
+
+private:
+    std::vector<entry_t> _Entries;
+    std::vector<call_t> _Calls;
+
+    uint32_t _Time;         // Time of the writes that are added next (in samples)
+    uint32_t _Duration;     // in samples
+    uint32_t _LoopTime;     // in samples
+    uint32_t _CompileTime;  // in ms
+
+    uint32_t _Mode;         // Last channel 3 mode written to register 0x27
+    int16_t _Values[0x200]; // Last value written to each register, or -1
+
+    bool _IsLogOnly;
+};
@@ -0,0 +1,40 @@
+
+/** $VER: SharedTable.h (2026.10.19) P. Stuer **/
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+/// <summary>
+/// Holds process-wide, read-only lookup tables that are built once per key on first use and shared by all instances of the owner.
+/// </summary>
+template<typename T, typename Owner>
+class shared_table_t
+{
+public:
+    /// <summary>
+    /// Gets the table for the specified key, building it with the specified function if it does not exist yet.
+    /// </summary>
+    template<typename F>
+    static const T & Get(int32_t key, F build)
+    {
+        std::lock_guard<std::mutex> Lock(_Mutex);
+
+        auto & Table = _Tables[key];
+
+        if (Table == nullptr)
+        {
+            Table = std::make_unique<T>();
+
+            build(*Table);
+        }
+
+        return *Table;
+    }
+
+private:
+    static inline std::mutex _Mutex;
+    static inline std::map<int32_t, std::unique_ptr<T>> _Tables;
+};
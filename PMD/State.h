@@ -1,5 +1,5 @@
 
-/** $VER: State.h (2026.01.07) Driver state (Based on PMDWin code by C60 / Masahiro Kajihara) **/
+/** $VER: State.h (2026.10.19) Driver state (Based on PMDWin code by C60 / Masahiro Kajihara) **/
 
 #pragma once
 
@@ -13,6 +13,8 @@
 #define ERR_WRONG_PARTNO           32
 #define ERR_NOT_MASKED             33 // The specified part is not masked.
 #define ERR_EFFECT_USED            34 // The mask cannot be operated because it is being used by sound effects.
+#define ERR_COMMAND_LIMIT          35 // The parts executed more commands in a single tick than allowed.
+#define ERR_SIMULATION_LIMIT       36 // The song executed more commands than allowed while its length was determined.
 #define ERR_MUSIC_STOPPED          99 // You performed a mask operation while the song was stopped.
 
 #define ERR_UNKNOWN               999
@@ -114,6 +116,7 @@ public:
     uint8_t * _EData;                   // FM Effect data
 
     uint8_t * _InstrumentData;          // Address of the FM instrument definitions, if any.
+    uint8_t * _InstrumentIndex[256];    // Address of the first FM instrument definition with each number or nullptr, built when the instrument definitions are set.
 
     uint16_t * _RhythmDataTable;        // Rhythm Data table
     uint8_t * _RhythmData;              // Address of the rhythm definitions, if any.
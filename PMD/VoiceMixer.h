@@ -0,0 +1,103 @@
+
+/** $VER: VoiceMixer.h (2026.10.19) P. Stuer **/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+/// <summary>
+/// Mixes a single sample voice into an interleaved stereo buffer. The sample source, pan law and phase inversion are compile-time parameters so each combination compiles to its own branch-free loop.
+/// </summary>
+namespace voice_mixer
+{
+    /// <summary>
+    /// Outputs the sample on both channels.
+    /// </summary>
+    struct pan_center_t
+    {
+        void operator()(int32_t sample, int32_t & left, int32_t & right) const noexcept
+        {
+            left  = sample;
+            right = sample;
+        }
+    };
+
+    /// <summary>
+    /// Attenuates the right channel by Value / 128.
+    /// </summary>
+    struct pan_left_t
+    {
+        int32_t Value;
+
+        void operator()(int32_t sample, int32_t & left, int32_t & right) const noexcept
+        {
+            left  = sample;
+            right = sample * Value / (256 / 2);
+        }
+    };
+
+    /// <summary>
+    /// Attenuates the left channel by Value / 128.
+    /// </summary>
+    struct pan_right_t
+    {
+        int32_t Value;
+
+        void operator()(int32_t sample, int32_t & left, int32_t & right) const noexcept
+        {
+            left  = sample * Value / (256 / 2);
+            right = sample;
+        }
+    };
+
+    /// <summary>
+    /// Enables or disables each channel with a bit mask (0 or -1).
+    /// </summary>
+    struct pan_mask_t
+    {
+        int32_t MaskL;
+        int32_t MaskR;
+
+        void operator()(int32_t sample, int32_t & left, int32_t & right) const noexcept
+        {
+            left  = sample & MaskL;
+            right = sample & MaskR;
+        }
+    };
+
+    /// <summary>
+    /// Accumulates a value into an output sample, saturating when the output is 16-bit.
+    /// </summary>
+    template<typename T>
+    inline void Store(T & sample, int32_t value) noexcept
+    {
+        if constexpr(sizeof(T) == 2)
+            sample = (T) std::clamp(sample + value, -0x8000, 0x7FFF);
+        else
+            sample += value;
+    }
+
+    /// <summary>
+    /// Mixes up to frameCount frames. fetch() returns the current sample of the voice; advance() moves it forward and returns false when the voice has ended.
+    /// Returns false if the voice ended before the buffer was filled.
+    /// </summary>
+    template<bool PhaseReversed, typename T, typename Pan, typename Fetch, typename Advance>
+    inline bool Mix(T * frames, size_t frameCount, const Pan & pan, Fetch && fetch, Advance && advance) noexcept
+    {
+        for (size_t i = 0; i < frameCount; ++i, frames += 2)
+        {
+            int32_t Left, Right;
+
+            pan(fetch(), Left, Right);
+
+            Store(frames[0], Left);
+            Store(frames[1], PhaseReversed ? -Right : Right);
+
+            if (!advance())
+                return false;
+        }
+
+        return true;
+    }
+}
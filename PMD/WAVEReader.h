@@ -1,10 +1,16 @@
 
-/** $VER: WAVEReader.h (2026.01.07) P. Stuer **/
+/** $VER: WAVEReader.h (2026.10.19) P. Stuer **/
 
 #pragma once
 
 #include "RIFFReader.h"
 
+#include <vector>
+
+#define WAVE_FORMAT_PCM_        0x0001
+#define WAVE_FORMAT_IEEE_FLOAT_ 0x0003
+#define WAVE_FORMAT_EXTENSIBLE_ 0xFFFE
+
 /// <summary>
 /// Implements a reader for a RIFF WAVE file.
 /// </summary>
@@ -37,6 +43,85 @@ public:
     const uint8_t * Data() const noexcept { return _Data; }
     uint32_t Size() const noexcept { return _Size; }
 
+    /// <summary>
+    /// Gets the samples as mono values in the range [-1.0, 1.0]. Integer PCM (up to 32 bits in a container of 1 to 4 bytes) and IEEE float (32 or 64-bit) data is supported. Multiple channels are mixed down.
+    /// </summary>
+    bool GetSamples(std::vector<float> & samples) const
+    {
+        samples.clear();
+
+        const uint32_t ChannelCount = _Format.ChannelCount;
+        const uint32_t BitsPerSample = _Format.BitsPerSample;
+
+        if ((_Data == nullptr) || (ChannelCount == 0) || (BitsPerSample == 0))
+            return false;
+
+        // The samples of a frame are stored in containers of equal size that can be wider than the number of bits per sample, e.g. 20 or 24-bit samples in 4-byte containers.
+        const uint32_t ContainerSize = _Format.BlockAlign / ChannelCount;
+
+        if ((ContainerSize == 0) || (BitsPerSample > ContainerSize * 8))
+            return false;
+
+        const bool IsFloat = (_Format.Format == WAVE_FORMAT_IEEE_FLOAT_);
+
+        if (!IsFloat && (_Format.Format != WAVE_FORMAT_PCM_))
+            return false;
+
+        if (IsFloat && !(((ContainerSize == 4) && (BitsPerSample == 32)) || ((ContainerSize == 8) && (BitsPerSample == 64))))
+            return false;
+
+        if (!IsFloat && (ContainerSize > 4))
+            return false;
+
+        // The valid bits of an integer sample are left-justified in its container. Any bits below them are padding.
+        const uint32_t Mask = (BitsPerSample < 32) ? ~0u << (32 - BitsPerSample) : ~0u;
+
+        const size_t FrameCount = _Size / _Format.BlockAlign;
+
+        samples.resize(FrameCount);
+
+        const uint8_t * Frame = _Data;
+
+        for (size_t i = 0; i < FrameCount; ++i, Frame += _Format.BlockAlign)
+        {
+            double Sum = 0.;
+
+            for (uint32_t j = 0; j < ChannelCount; ++j)
+            {
+                const uint8_t * p = Frame + (j * ContainerSize);
+
+                if (IsFloat)
+                {
+                    if (ContainerSize == 4)
+                    {
+                        float Value; ::memcpy(&Value, p, sizeof(Value)); Sum += Value;
+                    }
+                    else
+                    {
+                        double Value; ::memcpy(&Value, p, sizeof(Value)); Sum += Value;
+                    }
+                }
+                else
+                {
+                    // Left-justify the little-endian container in 32 bits to sign-extend it.
+                    uint32_t Value = 0;
+
+                    for (uint32_t k = 0; k < ContainerSize; ++k)
+                        Value |= (uint32_t) p[k] << (8 * (4 - ContainerSize + k));
+
+                    if (ContainerSize == 1)
+                        Value ^= 0x80000000u; // 8-bit PCM is unsigned.
+
+                    Sum += (int32_t) (Value & Mask) / 2147483648.;
+                }
+            }
+
+            samples[i] = (float) std::clamp(Sum / ChannelCount, -1., 1.);
+        }
+
+        return true;
+    }
+
     virtual bool HandleChunk(uint32_t chunkId, uint32_t chunkSize)
     {
         switch (chunkId)
@@ -57,15 +142,28 @@ public:
         if (chunkSize < sizeof(ChunkFMT))
             return false;
 
-        DWORD Size = chunkSize + (chunkSize & 1);
+        const DWORD Size = chunkSize + (chunkSize & 1);
+
+        ChunkFMTEx Format = { };
+
+        const DWORD SizeToRead = std::min(Size, (DWORD) sizeof(Format));
 
         DWORD BytesRead;
 
-        BOOL Success = ::ReadFile(_hFile, &_Format, Size, &BytesRead, nullptr);
+        BOOL Success = ::ReadFile(_hFile, &Format, SizeToRead, &BytesRead, nullptr);
 
-        if (!(Success && (BytesRead == Size)))
+        if (!(Success && (BytesRead == SizeToRead)))
             return false;
 
+        if ((Size > SizeToRead) && (::SetFilePointer(_hFile, (LONG) (Size - SizeToRead), nullptr, FILE_CURRENT) == INVALID_SET_FILE_POINTER))
+            return false;
+
+        _Format = Format.Fmt;
+
+        // Use the actual format of an extensible format chunk. The first 2 bytes of the sub format GUID contain the format tag.
+        if ((_Format.Format == WAVE_FORMAT_EXTENSIBLE_) && (chunkSize >= sizeof(ChunkFMTEx)))
+            _Format.Format = (uint16_t) (Format.sub_format[0] | (Format.sub_format[1] << 8));
+
         return true;
     }
 
@@ -82,7 +180,7 @@ public:
         if ((chunkSize & 1) == 0)
             return true;
 
-        return (::SetFilePointer(_hFile, 1, nullptr, FILE_CURRENT) == 1);
+        return (::SetFilePointer(_hFile, 1, nullptr, FILE_CURRENT) != INVALID_SET_FILE_POINTER);
     }
 
 private:
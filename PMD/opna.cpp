@@ -1,5 +1,5 @@
 
-/** $VER: OPNA.cpp (2026.01.07) OPNA emulator (Based on PMDWin code by C60 / Masahiro Kajihara) **/
+/** $VER: OPNA.cpp (2026.10.19) OPNA emulator (Based on PMDWin code by C60 / Masahiro Kajihara) **/
 
 #include <pch.h>
 
@@ -25,17 +25,29 @@ opna_t::opna_t(File * file) :
 
     _Chip(*this),
     _Output(),
+    _ChannelOutputs(),
+
+    _ClockSpeed(0),
+    _SampleRate(0),
 
     _Pos(0),
     _Step(0),
 
-    _TickCount(0U)
+    _TickCount(0U),
+
+    _WriteCount(0U),
+    _ElidedWriteCount(0U),
+
+    _RegisterLog(nullptr)
 {
-    Initialize(DefaultClockSpeed, 8000U);
+    ResetShadowRegisters();
 
-    // Create the table.
-    for (int32_t i = -FM_TLPOS; i < FM_TLENTS; ++i)
-        tltable[i + FM_TLPOS] = (int32_t) (uint32_t(65536.0 * std::pow(2.0, i * -16.0 / (int32_t) FM_TLENTS)) - 1);
+    _Data[ymfm::ACCESS_ADPCM_B].reserve(0x40000); // 256 KB of ADPCM RAM
+
+    UpdateMemoryView(ymfm::ACCESS_ADPCM_A);
+    UpdateMemoryView(ymfm::ACCESS_ADPCM_B);
+
+    Initialize(DefaultClockSpeed, 8000U);
 }
 
 opna_t::~opna_t()
@@ -43,6 +55,24 @@ opna_t::~opna_t()
     DeleteInstruments();
 }
 
+/// <summary>
+/// Gets the total level table. It is built once on first use and shared by all instances.
+/// </summary>
+const int32_t * opna_t::GetTLTable() noexcept
+{
+    static const auto Table = []
+    {
+        std::array<int32_t, FM_TLENTS + FM_TLPOS> t = { };
+
+        for (int32_t i = -FM_TLPOS; i < FM_TLENTS; ++i)
+            t[(size_t) (i + FM_TLPOS)] = (int32_t) (uint32_t(65536.0 * std::pow(2.0, i * -16.0 / (int32_t) FM_TLENTS)) - 1);
+
+        return t;
+    }();
+
+    return Table.data();
+}
+
 /// <summary>
 /// Initializes the module.
 /// </summary>
@@ -55,6 +85,7 @@ bool opna_t::Initialize(uint32_t clockSpeed, uint32_t sampleRate, const WCHAR *
     _TickCount = 0U;
 
     _Chip.reset();
+    ResetShadowRegisters();
 
     SetFMVolume(0);
     SetSSGVolume(0);
@@ -64,7 +95,15 @@ bool opna_t::Initialize(uint32_t clockSpeed, uint32_t sampleRate, const WCHAR *
     for (int32_t i = 0; i < (int32_t) _countof(_Instruments); ++i)
         SetInstrumentVolume(i, 0);
 
-    LoadInstruments(directoryPathDrums);
+    // Missing or unusable drum samples are not fatal; the failure is reported by HasADPCMROM() and HasPercussionSamples().
+    try
+    {
+        LoadInstruments(directoryPathDrums);
+    }
+    catch (const std::bad_alloc &)
+    {
+        DeleteInstruments();
+    }
 
     return true;
 }
@@ -79,8 +118,13 @@ void opna_t::Initialize(uint32_t clockSpeed, uint32_t sampleRate) noexcept
     if (sampleRate == 0)
         return;
 
+    const bool HasSampleRateChanged = (sampleRate != _SampleRate);
+
     _SampleRate = sampleRate;
     _OutputStep = (emulated_time) (0x1000000000000ull / _SampleRate);
+
+    if (HasSampleRateChanged && (_InstrumentCount == _countof(_Instruments)))
+        ConvertInstruments();
 }
 
 #pragma region Volume
@@ -150,10 +194,121 @@ void opna_t::SetInstrumentVolume(int index, int dB)
 #pragma region Registers
 
 /// <summary>
-/// Sets the value of a register.
+/// Sets the value of a register. Writes that would not change anything are dropped.
 /// </summary>
 void opna_t::SetReg(uint32_t addr, uint32_t value)
 {
+    ++_WriteCount;
+
+    if (_RegisterLog != nullptr)
+    {
+        _RegisterLog->Add(addr, value);
+
+        // The timers keep running while the writes are only logged. The driver depends on them.
+        if (_RegisterLog->IsLogOnly() && ((addr < 0x24) || (addr > 0x27)))
+            return;
+    }
+
+    // The frequency registers are written in pairs: the upper half (A4-A6, AC-AE) is latched and only takes effect when the lower half (A0-A2, A8-AA) is written.
+    if (((addr & 0xF0) == 0xA0) && ((addr & 0x03) != 0x03) && (addr < ShadowRegCount))
+    {
+        int16_t & Latch = _FrequencyLatch[((addr >> 7) & 0x02) | ((addr >> 3) & 0x01)];
+
+        // Hold back the upper half until we know whether the pair changes the frequency.
+        if (addr & 0x04)
+        {
+            if (Latch >= 0)
+                ++_ElidedWriteCount; // Overwritten before it took effect.
+
+            Latch = (int16_t) (value & 0xFF);
+
+            return;
+        }
+
+        if (Latch >= 0)
+        {
+            const uint32_t UpperAddr = addr | 0x04;
+            const uint32_t UpperValue = (uint32_t) Latch;
+
+            Latch = -1;
+
+            if (IsRedundantWrite(UpperAddr, UpperValue) && IsRedundantWrite(addr, value))
+            {
+                _ElidedWriteCount += 2;
+
+                return;
+            }
+
+            WriteReg(UpperAddr, UpperValue);
+            WriteReg(addr, value);
+        }
+        else
+        {
+            // The chip ignores the lower half if no upper half has been latched. Forward the write but don't trust the shadow copy anymore.
+            WriteReg(addr, value);
+
+            _IsShadowRegValid[addr] = false;
+        }
+
+        return;
+    }
+
+    if (IsRedundantWrite(addr, value))
+    {
+        ++_ElidedWriteCount;
+
+        return;
+    }
+
+    WriteReg(addr, value);
+}
+
+/// <summary>
+/// Gets the value of a register. The SSG registers are read from the shadow registers.
+/// </summary>
+uint32_t opna_t::GetReg(uint32_t addr)
+{
+    // Writes that are only logged have not reached the chip yet. The log has the last value of every register. Reading the ADPCM data port reads the memory instead.
+    if ((_RegisterLog != nullptr) && _RegisterLog->IsLogOnly() && (addr != 0x108))
+    {
+        uint32_t Value;
+
+        if (_RegisterLog->GetValue(addr, Value))
+            return Value;
+    }
+
+    if ((addr < 0x0E) && _IsShadowRegValid[addr])
+        return _ShadowRegs[addr];
+
+    uint32_t addr1 = 0 + 2 * ((addr >> 8) & 3);
+    uint8_t data1 = addr & 0xff;
+
+    uint32_t addr2 = addr1 + 1;
+    uint8_t result = 0;
+
+    if (addr1 != 0xffff)
+    {
+        _Chip.write(addr1, data1);
+
+        result = _Chip.read(addr2);
+    }
+    else
+        result = 1;
+
+    return result;
+}
+
+/// <summary>
+/// Writes a register and updates its shadow copy.
+/// </summary>
+void opna_t::WriteReg(uint32_t addr, uint32_t value)
+{
+    if (addr < ShadowRegCount)
+    {
+        _ShadowRegs[addr] = (uint8_t) value;
+        _IsShadowRegValid[addr] = true;
+    }
+
     if ((0x10 <= addr) && (addr <= 0x1F) && !_HasADPCMROM)
     {
         // Use PPS WAV files to play percussion.
@@ -213,53 +368,70 @@ void opna_t::SetReg(uint32_t addr, uint32_t value)
 }
 
 /// <summary>
-/// Gets the value of a register.
+/// Returns true if writing the value would not change anything: the register already holds the value and writing it has no side effects.
 /// </summary>
-uint32_t opna_t::GetReg(uint32_t addr)
+bool opna_t::IsRedundantWrite(uint32_t addr, uint32_t value) const noexcept
 {
-    uint32_t addr1 = 0 + 2 * ((addr >> 8) & 3);
-    uint8_t data1 = addr & 0xff;
-
-    uint32_t addr2 = addr1 + 1;
-    uint8_t result = 0;
+    if ((addr >= ShadowRegCount) || !_IsShadowRegValid[addr] || (_ShadowRegs[addr] != (uint8_t) value))
+        return false;
 
-    if (addr1 != 0xffff)
+    switch (addr)
     {
-        _Chip.write(addr1, data1);
-
-        result = _Chip.read(addr2);
+        case 0x0D:  // SSG envelope shape: Restarts the envelope.
+        case 0x0E:  // SSG I/O port A
+        case 0x0F:  // SSG I/O port B
+        case 0x10:  // Rhythm key on/off
+        case 0x27:  // Timer control
+        case 0x28:  // FM key on/off
+        case 0x2D:  // Prescaler
+        case 0x2E:  // Prescaler
+        case 0x2F:  // Prescaler
+        case 0x100: // ADPCM control 1: Starts or resets the playback.
+        case 0x108: // ADPCM data
+        case 0x110: // Flag control
+            return false;
     }
-    else
-        result = 1;
 
-    return result;
+    return true;
+}
+
+/// <summary>
+/// Forgets the shadow register values, e.g. after the chip has been reset.
+/// </summary>
+void opna_t::ResetShadowRegisters() noexcept
+{
+    ::memset(_ShadowRegs, 0, sizeof(_ShadowRegs));
+    ::memset(_IsShadowRegValid, 0, sizeof(_IsShadowRegValid));
+
+    for (auto & Latch : _FrequencyLatch)
+        Latch = -1;
 }
 #pragma endregion
 
 #pragma region Timer processing
 
 /// <summary>
-/// Advances the timers until the next tick (in μs).
+/// Advances the timers by the specified number of clocks. The counters are kept in clocks so no time is lost between ticks.
 /// </summary>
-bool opna_t::AdvanceTimers(uint32_t nextTick) noexcept
+bool opna_t::AdvanceTimers(uint32_t clockCount) noexcept
 {
     bool Result = false;
 
     if (_Reg27 & 0x01)
     {
         if (_TimerCounter[0] > 0)
-            _TimerCounter[0] -= ((emulated_time) nextTick << (48 - 6)) / (1'000'000 >> 6);
+            _TimerCounter[0] -= clockCount;
     }
 
     if (_Reg27 & 0x02)
     {
         if (_TimerCounter[1] > 0)
-            _TimerCounter[1] -= ((emulated_time) nextTick << (48 - 6)) / (1'000'000 >> 6);
+            _TimerCounter[1] -= clockCount;
     }
 
     for (int32_t i = 0; i < (int32_t) _countof(_TimerCounter); ++i)
     {
-        if ((_Reg27 & (4 << i)) && (_TimerCounter[i] < 0))
+        if ((_Reg27 & (4 << i)) && (_TimerPeriod[i] > 0) && (_TimerCounter[i] <= 0))
         {
             Result = true;
 
@@ -267,7 +439,7 @@ bool opna_t::AdvanceTimers(uint32_t nextTick) noexcept
             {
                 _TimerCounter[i] += _TimerPeriod[i];
             }
-            while (_TimerCounter[i] < 0);
+            while (_TimerCounter[i] <= 0);
 
             m_engine->engine_timer_expired((uint32_t) i);
         }
@@ -277,14 +449,14 @@ bool opna_t::AdvanceTimers(uint32_t nextTick) noexcept
 }
 
 /// <summary>
-/// Gets the number of μs until the next timer tick occurs.
+/// Gets the number of clocks until the next timer tick occurs.
 /// </summary>
 uint32_t opna_t::GetNextTick() const noexcept
 {
     if (_TimerCounter[0] == 0 && _TimerCounter[1] == 0)
         return 0;
 
-    emulated_time Tick = INT64_MAX;
+    int64_t Tick = INT64_MAX;
 
     if (_TimerCounter[0] > 0)
         Tick = std::min(Tick, _TimerCounter[0]);
@@ -292,8 +464,7 @@ uint32_t opna_t::GetNextTick() const noexcept
     if (_TimerCounter[1] > 0)
         Tick = std::min(Tick, _TimerCounter[1]);
 
-    return (uint32_t) (((Tick + ((emulated_time) 1 << 48) / 1'000'000) * (1'000'000 >> 6)) >> (48 - 6));
-
+    return (uint32_t) Tick;
 }
 
 #pragma endregion
@@ -308,8 +479,15 @@ void opna_t::Mix(sample_t * sampleData, size_t sampleCount) noexcept
     sample_t * SampleData = sampleData;
     size_t SampleCount = sampleCount;
 
-    while (SampleCount-- != 0)
+    while (SampleCount != 0)
     {
+        // The chip stays silent until the next register write and there are none during a mix. Advance it over the rest of the buffer at once.
+        if (_Chip.idle())
+        {
+            Skip(SampleCount);
+            break;
+        }
+
         int32_t Outputs[2] = { 0, 0 };
 
         // ymfm
@@ -318,6 +496,8 @@ void opna_t::Mix(sample_t * sampleData, size_t sampleCount) noexcept
 
         *SampleData++ += Outputs[0];
         *SampleData++ += Outputs[1];
+
+        --SampleCount;
     }
 
     if (!_HasADPCMROM)
@@ -325,49 +505,107 @@ void opna_t::Mix(sample_t * sampleData, size_t sampleCount) noexcept
 }
 
 /// <summary>
-/// Mixes the rhythm instrument samples with the existing synthesized samples.
+/// Synthesizes a buffer for each stem instead of a single mix. The stems are ordered FM 1-6, SSG 1-3, ADPCM and Rhythm.
 /// </summary>
-void opna_t::MixRhythmSamples(sample_t * sampleData, size_t sampleCount) noexcept
+void opna_t::MixStems(sample_t * const * stemData, size_t sampleCount) noexcept
 {
-    if (!((_InstrumentMask & 0x3F) && _Instruments[0].Samples && (_MasterVolume < 128)))
-        return;
-
-    const sample_t * SampleDataEnd = sampleData + (sampleCount * 2);
+    _Chip.set_channel_outputs(&_ChannelOutputs);
 
-    for (size_t i = 0; i < _countof(_Instruments); ++i)
+    for (size_t i = 0; i < sampleCount; ++i)
     {
-        Instrument & Ins = _Instruments[i];
-
-        if ((_InstrumentMask & (1 << i)))
+        if (_Chip.idle())
         {
-            const int32_t dB = std::clamp(_InstrumentTotalLevel + _MasterVolume + Ins.Level + Ins.Volume, -31, 127);
+            Skip(sampleCount - i);
 
-            const int32_t Volume = tltable[FM_TLPOS + (dB << (FM_TLBITS - 7))] >> 4;
-            const int32_t MaskL  = -((Ins.Pan >> 1) & 1);
-            const int32_t MaskR  = - (Ins.Pan       & 1);
+            // Skipping doesn't write the channel outputs. Clear them as generating the silence would have.
+            _ChannelOutputs = { };
+            break;
+        }
 
-            for (sample_t * SampleData = sampleData; (SampleData < SampleDataEnd) && (Ins.Pos < Ins.Size); SampleData += 2)
-            {
-                const int32_t Sample = (Ins.Samples[Ins.Pos / 1024] * Volume) >> 12;
+        int32_t Outputs[2] = { 0, 0 };
 
-                StoreSample(SampleData[0], Sample & MaskL);
-                StoreSample(SampleData[1], Sample & MaskR);
+        generate(_OutputPosition, _OutputStep, Outputs);
+        _OutputPosition += _OutputStep;
 
-                Ins.Pos += Ins.Step;
-            }
+        const auto & co = _ChannelOutputs;
+
+        for (size_t j = 0; j < _countof(co.fm); ++j)
+        {
+            stemData[j][i * 2    ] += co.fm[j].data[0];
+            stemData[j][i * 2 + 1] += co.fm[j].data[1];
         }
+
+        for (size_t j = 0; j < _countof(co.ssg.data); ++j)
+        {
+            stemData[6 + j][i * 2    ] += co.ssg.data[j];
+            stemData[6 + j][i * 2 + 1] += co.ssg.data[j];
+        }
+
+        stemData[ 9][i * 2    ] += co.adpcm_b.data[0];
+        stemData[ 9][i * 2 + 1] += co.adpcm_b.data[1];
+
+        stemData[10][i * 2    ] += co.adpcm_a.data[0];
+        stemData[10][i * 2 + 1] += co.adpcm_a.data[1];
     }
+
+    _Chip.set_channel_outputs(nullptr);
+
+    if (!_HasADPCMROM)
+        MixRhythmSamples(stemData[10], sampleCount);
 }
 
 /// <summary>
-/// Stores the sample.
+/// Advances the idle chip over the specified number of output samples at once. It ends up in the state generate() would have left it in, the output is silence.
 /// </summary>
-void opna_t::StoreSample(sample_t & sampleData, int32_t sampleValue)
+void opna_t::Skip(size_t sampleCount) noexcept
 {
-    if constexpr(sizeof(sample_t) == 2)
-        sampleData = (sample_t) std::clamp(sampleData + sampleValue, -0x8000, 0x7FFF);
-    else
-        sampleData += sampleValue;
+    // Count the chip samples generate() would have produced up to the last output sample.
+    const emulated_time Last = _OutputPosition + (emulated_time) (sampleCount - 1) * _OutputStep;
+
+    if (_Pos <= Last)
+    {
+        const emulated_time Count = (Last - _Pos) / _Step + 1;
+
+        _Chip.skip((uint32_t) Count);
+        _Pos += Count * _Step;
+
+        _Output.clear();
+    }
+
+    _OutputPosition += (emulated_time) sampleCount * _OutputStep;
+    _TickCount += sampleCount;
+}
+
+/// <summary>
+/// Mixes the rhythm instrument samples with the existing synthesized samples.
+/// </summary>
+void opna_t::MixRhythmSamples(sample_t * sampleData, size_t sampleCount) noexcept
+{
+    if (!((_InstrumentMask & 0x3F) && !_Instruments[0].Samples.empty() && (_MasterVolume < 128)))
+        return;
+
+    for (size_t i = 0; i < _countof(_Instruments); ++i)
+    {
+        Instrument & Ins = _Instruments[i];
+
+        if (!(_InstrumentMask & (1 << i)) || (Ins.Pos >= Ins.Samples.size()))
+            continue;
+
+        const int32_t dB = std::clamp(_InstrumentTotalLevel + _MasterVolume + Ins.Level + Ins.Volume, -31, 127);
+
+        const int32_t Volume = GetTLTable()[FM_TLPOS + (dB << (FM_TLBITS - 7))] >> 4;
+
+        const voice_mixer::pan_mask_t Pan { -((Ins.Pan >> 1) & 1), -(Ins.Pan & 1) };
+
+        // The samples are at the synthesis rate so mixing is a straight gain and pan accumulation.
+        const size_t Count = std::min(sampleCount, Ins.Samples.size() - Ins.Pos);
+
+        const int16_t * Samples = Ins.Samples.data() + Ins.Pos;
+
+        voice_mixer::Mix<false>(sampleData, Count, Pan, [&Samples, Volume]() noexcept { return (*Samples * Volume) >> 12; }, [&Samples]() noexcept { ++Samples; return true; });
+
+        Ins.Pos += (uint32_t) Count;
+    }
 }
 
 #pragma endregion
@@ -381,6 +619,11 @@ bool opna_t::LoadInstruments(const WCHAR * directoryPath)
 {
     _HasADPCMROM = false;
 
+    UpdateMemoryView(ymfm::ACCESS_ADPCM_A);
+
+    for (uint32_t i = 0; i < 6; ++i)
+        _Chip.set_rhythm_pcm(i, nullptr, 0);
+
     WCHAR FilePath[_MAX_PATH] = { 0 };
 
     CombinePath(FilePath, _countof(FilePath), directoryPath, L"ym2608_adpcm_rom.bin");
@@ -397,8 +640,37 @@ bool opna_t::LoadInstruments(const WCHAR * directoryPath)
 
             write_data(ymfm::ACCESS_ADPCM_A, 0, (uint32_t) FileSize, temp.data());
 
+            // Decode the percussion sounds once per ROM image and let the chip play them from PCM. The hash only selects a slot; a slot that holds the sounds of another image is skipped.
+            uint32_t Hash = 0x811C9DC5U;
+
+            for (const auto & Byte : temp)
+                Hash = (Hash ^ Byte) * 0x01000193U;
+
+            const rhythm_pcm_t * Table = nullptr;
+
+            for (;; ++Hash)
+            {
+                Table = &shared_table_t<rhythm_pcm_t, opna_t>::Get((int32_t) Hash, [&temp](rhythm_pcm_t & table)
+                {
+                    table.ROM = temp;
+
+                    for (uint32_t i = 0; i < _countof(table.Samples); ++i)
+                        ymfm::ym2608::decode_rhythm(temp.data(), (uint32_t) temp.size(), i, table.Samples[i]);
+                });
+
+                if (Table->ROM == temp)
+                    break;
+            }
+
+            const auto & PCM = *Table;
+
+            for (uint32_t i = 0; i < _countof(PCM.Samples); ++i)
+                _Chip.set_rhythm_pcm(i, PCM.Samples[i].data(), (uint32_t) PCM.Samples[i].size());
+
             _HasADPCMROM = true;
 
+            UpdateMemoryView(ymfm::ACCESS_ADPCM_A);
+
             return true;
         }
     }
@@ -418,7 +690,7 @@ bool opna_t::LoadInstruments(const WCHAR * directoryPath)
 
         ::StringCbPrintfW(FileName, _countof(FileName), L"2608_%s.wav", InstrumentName[_InstrumentCount]);
 
-        WAVEReader & wr = Instrument.Wave;
+        WAVEReader wr;
 
         {
             CombinePath(FilePath, _countof(FilePath), directoryPath, FileName);
@@ -437,16 +709,12 @@ bool opna_t::LoadInstruments(const WCHAR * directoryPath)
 
             wr.Close();
 
-            if (!(wr.Format() == 1) && (wr.ChannelCount() == 1) && (wr.SampleRate() == 44100) && (wr.BitsPerSample() == 16))
+            if ((wr.SampleRate() == 0) || !wr.GetSamples(Instrument.Source))
                 break;
         }
 
-        uint32_t SampleCount = wr.Size() / 2;
-
-        Instrument.Samples = (const int16_t *) wr.Data();
-        Instrument.Size    = SampleCount * 1024;
-        Instrument.Step    = wr.SampleRate() * 1024 / _SampleRate;
-        Instrument.Pos     = 0U;
+        Instrument.SourceRate = wr.SampleRate();
+        Instrument.Pos        = ~0U;
 
         ++_InstrumentCount;
     }
@@ -458,9 +726,91 @@ bool opna_t::LoadInstruments(const WCHAR * directoryPath)
         return false;
     }
 
+    return ConvertInstruments();
+}
+
+/// <summary>
+/// Converts the rhythm instrument samples to the synthesis rate using a windowed sinc low-pass filter. Deletes the instruments and returns false if there is not enough memory.
+/// </summary>
+bool opna_t::ConvertInstruments() noexcept
+{
+    try
+    {
+        ConvertInstrumentsInternal();
+    }
+    catch (const std::bad_alloc &)
+    {
+        DeleteInstruments();
+
+        return false;
+    }
+
     return true;
 }
 
+/// <summary>
+/// Converts the rhythm instrument samples to the synthesis rate.
+/// </summary>
+void opna_t::ConvertInstrumentsInternal()
+{
+    for (auto & Instrument : _Instruments)
+    {
+        const auto & Source = Instrument.Source;
+        auto & Samples = Instrument.Samples;
+
+        Samples.clear();
+
+        if (Source.empty())
+            continue;
+
+        auto ToSample = [](double value) { return (int16_t) std::clamp((int32_t) std::lround(value * 32768.), -32768, 32767); };
+
+        if (Instrument.SourceRate == _SampleRate)
+        {
+            Samples.resize(Source.size());
+
+            for (size_t i = 0; i < Source.size(); ++i)
+                Samples[i] = ToSample(Source[i]);
+
+            continue;
+        }
+
+        constexpr double Pi = 3.14159265358979323846;
+        constexpr double ZeroCrossings = 16.; // Number of zero crossings of the filter kernel on each side
+
+        const double Ratio     = (double) Instrument.SourceRate / _SampleRate;       // Source samples per output sample
+        const double Cutoff    = 0.5 * std::min(1., 1. / Ratio) * 0.95;              // Cycles per source sample, with some room for the transition band
+        const double HalfWidth = ZeroCrossings / (2. * Cutoff);                      // Kernel half width in source samples
+
+        const size_t Count = (size_t) std::ceil((double) Source.size() / Ratio);
+
+        Samples.resize(Count);
+
+        for (size_t i = 0; i < Count; ++i)
+        {
+            const double t = (double) i * Ratio;
+
+            const int64_t First = std::max((int64_t) std::ceil (t - HalfWidth), (int64_t) 0);
+            const int64_t Last  = std::min((int64_t) std::floor(t + HalfWidth), (int64_t) Source.size() - 1);
+
+            double Sum = 0.;
+
+            for (int64_t k = First; k <= Last; ++k)
+            {
+                const double x = (double) k - t;
+                const double y = 2. * Cutoff * x;
+
+                const double Sinc   = (y != 0.) ? std::sin(Pi * y) / (Pi * y) : 1.;
+                const double Window = 0.42 + 0.5 * std::cos(Pi * x / HalfWidth) + 0.08 * std::cos(2. * Pi * x / HalfWidth); // Blackman
+
+                Sum += Source[(size_t) k] * 2. * Cutoff * Sinc * Window;
+            }
+
+            Samples[i] = ToSample(Sum);
+        }
+    }
+}
+
 /// <summary>
 /// Deletes the rhythm instrument samples.
 /// </summary>
@@ -468,8 +818,9 @@ void opna_t::DeleteInstruments() noexcept
 {
     for (auto & Instrument : _Instruments)
     {
-        Instrument.Wave.Reset();
-        Instrument.Samples = nullptr;
+        Instrument.Source.clear();
+        Instrument.SourceRate = 0;
+        Instrument.Samples.clear();
         Instrument.Pos = ~0U;
     }
 
@@ -483,7 +834,7 @@ void opna_t::DeleteInstruments() noexcept
 /// <summary>
 /// Generates one output sample.
 /// </summary>
-void opna_t::generate(emulated_time output_start, emulated_time, int32_t * buffer)
+void opna_t::generate(emulated_time output_start, emulated_time, int32_t * buffer) noexcept
 {
     // Generate at the appropriate sample rate.
     for (; _Pos <= output_start; _Pos += _Step)
@@ -511,6 +862,28 @@ void opna_t::write_data(ymfm::access_class type, uint32_t base, uint32_t length,
         _Data[type].resize(end);
 
     ::memcpy(&_Data[type][base], src, length);
+
+    UpdateMemoryView(type);
+}
+
+/// <summary>
+/// Lets the chip read the ADPCM buffers directly. Called whenever a buffer is written or moved.
+/// </summary>
+void opna_t::UpdateMemoryView(ymfm::access_class type) noexcept
+{
+    if (type == ymfm::ACCESS_IO)
+        return;
+
+    if (!_HasADPCMROM && (type == ymfm::ACCESS_ADPCM_A))
+    {
+        ymfm_set_external_memory(type, nullptr, 0);
+
+        return;
+    }
+
+    const auto & Data = _Data[type];
+
+    ymfm_set_external_memory(type, Data.data(), (uint32_t) Data.size());
 }
 
 /// <summary>
@@ -564,7 +937,7 @@ void opna_t::ymfm_set_timer(uint32_t timerIndex, int32_t duration_in_clocks)
 {
     if (duration_in_clocks >= 0)
     {
-        _TimerPeriod[timerIndex] = (((emulated_time) duration_in_clocks << 43) / _ClockSpeed) << 5;
+        _TimerPeriod[timerIndex] = duration_in_clocks;
         _TimerCounter[timerIndex] = _TimerPeriod[timerIndex];
     }
     else
@@ -1,10 +1,13 @@
 
-/** $VER: OPNAW.h (2026.01.07) OPNA emulator (Based on PMDWin code by C60 / Masahiro Kajihara) **/
+/** $VER: OPNAW.h (2026.10.19) OPNA emulator (Based on PMDWin code by C60 / Masahiro Kajihara) **/
 
 #pragma once
 
 #include "File.h"
 #include "WAVEReader.h"
+#include "SharedTable.h"
+#include "VoiceMixer.h"
+#include "RegisterLog.h"
 
 #include <ymfm_opn.h>
 
@@ -52,21 +55,37 @@ public:
 
     void SetReg(uint32_t reg, uint32_t value);
     uint32_t GetReg(uint32_t addr);
+
+    uint64_t GetWriteCount() const noexcept { return _WriteCount; }               // Gets the number of register writes.
+    uint64_t GetElidedWriteCount() const noexcept { return _ElidedWriteCount; }   // Gets the number of register writes that were dropped because they would not have changed anything.
+
+    void SetRegisterLog(register_log_t * log) noexcept { _RegisterLog = log; }   // Sets the log that receives all register writes. Specify nullptr to stop logging. See register_log_t::SetLogOnly().
+    const std::vector<uint8_t> & GetADPCMRAM() const noexcept { return _Data[ymfm::ACCESS_ADPCM_B]; } // Gets the contents of the ADPCM RAM.
     
-    void Reset() { _Chip.reset(); }
+    void Reset() { _Chip.reset(); ResetShadowRegisters(); }
     uint32_t ReadStatus() { return _Chip.read_status(); }       // Reads the status register.
     uint32_t ReadStatusEx() { return _Chip.read_status_hi(); }  // Reads the status register (extended addressing).
 
-    bool AdvanceTimers(uint32_t tickCount) noexcept;
+    void SetChannelMask(uint32_t fmMask, uint32_t ssgMask) noexcept { _Chip.set_channel_mask(fmMask, ssgMask); } // Sets the FM and SSG channels that are computed. The others output silence.
+
+    bool AdvanceTimers(uint32_t clockCount) noexcept;
     uint32_t GetNextTick() const noexcept;
     
     void Mix(sample_t * sampleData, size_t sampleCount) noexcept;
+    void MixStems(sample_t * const * stemData, size_t sampleCount) noexcept;
     
     static constexpr uint32_t DefaultClockSpeed = 3993600 * 2;
+    static constexpr size_t StemCount = 11; // FM 1-6, SSG 1-3, ADPCM, Rhythm
 
 private:
+    void Skip(size_t sampleCount) noexcept;
     void MixRhythmSamples(sample_t * sampleData, size_t sampleCount) noexcept;
-    void StoreSample(sample_t & sample, int32_t data);
+    bool ConvertInstruments() noexcept;
+    void ConvertInstrumentsInternal();
+
+    void WriteReg(uint32_t addr, uint32_t value);
+    bool IsRedundantWrite(uint32_t addr, uint32_t value) const noexcept;
+    void ResetShadowRegisters() noexcept;
 
     uint32_t GetSampleRate() const { return _Chip.sample_rate(_ClockSpeed); }
 
@@ -78,16 +97,14 @@ protected:
     static constexpr int32_t FM_TLENTS = (1 << FM_TLBITS);
     static constexpr int32_t FM_TLPOS = (FM_TLENTS / 4);
 
-    int32_t tltable[FM_TLENTS + FM_TLPOS];
+    static const int32_t * GetTLTable() noexcept;
 
     struct Instrument
     {
-        WAVEReader Wave;
+        std::vector<float> Source;      // Mono samples as loaded from the WAV file
+        uint32_t SourceRate;
 
-        const int16_t * Samples;
-        uint32_t Size;
-
-        uint32_t Step;
+        std::vector<int16_t> Samples;   // Samples converted to the synthesis rate
         uint32_t Pos;
 
         int32_t Volume;
@@ -108,9 +125,11 @@ protected:
 protected:
     #pragma region YMFM Interface
 
-    virtual void generate(emulated_time output_start, emulated_time output_step, int32_t * buffer);
+    void generate(emulated_time output_start, emulated_time output_step, int32_t * buffer) noexcept;
     
     void write_data(ymfm::access_class type, uint32_t base, uint32_t length, uint8_t const* src);
+
+    void UpdateMemoryView(ymfm::access_class type) noexcept;
     
     virtual uint8_t ymfm_external_read(ymfm::access_class type, uint32_t offset) override;
     
@@ -128,9 +147,9 @@ protected:
     emulated_time _OutputStep;
     emulated_time _OutputPosition;
     
-    // Timer A and B
-    emulated_time _TimerPeriod[2];
-    emulated_time _TimerCounter[2];
+    // Timer A and B (in clocks)
+    int64_t _TimerPeriod[2];
+    int64_t _TimerCounter[2];
 
     uint8_t _Reg27;
 
@@ -139,6 +158,12 @@ protected:
 private:
     void DeleteInstruments() noexcept;
 
+    struct rhythm_pcm_t
+    {
+        std::vector<uint8_t> ROM;   // The image the samples were decoded from
+        std::vector<int16_t> Samples[6];
+    };
+
 private:
     #pragma region YMFM Interface
 
@@ -146,6 +171,7 @@ private:
 
     ymfm::ym2608 _Chip;
     typename ymfm::ym2608::output_data _Output;
+    typename ymfm::ym2608::channel_output_data _ChannelOutputs;
 
     uint32_t _ClockSpeed;
     uint32_t _SampleRate;
@@ -155,4 +181,19 @@ private:
     uint64_t _TickCount;
 
     #pragma endregion
+
+    #pragma region Shadow Registers
+
+    static constexpr uint32_t ShadowRegCount = 0x200;
+
+    uint8_t _ShadowRegs[ShadowRegCount];        // Last value written to each register
+    bool _IsShadowRegValid[ShadowRegCount];     // False until a register has been written after a reset
+    int16_t _FrequencyLatch[4];                 // Upper halves of the frequency registers (A4-A6, AC-AE, 1A4-1A6, 1AC-1AE) waiting for their lower half, or -1
+
+    uint64_t _WriteCount;
+    uint64_t _ElidedWriteCount;
+
+    register_log_t * _RegisterLog;
+
+    #pragma endregion
 };
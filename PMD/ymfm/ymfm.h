@@ -555,10 +555,54 @@ public:
 	// of the chip; our responsibility is to pass the written data on to any consumers
 	virtual void ymfm_external_write(access_class type, uint32_t address, uint8_t data) { }
 
+	//
+	// direct memory access
+	//
+
+	// derived classes that keep external memory in a flat buffer can call this
+	// to let the chip read it directly instead of calling ymfm_external_read();
+	// the view must be refreshed whenever the buffer is written or moved, and
+	// reads beyond the given length return 0
+	void ymfm_set_external_memory(access_class type, uint8_t const *data, uint32_t length)
+	{
+		m_external[type].data = data;
+		m_external[type].length = length;
+		m_external[type].direct = true;
+		m_external[type].generation++;
+	}
+
+	// return true if the chip can read external memory directly
+	bool ymfm_external_direct(access_class type) const { return m_external[type].direct; }
+
+	// return a counter that changes every time the direct view is refreshed;
+	// the chip uses this to invalidate anything derived from external memory
+	uint32_t ymfm_external_generation(access_class type) const { return m_external[type].generation; }
+
+	// the chip implementation calls this to read external memory; it uses the
+	// direct view if one was provided and falls back to ymfm_external_read()
+	uint8_t ymfm_read_external(access_class type, uint32_t address)
+	{
+		external_view const &view = m_external[type];
+		if (view.direct)
+			return (address < view.length) ? view.data[address] : 0;
+		return ymfm_external_read(type, address);
+	}
+
 protected:
 	// pointer to engine callbacks -- this is set directly by the engine at
 	// construction time
 	ymfm_engine_callbacks *m_engine;
+
+private:
+	// direct view of one access class of external memory
+	struct external_view
+	{
+		uint8_t const *data = nullptr;
+		uint32_t length = 0;
+		uint32_t generation = 0;
+		bool direct = false;
+	};
+	external_view m_external[ACCESS_CLASSES];
 };
 
 }
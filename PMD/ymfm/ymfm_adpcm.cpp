@@ -79,6 +79,11 @@ adpcm_a_channel::adpcm_a_channel(adpcm_a_engine &owner, uint32_t choffs, uint32_
 	m_curaddress(0),
 	m_accumulator(0),
 	m_step_index(0),
+	m_pcm(nullptr),
+	m_pcm_start(0),
+	m_pcm_end(0),
+	m_pcm_length(0),
+	m_pcm_playing(0),
 	m_regs(owner.regs()),
 	m_owner(owner)
 {
@@ -97,6 +102,21 @@ void adpcm_a_channel::reset()
 	m_curaddress = 0;
 	m_accumulator = 0;
 	m_step_index = 0;
+	m_pcm_playing = 0;
+}
+
+
+//-------------------------------------------------
+//  set_pcm - attach pre-decoded PCM data
+//-------------------------------------------------
+
+void adpcm_a_channel::set_pcm(uint32_t start, uint32_t end, int16_t const *pcm, uint32_t length)
+{
+	m_pcm = pcm;
+	m_pcm_start = start;
+	m_pcm_end = end;
+	m_pcm_length = length;
+	m_pcm_playing = 0;
 }
 
 
@@ -131,6 +151,11 @@ void adpcm_a_channel::keyonoff(bool on)
 		m_accumulator = 0;
 		m_step_index = 0;
 
+		// play from the pre-decoded data if it covers the same range
+		m_pcm_playing = (m_pcm != nullptr && m_regs.ch_start(m_choffs) == m_pcm_start && m_regs.ch_end(m_choffs) == m_pcm_end);
+		if (m_pcm_playing)
+			m_curaddress = 0;
+
 		// don't log masked channels
 		if (((debug::GLOBAL_ADPCM_A_CHANNEL_MASK >> m_choffs) & 1) != 0)
 			debug::log_keyon("KeyOn ADPCM-A%d: pan=%d%d start=%04X end=%04X level=%02X\n",
@@ -157,6 +182,18 @@ bool adpcm_a_channel::clock()
 		return false;
 	}
 
+	// pre-decoded data holds the accumulator values for every nibble
+	if (m_pcm_playing)
+	{
+		if (m_curaddress >= m_pcm_length)
+		{
+			m_playing = m_accumulator = 0;
+			return true;
+		}
+		m_accumulator = uint16_t(m_pcm[m_curaddress++]) >> 4;
+		return false;
+	}
+
 	// if we're about to read nibble 0, fetch the data
 	uint8_t data;
 	if (m_curnibble == 0)
@@ -176,7 +213,7 @@ bool adpcm_a_channel::clock()
 			return true;
 		}
 
-		m_curbyte = m_owner.intf().ymfm_external_read(ACCESS_ADPCM_A, m_curaddress++);
+		m_curbyte = m_owner.intf().ymfm_read_external(ACCESS_ADPCM_A, m_curaddress++);
 		data = m_curbyte >> 4;
 		m_curnibble = 1;
 	}
@@ -188,6 +225,17 @@ bool adpcm_a_channel::clock()
 		m_curnibble = 0;
 	}
 
+	decode_nibble(data, m_accumulator, m_step_index);
+	return false;
+}
+
+
+//-------------------------------------------------
+//  decode_nibble - decode one ADPCM nibble
+//-------------------------------------------------
+
+void adpcm_a_channel::decode_nibble(uint8_t data, int32_t &accumulator, int32_t &step_index)
+{
 	// compute the ADPCM delta
 	static uint16_t const s_steps[49] =
 	{
@@ -199,18 +247,16 @@ bool adpcm_a_channel::clock()
 		449, 494,  544,  598,  658,  724,  796,
 		876, 963, 1060, 1166, 1282, 1411, 1552
 	};
-	int32_t delta = (2 * bitfield(data, 0, 3) + 1) * s_steps[m_step_index] / 8;
+	int32_t delta = (2 * bitfield(data, 0, 3) + 1) * s_steps[step_index] / 8;
 	if (bitfield(data, 3))
 		delta = -delta;
 
 	// the 12-bit accumulator wraps on the ym2610 and ym2608 (like the msm5205)
-	m_accumulator = (m_accumulator + delta) & 0xfff;
+	accumulator = (accumulator + delta) & 0xfff;
 
 	// adjust ADPCM step
 	static int8_t const s_step_inc[8] = { -1, -1, -1, -1, 2, 5, 7, 9 };
-	m_step_index = clamp(m_step_index + s_step_inc[bitfield(data, 0, 3)], 0, 48);
-
-	return false;
+	step_index = clamp(step_index + s_step_inc[bitfield(data, 0, 3)], 0, 48);
 }
 
 
@@ -294,6 +340,34 @@ void adpcm_a_engine::save_restore(ymfm_saved_state &state)
 }
 
 
+//-------------------------------------------------
+//  decode - decode ADPCM data into 16-bit PCM
+//-------------------------------------------------
+
+void adpcm_a_engine::decode(uint8_t const *data, uint32_t size, uint32_t start, uint32_t end, uint32_t addrshift, std::vector<int16_t> &pcm)
+{
+	pcm.clear();
+
+	// mirror the fetch and end-address logic of adpcm_a_channel::clock
+	uint32_t address = start << addrshift;
+	uint32_t endaddress = (end + 1) << addrshift;
+	int32_t accumulator = 0;
+	int32_t step_index = 0;
+
+	while (((address ^ endaddress) & 0xfffff) != 0)
+	{
+		uint8_t byte = (address < size) ? data[address] : 0;
+		address++;
+
+		adpcm_a_channel::decode_nibble(byte >> 4, accumulator, step_index);
+		pcm.push_back(int16_t(accumulator << 4));
+
+		adpcm_a_channel::decode_nibble(byte & 0xf, accumulator, step_index);
+		pcm.push_back(int16_t(accumulator << 4));
+	}
+}
+
+
 //-------------------------------------------------
 //  clock - master clocking function
 //-------------------------------------------------
@@ -398,6 +472,11 @@ adpcm_b_channel::adpcm_b_channel(adpcm_b_engine &owner, uint32_t addrshift) :
 	m_accumulator(0),
 	m_prev_accum(0),
 	m_adpcm_step(STEP_MIN),
+	m_cache_generation(0),
+	m_cache_entry(nullptr),
+	m_cache_nibbles(nullptr),
+	m_cache_index(0),
+	m_cache_count(0),
 	m_regs(owner.regs()),
 	m_owner(owner)
 {
@@ -419,6 +498,7 @@ void adpcm_b_channel::reset()
 	m_accumulator = 0;
 	m_prev_accum = 0;
 	m_adpcm_step = STEP_MIN;
+	detach_cache();
 }
 
 
@@ -428,6 +508,7 @@ void adpcm_b_channel::reset()
 
 void adpcm_b_channel::save_restore(ymfm_saved_state &state)
 {
+	detach_cache();
 	state.save_restore(m_status);
 	state.save_restore(m_curnibble);
 	state.save_restore(m_curbyte);
@@ -464,7 +545,13 @@ void adpcm_b_channel::clock()
 	{
 		// playing from RAM/ROM
 		if (m_regs.external())
-			m_curbyte = m_owner.intf().ymfm_external_read(ACCESS_ADPCM_B, m_curaddress);
+		{
+			// stop using the cache if memory changed underneath it
+			if (m_cache_nibbles != nullptr && m_cache_generation != m_owner.intf().ymfm_external_generation(ACCESS_ADPCM_B))
+				detach_cache();
+
+			m_curbyte = m_owner.intf().ymfm_read_external(ACCESS_ADPCM_B, m_curaddress);
+		}
 	}
 
 	// extract the nibble from our current byte
@@ -482,8 +569,39 @@ void adpcm_b_channel::clock()
 			{
 				// if repeating, go back to the start
 				if (m_regs.repeat())
+				{
 					load_start();
 
+					// continue from the cached repeat pass
+					if (m_cache_entry != nullptr)
+					{
+						decode_cache &entry = *m_cache_entry;
+						if (!cache_matches(entry))
+							detach_cache();
+						else
+						{
+							if (!entry.loop_valid)
+							{
+								int32_t accumulator = 0;
+								int32_t step = STEP_MIN;
+								decode_nibble(data, accumulator, step);
+								entry.loop.clear();
+								entry.loop.push_back({ int16_t(accumulator), int16_t(step) });
+								entry.cacheable = decode_pass(accumulator, step, entry.loop);
+								entry.loop_valid = true;
+							}
+							if (entry.cacheable)
+							{
+								m_cache_nibbles = entry.loop.data();
+								m_cache_count = uint32_t(entry.loop.size());
+								m_cache_index = 0;
+							}
+							else
+								detach_cache();
+						}
+					}
+				}
+
 				// otherwise, done; set the EOS bit
 				else
 				{
@@ -518,17 +636,155 @@ void adpcm_b_channel::clock()
 	// remember previous value for interpolation
 	m_prev_accum = m_accumulator;
 
+	// take the decoder state from the cache if we have it
+	if (m_cache_nibbles != nullptr)
+	{
+		if (m_cache_index < m_cache_count)
+		{
+			decoded_nibble const &nibble = m_cache_nibbles[m_cache_index++];
+			m_accumulator = nibble.accumulator;
+			m_adpcm_step = nibble.step;
+			return;
+		}
+		detach_cache();
+	}
+
+	decode_nibble(data, m_accumulator, m_adpcm_step);
+}
+
+
+//-------------------------------------------------
+//  decode_nibble - decode one ADPCM nibble
+//-------------------------------------------------
+
+void adpcm_b_channel::decode_nibble(uint8_t data, int32_t &accumulator, int32_t &step)
+{
 	// forecast to next forecast: 1/8, 3/8, 5/8, 7/8, 9/8, 11/8, 13/8, 15/8
-	int32_t delta = (2 * bitfield(data, 0, 3) + 1) * m_adpcm_step / 8;
+	int32_t delta = (2 * bitfield(data, 0, 3) + 1) * step / 8;
 	if (bitfield(data, 3))
 		delta = -delta;
 
 	// add and clamp to 16 bits
-	m_accumulator = clamp(m_accumulator + delta, -32768, 32767);
+	accumulator = clamp(accumulator + delta, -32768, 32767);
 
 	// scale the ADPCM step: 0.9, 0.9, 0.9, 0.9, 1.2, 1.6, 2.0, 2.4
 	static uint8_t const s_step_scale[8] = { 57, 57, 57, 57, 77, 102, 128, 153 };
-	m_adpcm_step = clamp((m_adpcm_step * s_step_scale[bitfield(data, 0, 3)]) / 64, STEP_MIN, STEP_MAX);
+	step = clamp((step * s_step_scale[bitfield(data, 0, 3)]) / 64, STEP_MIN, STEP_MAX);
+}
+
+
+//-------------------------------------------------
+//  decode_pass - decode one pass of the current
+//  sample, from the start address to the end
+//  address, into a cache vector
+//-------------------------------------------------
+
+bool adpcm_b_channel::decode_pass(int32_t accumulator, int32_t step, std::vector<decoded_nibble> &nibbles) const
+{
+	// give up on samples that would take more than 1MB to walk (for example
+	// when the end address is never reached)
+	static constexpr uint32_t MAX_BYTES = 0x100000;
+
+	// follow the same address sequence as clock()
+	uint32_t shift = address_shift();
+	uint32_t address = m_regs.start() << shift;
+	uint32_t end = ((m_regs.end() + 1) << shift) - 1;
+	uint32_t limit = ((m_regs.limit() + 1) << shift) - 1;
+
+	for (uint32_t count = 0; count < MAX_BYTES; count++)
+	{
+		uint8_t byte = m_owner.intf().ymfm_read_external(ACCESS_ADPCM_B, address);
+
+		decode_nibble(byte >> 4, accumulator, step);
+		nibbles.push_back({ int16_t(accumulator), int16_t(step) });
+
+		// the final nibble is not decoded; it ends or repeats the sample
+		if (address == end)
+			return true;
+
+		decode_nibble(byte & 0xf, accumulator, step);
+		nibbles.push_back({ int16_t(accumulator), int16_t(step) });
+
+		if (address == limit)
+			address = 0;
+		else
+			address = (address + 1) & 0xffffff;
+	}
+
+	nibbles.clear();
+	return false;
+}
+
+
+//-------------------------------------------------
+//  attach_cache - start playing from the cache
+//  after key on, building it if needed
+//-------------------------------------------------
+
+void adpcm_b_channel::attach_cache()
+{
+	detach_cache();
+
+	// only samples in directly readable memory can be cached
+	ymfm_interface &intf = m_owner.intf();
+	if (!m_regs.external() || !intf.ymfm_external_direct(ACCESS_ADPCM_B))
+		return;
+
+	// any change to the memory invalidates everything
+	uint32_t generation = intf.ymfm_external_generation(ACCESS_ADPCM_B);
+	if (generation != m_cache_generation)
+	{
+		m_cache.clear();
+		m_cache_generation = generation;
+	}
+
+	// decode the first pass on the first key on
+	auto [iter, inserted] = m_cache.try_emplace(m_regs.start());
+	decode_cache &entry = iter->second;
+	if (inserted || !cache_matches(entry))
+	{
+		entry.start = m_regs.start();
+		entry.end = m_regs.end();
+		entry.limit = m_regs.limit();
+		entry.shift = address_shift();
+		entry.loop_valid = false;
+		entry.loop.clear();
+		entry.first.clear();
+		entry.cacheable = decode_pass(0, STEP_MIN, entry.first);
+	}
+	if (!entry.cacheable)
+		return;
+
+	m_cache_entry = &entry;
+	m_cache_nibbles = entry.first.data();
+	m_cache_count = uint32_t(entry.first.size());
+	m_cache_index = 0;
+}
+
+
+//-------------------------------------------------
+//  detach_cache - stop playing from the cache
+//-------------------------------------------------
+
+void adpcm_b_channel::detach_cache()
+{
+	// the accumulator and step are always up to date, so the decoder can
+	// simply take over from here
+	m_cache_entry = nullptr;
+	m_cache_nibbles = nullptr;
+	m_cache_index = 0;
+	m_cache_count = 0;
+}
+
+
+//-------------------------------------------------
+//  cache_matches - return true if a cache entry
+//  was built with the current registers
+//-------------------------------------------------
+
+bool adpcm_b_channel::cache_matches(decode_cache const &entry) const
+{
+	return entry.start == m_regs.start() && entry.end == m_regs.end() && entry.limit == m_regs.limit() && entry.shift == address_shift();
 }
 
 
@@ -580,7 +836,7 @@ uint8_t adpcm_b_channel::read(uint32_t regnum)
 		else
 		{
 			// read from outside of the chip
-			result = m_owner.intf().ymfm_external_read(ACCESS_ADPCM_B, m_curaddress++);
+			result = m_owner.intf().ymfm_read_external(ACCESS_ADPCM_B, m_curaddress++);
 
 			// did we hit the end? if so, signal EOS
 			if (at_end())
@@ -613,9 +869,11 @@ void adpcm_b_channel::write(uint32_t regnum, uint8_t value)
 	// dummy read counter
 	if (regnum == 0x00)
 	{
+		detach_cache();
 		if (m_regs.execute())
 		{
 			load_start();
+			attach_cache();
 
 			// don't log masked channels
 			if ((debug::GLOBAL_ADPCM_B_CHANNEL_MASK & 1) != 0)
@@ -644,6 +902,14 @@ void adpcm_b_channel::write(uint32_t regnum, uint8_t value)
 			m_dummy_read = 2;
 	}
 
+	// changes to the address registers or the memory layout invalidate the
+	// sample being played from the cache
+	else if ((regnum <= 0x05 || regnum == 0x0c || regnum == 0x0d) && m_cache_entry != nullptr)
+	{
+		if (!cache_matches(*m_cache_entry))
+			detach_cache();
+	}
+
 	// register 8 writes over the bus under some conditions
 	else if (regnum == 0x08)
 	{
@@ -35,6 +35,8 @@
 
 #include "ymfm.h"
 
+#include <map>
+
 namespace ymfm
 {
 
@@ -144,10 +146,20 @@ public:
 	// master clockingfunction
 	bool clock();
 
+	// return true if the channel is silent until the next key on
+	bool idle() const { return m_playing == 0 && m_accumulator == 0; }
+
 	// return the computed output value, with panning applied
 	template<int NumOutputs>
 	void output(ymfm_output<NumOutputs> &output) const;
 
+	// attach pre-decoded PCM data; it is played instead of the external
+	// memory when the channel is keyed on with a matching start/end address
+	void set_pcm(uint32_t start, uint32_t end, int16_t const *pcm, uint32_t length);
+
+	// decode one ADPCM nibble, updating the accumulator and step index
+	static void decode_nibble(uint8_t data, int32_t &accumulator, int32_t &step_index);
+
 private:
 	// internal state
 	uint32_t const m_choffs;              // channel offset
@@ -155,9 +167,14 @@ private:
 	uint32_t m_playing;                   // currently playing?
 	uint32_t m_curnibble;                 // index of the current nibble
 	uint32_t m_curbyte;                   // current byte of data
-	uint32_t m_curaddress;                // current address
+	uint32_t m_curaddress;                // current address (or PCM index when playing pre-decoded data)
 	int32_t m_accumulator;                // accumulator
 	int32_t m_step_index;                 // index in the stepping table
+	int16_t const *m_pcm;                 // pre-decoded PCM data, or nullptr
+	uint32_t m_pcm_start;                 // start address the PCM data was decoded from
+	uint32_t m_pcm_end;                   // end address the PCM data was decoded to
+	uint32_t m_pcm_length;                // number of PCM samples
+	uint32_t m_pcm_playing;               // currently playing pre-decoded data?
 	adpcm_a_registers &m_regs;            // reference to registers
 	adpcm_a_engine &m_owner;              // reference to our owner
 };
@@ -182,6 +199,15 @@ public:
 	// master clocking function
 	uint32_t clock(uint32_t chanmask);
 
+	// return true if all channels are silent until the next key on
+	bool idle() const
+	{
+		for (auto const &chan : m_channel)
+			if (!chan->idle())
+				return false;
+		return true;
+	}
+
 	// compute sum of channel outputs
 	template<int NumOutputs>
 	void output(ymfm_output<NumOutputs> &output, uint32_t chanmask);
@@ -197,6 +223,16 @@ public:
 		m_regs.write_end(choffs, end);
 	}
 
+	// attach pre-decoded PCM data for a channel (for the YM2608 percussion ROM)
+	void set_pcm(uint8_t chnum, uint32_t start, uint32_t end, int16_t const *pcm, uint32_t length)
+	{
+		m_channel[chnum]->set_pcm(start, end, pcm, length);
+	}
+
+	// decode the ADPCM data between a start and end address into 16-bit PCM;
+	// the result matches what clock() produces when reading the same data
+	static void decode(uint8_t const *data, uint32_t size, uint32_t start, uint32_t end, uint32_t addrshift, std::vector<int16_t> &pcm);
+
 	// return a reference to our interface
 	ymfm_interface &intf() { return m_intf; }
 
@@ -328,6 +364,9 @@ public:
 	// return the status register
 	uint8_t status() const { return m_status; }
 
+	// return true if the channel is silent until the next key on
+	bool idle() const { return (m_status & STATUS_PLAYING) == 0 && m_accumulator == 0 && m_prev_accum == 0; }
+
 	// handle special register reads
 	uint8_t read(uint32_t regnum);
 
@@ -347,6 +386,43 @@ private:
 	// end checker; stops at the last byte of the chunk described by address_shift()
 	bool at_end() const { return (m_curaddress == (((m_regs.end() + 1) << address_shift()) - 1)); }
 
+	// decoder state after one nibble
+	struct decoded_nibble
+	{
+		int16_t accumulator;
+		int16_t step;
+	};
+
+	// pre-decoded sample, keyed by start address; "first" holds the nibbles
+	// played after key on, "loop" the nibbles played after each repeat (which
+	// starts by decoding the final nibble from a reset decoder)
+	struct decode_cache
+	{
+		uint32_t start;
+		uint32_t end;
+		uint32_t limit;
+		uint32_t shift;
+		bool cacheable;
+		bool loop_valid;
+		std::vector<decoded_nibble> first;
+		std::vector<decoded_nibble> loop;
+	};
+
+	// decode one nibble, updating the accumulator and step
+	static void decode_nibble(uint8_t data, int32_t &accumulator, int32_t &step);
+
+	// decode one pass of the current sample into a cache vector
+	bool decode_pass(int32_t accumulator, int32_t step, std::vector<decoded_nibble> &nibbles) const;
+
+	// start playing from the cache after key on, building it if needed
+	void attach_cache();
+
+	// stop playing from the cache and restore the state for nibble decoding
+	void detach_cache();
+
+	// return true if the cache entry still matches the registers
+	bool cache_matches(decode_cache const &entry) const;
+
 	// internal state
 	uint32_t const m_address_shift; // address bits shift-left
 	uint32_t m_status;              // currently playing?
@@ -358,6 +434,12 @@ private:
 	int32_t m_accumulator;          // accumulator
 	int32_t m_prev_accum;           // previous accumulator (for linear interp)
 	int32_t m_adpcm_step;           // next forecast
+	std::map<uint32_t, decode_cache> m_cache; // pre-decoded samples
+	uint32_t m_cache_generation;    // memory generation the cache was built from
+	decode_cache *m_cache_entry;    // cache entry being played, or nullptr
+	decoded_nibble const *m_cache_nibbles; // cached nibbles being played
+	uint32_t m_cache_index;         // index of the next cached nibble
+	uint32_t m_cache_count;         // number of cached nibbles being played
 	adpcm_b_registers &m_regs;      // reference to registers
 	adpcm_b_engine &m_owner;        // reference to our owner
 };
@@ -393,6 +475,9 @@ public:
 	// status
 	uint8_t status() const { return m_channel->status(); }
 
+	// return true if the channel is silent until the next key on
+	bool idle() const { return m_channel->idle(); }
+
 	// return a reference to our interface
 	ymfm_interface &intf() { return m_intf; }
 
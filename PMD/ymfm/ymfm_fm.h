@@ -33,6 +33,8 @@
 
 #pragma once
 
+#include "ymfm_fm_soa.h"
+
 #define YMFM_DEBUG_LOG_WAVFILES (0)
 
 namespace ymfm
@@ -168,8 +170,9 @@ class fm_operator
 	static constexpr uint32_t EG_QUIET = 0x380;
 
 public:
-	// constructor
-	fm_operator(fm_engine_base<RegisterType> &owner, uint32_t opoffs);
+	// constructor; slot and lane locate the operator's state in the owner's
+	// operator block
+	fm_operator(fm_engine_base<RegisterType> &owner, uint32_t opoffs, uint32_t slot, uint32_t lane);
 
 	// save/restore
 	void save_restore(ymfm_saved_state &state);
@@ -190,6 +193,14 @@ public:
 	// master clocking function
 	void clock(uint32_t env_counter, int32_t lfo_raw_pm);
 
+	// return true if clocking can change nothing but the phase until the next
+	// prepare(): the envelope is frozen and the phase step is fixed
+	bool settled() const { return m_env_skip_mask == ~0u && m_cache.phase_step != opdata_cache::PHASE_STEP_DYNAMIC; }
+
+	// advance a settled operator by any number of clocks; the engine steps
+	// the phase in the operator block
+	void skip();
+
 	// return the current phase value
 	uint32_t phase() const { return m_phase >> 10; }
 
@@ -223,6 +234,10 @@ private:
 	void clock_ssg_eg_state();
 	void clock_envelope(uint32_t env_counter);
 	void clock_phase(int32_t lfo_raw_pm);
+	void update_block();
+
+	// compute which envelope clocks can be skipped until the next prepare()
+	uint32_t envelope_skip_mask() const;
 
 	// return effective attenuation of the envelope
 	uint32_t envelope_attenuation(uint32_t am_offset) const;
@@ -230,12 +245,16 @@ private:
 	// internal state
 	uint32_t m_choffs;                     // channel offset in registers
 	uint32_t m_opoffs;                     // operator offset in registers
-	uint32_t m_phase;                      // current phase value (10.10 format)
+	uint32_t m_slot;                       // slot of the operator in the operator block
+	uint32_t m_lane;                       // lane of the operator in the operator block
+	uint32_t &m_phase;                     // current phase value (10.10 format)
+	uint32_t &m_phase_step;                // phase step applied by the next clock
 	uint16_t m_env_attenuation;            // computed envelope attenuation (4.6 format)
 	envelope_state m_env_state;            // current envelope state
 	uint8_t m_ssg_inverted;                // non-zero if the output should be inverted (bit 0)
 	uint8_t m_key_state;                   // current key state: on or off (bit 0)
 	uint8_t m_keyon_live;                  // live key on state (bit 0 = direct, bit 1 = rhythm, bit 2 = CSM)
+	uint32_t m_env_skip_mask;              // envelope clocks with any of these counter bits set are no-ops
 	opdata_cache m_cache;                  // cached values for performance
 	RegisterType &m_regs;                  // direct reference to registers
 	fm_engine_base<RegisterType> &m_owner; // reference to the owning engine
@@ -252,8 +271,9 @@ class fm_channel
 	using output_data = ymfm_output<RegisterType::OUTPUTS>;
 
 public:
-	// constructor
-	fm_channel(fm_engine_base<RegisterType> &owner, uint32_t choffs);
+	// constructor; lane locates the channel's state in the owner's operator
+	// block
+	fm_channel(fm_engine_base<RegisterType> &owner, uint32_t choffs, uint32_t lane);
 
 	// save/restore
 	void save_restore(ymfm_saved_state &state);
@@ -282,8 +302,20 @@ public:
 	// master clocking function
 	void clock(uint32_t env_counter, int32_t lfo_raw_pm);
 
-	// specific 2-operator and 4-operator output handlers
+	// return true if all of our operators are settled
+	bool settled() const;
+
+	// advance a settled channel by any number of clocks; the engine steps the
+	// phases and the feedback in the operator block
+	void skip();
+
+	// combine the operators using the output handler selected by prepare()
+	void output(output_data &output, uint32_t rshift, int32_t clipmax) const { (this->*m_output)(output, rshift, clipmax); }
+
+	// specific 2-operator and 4-operator output handlers; the 4-operator
+	// handler is specialized for each connection algorithm
 	void output_2op(output_data &output, uint32_t rshift, int32_t clipmax) const;
+	template<uint32_t Algorithm>
 	void output_4op(output_data &output, uint32_t rshift, int32_t clipmax) const;
 
 	// compute the special OPL rhythm channel outputs
@@ -326,10 +358,16 @@ private:
 			output.data[out3_index] += value;
 	}
 
+	// output handler type
+	using output_func = void (fm_channel::*)(output_data &output, uint32_t rshift, int32_t clipmax) const;
+
 	// internal state
 	uint32_t m_choffs;                     // channel offset in registers
-	int16_t m_feedback[2];                 // feedback memory for operator 1
-	mutable int16_t m_feedback_in;         // next input value for op 1 feedback (set in output)
+	uint32_t m_lane;                       // lane of the channel in the operator block
+	output_func m_output;                  // output handler for the current algorithm
+	int16_t &m_feedback0;                  // feedback memory for operator 1 (older value)
+	int16_t &m_feedback1;                  // feedback memory for operator 1 (newer value)
+	int16_t &m_feedback_in;                // next input value for op 1 feedback (set in output)
 	std::array<fm_operator<RegisterType> *, 4> m_op; // up to 4 operators
 	RegisterType &m_regs;                  // direct reference to registers
 	fm_engine_base<RegisterType> &m_owner; // reference to the owning engine
@@ -360,6 +398,10 @@ public:
 	// expose the correct output class
 	using output_data = ymfm_output<OUTPUTS>;
 
+	// the operator block covers 4-operator engines with fixed operators and
+	// up to 8 channels, which are all the OPN families
+	static_assert(OPERATORS == 4 * CHANNELS && CHANNELS <= fm_operator_block::LANES && !RegisterType::DYNAMIC_OPS && OUTPUTS <= 2, "unsupported FM engine layout");
+
 	// constructor
 	fm_engine_base(ymfm_interface &intf);
 
@@ -375,6 +417,9 @@ public:
 	// compute sum of channel outputs
 	void output(output_data &output, uint32_t rshift, int32_t clipmax, uint32_t chanmask) const;
 
+	// compute the output of each channel into its own entry of outputs
+	void output_channels(output_data *outputs, uint32_t rshift, int32_t clipmax, uint32_t chanmask) const;
+
 	// write to the OPN registers
 	void write(uint16_t regnum, uint8_t data);
 
@@ -414,12 +459,28 @@ public:
 	// return a reference to our registers
 	RegisterType &regs() { return m_regs; }
 
+	// return a reference to the operator block
+	fm_operator_block &block() { return m_block; }
+
+	// return or select the backend that steps and combines the operators
+	fm_operator_backend const &backend() const { return *m_backend; }
+	void set_backend(fm_operator_backend const &backend) { m_backend = &backend; }
+
 	// invalidate any caches
 	void invalidate_caches() { m_modified_channels = RegisterType::ALL_CHANNELS; }
 
+	// return true if no channel is producing output, no register write is
+	// waiting to be prepared, and the channels in chanmask are settled so that
+	// skip() can stand in for clock()
+	bool idle(uint32_t chanmask) const;
+
+	// advance an idle engine by the given number of clocks, leaving it in the
+	// state the same number of clock() calls would
+	void skip(uint32_t clocks, uint32_t chanmask);
+
 	// simple getters for debugging
-	fm_channel<RegisterType> *debug_channel(uint32_t index) const { return m_channel[index].get(); }
-	fm_operator<RegisterType> *debug_operator(uint32_t index) const { return m_operator[index].get(); }
+	fm_channel<RegisterType> const *debug_channel(uint32_t index) const { return &m_channel[index]; }
+	fm_operator<RegisterType> const *debug_operator(uint32_t index) const { return &m_operator[index]; }
 
 public:
 	// timer callback; called by the interface when a timer fires
@@ -451,8 +512,10 @@ protected:
 	uint32_t m_modified_channels;    // mask of channels that have been modified
 	uint32_t m_prepare_count;        // counter to do periodic prepare sweeps
 	RegisterType m_regs;             // register accessor
-	std::unique_ptr<fm_channel<RegisterType>> m_channel[CHANNELS]; // channel pointers
-	std::unique_ptr<fm_operator<RegisterType>> m_operator[OPERATORS]; // operator pointers
+	fm_operator_backend const *m_backend; // backend that steps and combines the operators
+	fm_operator_block m_block;       // state of the operators and channels as structure of arrays
+	std::vector<fm_channel<RegisterType>> m_channel;   // channels
+	std::vector<fm_operator<RegisterType>> m_operator; // operators
 #if (YMFM_DEBUG_LOG_WAVFILES)
 	mutable ymfm_wavfile<1> m_wavfile[CHANNELS]; // for debugging
 #endif
@@ -371,18 +371,25 @@ inline int32_t opn_lfo_pm_phase_adjustment(uint32_t fnum_bits, uint32_t pm_sensi
 //-------------------------------------------------
 
 template<class RegisterType>
-fm_operator<RegisterType>::fm_operator(fm_engine_base<RegisterType> &owner, uint32_t opoffs) :
+fm_operator<RegisterType>::fm_operator(fm_engine_base<RegisterType> &owner, uint32_t opoffs, uint32_t slot, uint32_t lane) :
 	m_choffs(0),
 	m_opoffs(opoffs),
-	m_phase(0),
+	m_slot(slot),
+	m_lane(lane),
+	m_phase(owner.block().phase[slot][lane]),
+	m_phase_step(owner.block().phase_step[slot][lane]),
 	m_env_attenuation(0x3ff),
 	m_env_state(EG_RELEASE),
 	m_ssg_inverted(false),
 	m_key_state(0),
 	m_keyon_live(0),
+	m_env_skip_mask(0),
 	m_regs(owner.regs()),
 	m_owner(owner)
 {
+	m_phase = 0;
+	m_phase_step = 0;
+	update_block();
 }
 
 
@@ -400,6 +407,8 @@ void fm_operator<RegisterType>::reset()
 	m_ssg_inverted = 0;
 	m_key_state = 0;
 	m_keyon_live = 0;
+	m_env_skip_mask = 0;
+	update_block();
 }
 
 
@@ -416,6 +425,8 @@ void fm_operator<RegisterType>::save_restore(ymfm_saved_state &state)
 	state.save_restore(m_ssg_inverted);
 	state.save_restore(m_key_state);
 	state.save_restore(m_keyon_live);
+	m_env_skip_mask = 0;
+	update_block();
 }
 
 
@@ -433,6 +444,20 @@ bool fm_operator<RegisterType>::prepare()
 	clock_keystate(uint32_t(m_keyon_live != 0));
 	m_keyon_live &= ~(1 << KEYON_CSM);
 
+	// registers or key state may have changed; clock the envelope fully
+	// until it has been re-evaluated
+	m_env_skip_mask = 0;
+
+	// capture what the backends need to step the phase and to compute the
+	// volume from the operator block; the OPN registers never set an
+	// envelope shift
+	assert(m_cache.eg_shift == 0);
+	fm_operator_block &block = m_owner.block();
+	block.total_level[m_slot][m_lane] = uint16_t(m_cache.total_level);
+	block.am_enable[m_slot][m_lane] = m_regs.op_lfo_am_enable(m_opoffs) ? -1 : 0;
+	m_phase_step = m_cache.phase_step;
+	update_block();
+
 	// we're active until we're quiet after the release
 	return (m_env_state != (RegisterType::EG_HAS_REVERB ? EG_REVERB : EG_RELEASE) || m_env_attenuation < EG_QUIET);
 }
@@ -451,12 +476,33 @@ void fm_operator<RegisterType>::clock(uint32_t env_counter, int32_t lfo_raw_pm)
 	else
 		m_ssg_inverted = false;
 
-	// clock the envelope if on an envelope cycle; env_counter is a x.2 value
-	if (bitfield(env_counter, 0, 2) == 0)
+	// clock the envelope if on an envelope cycle; env_counter is a x.2 value;
+	// skip the cycles where we already know nothing will change
+	if (bitfield(env_counter, 0, 2) == 0 && ((env_counter >> 2) & m_env_skip_mask) == 0)
+	{
 		clock_envelope(env_counter >> 2);
+		m_env_skip_mask = envelope_skip_mask();
+	}
 
 	// clock the phase
 	clock_phase(lfo_raw_pm);
+
+	update_block();
+}
+
+
+//-------------------------------------------------
+//  skip - advance a settled operator; clock()
+//  would only clear the SSG-EG inversion, since
+//  SSG-EG is off, and leave the envelope alone
+//-------------------------------------------------
+
+template<class RegisterType>
+void fm_operator<RegisterType>::skip()
+{
+	m_ssg_inverted = false;
+
+	update_block();
 }
 
 
@@ -740,6 +786,43 @@ void fm_operator<RegisterType>::clock_envelope(uint32_t env_counter)
 }
 
 
+//-------------------------------------------------
+//  envelope_skip_mask - return a mask of envelope
+//  counter bits; clock_envelope() has no effect on
+//  any counter with one of these bits set, for as
+//  long as the registers and key state are unchanged
+//-------------------------------------------------
+
+template<class RegisterType>
+uint32_t fm_operator<RegisterType>::envelope_skip_mask() const
+{
+	// SSG-EG can change the envelope on any clock
+	if (m_regs.op_ssg_eg_enable(m_opoffs))
+		return 0;
+
+	// attack->decay and decay->sustain transitions happen on the next clock
+	if ((m_env_state == EG_ATTACK && m_env_attenuation == 0) || (m_env_state == EG_DECAY && m_env_attenuation >= m_cache.eg_sustain))
+		return 0;
+
+	// depress->attack and release->reverb transitions happen on the next
+	// clock that applies the rate
+	bool pending =
+		(RegisterType::EG_HAS_DEPRESS && m_env_state == EG_DEPRESS && m_env_attenuation >= 0x200) ||
+		(RegisterType::EG_HAS_REVERB && m_env_state == EG_RELEASE && m_env_attenuation >= 0xc0);
+
+	// nothing ever changes if the rate has no increments, or if the
+	// attenuation is already clamped at its maximum
+	uint32_t rate = m_cache.eg_rate[m_env_state];
+	if (!pending && (rate < 2 || (m_env_state != EG_ATTACK && m_env_attenuation == 0x3ff)))
+		return ~0;
+
+	// otherwise only the clocks that apply the rate matter; these are the
+	// ones where the env_counter fraction computed in clock_envelope() is 0
+	uint32_t rate_shift = rate >> 2;
+	return (rate_shift < 11) ? ((1 << (11 - rate_shift)) - 1) : 0;
+}
+
+
 //-------------------------------------------------
 //  clock_phase - clock the 10.10 phase value; the
 //  OPN version of the logic has been verified
@@ -749,13 +832,24 @@ void fm_operator<RegisterType>::clock_envelope(uint32_t env_counter)
 template<class RegisterType>
 void fm_operator<RegisterType>::clock_phase(int32_t lfo_raw_pm)
 {
-	// read from the cache, or recalculate if PM active
-	uint32_t phase_step = m_cache.phase_step;
-	if (phase_step == opdata_cache::PHASE_STEP_DYNAMIC)
-		phase_step = m_regs.compute_phase_step(m_choffs, m_opoffs, m_cache, lfo_raw_pm);
+	// prepare() stored the step from the cache; recalculate it if PM is
+	// active; the engine's backend applies the steps of all operators at once
+	if (m_cache.phase_step == opdata_cache::PHASE_STEP_DYNAMIC)
+		m_phase_step = m_regs.compute_phase_step(m_choffs, m_opoffs, m_cache, lfo_raw_pm);
+}
+
 
-	// finally apply the step to the current phase value
-	m_phase += phase_step;
+//-------------------------------------------------
+//  update_block - copy the envelope state the
+//  backends read into the operator block
+//-------------------------------------------------
+
+template<class RegisterType>
+void fm_operator<RegisterType>::update_block()
+{
+	fm_operator_block &block = m_owner.block();
+	block.env_attenuation[m_slot][m_lane] = m_env_attenuation;
+	block.ssg_inverted[m_slot][m_lane] = m_ssg_inverted;
 }
 
 
@@ -790,19 +884,75 @@ uint32_t fm_operator<RegisterType>::envelope_attenuation(uint32_t am_offset) con
 //  FM CHANNEL
 //*********************************************************
 
+//-------------------------------------------------
+//  fm_algorithm_ops - inputs and outputs of the
+//  4-operator connection algorithms
+//-------------------------------------------------
+
+// OPM/OPN offer 8 different connection algorithms for 4 operators,
+// and OPL3 offers 4 more, which we designate here as 8-11.
+//
+// The operators are computed in order, with the inputs pulled from
+// an array of values (opout) that is populated as we go:
+//    0 = 0
+//    1 = O1
+//    2 = O2
+//    3 = O3
+//    4 = (O4)
+//    5 = O1+O2
+//    6 = O1+O3
+//    7 = O2+O3
+//
+// The table describes the inputs and outputs of each algorithm as
+// follows:
+//
+//      ---------x use opout[x] as operator 2 input
+//      ------xxx- use opout[x] as operator 3 input
+//      ---xxx---- use opout[x] as operator 4 input
+//      --x------- include opout[1] in final sum
+//      -x-------- include opout[2] in final sum
+//      x--------- include opout[3] in final sum
+#define ALGORITHM(op2in, op3in, op4in, op1out, op2out, op3out) \
+	((op2in) | ((op3in) << 1) | ((op4in) << 4) | ((op1out) << 7) | ((op2out) << 8) | ((op3out) << 9))
+constexpr uint16_t fm_algorithm_ops[8+4] =
+{
+	ALGORITHM(1,2,3, 0,0,0),    //  0: O1 -> O2 -> O3 -> O4 -> out (O4)
+	ALGORITHM(0,5,3, 0,0,0),    //  1: (O1 + O2) -> O3 -> O4 -> out (O4)
+	ALGORITHM(0,2,6, 0,0,0),    //  2: (O1 + (O2 -> O3)) -> O4 -> out (O4)
+	ALGORITHM(1,0,7, 0,0,0),    //  3: ((O1 -> O2) + O3) -> O4 -> out (O4)
+	ALGORITHM(1,0,3, 0,1,0),    //  4: ((O1 -> O2) + (O3 -> O4)) -> out (O2+O4)
+	ALGORITHM(1,1,1, 0,1,1),    //  5: ((O1 -> O2) + (O1 -> O3) + (O1 -> O4)) -> out (O2+O3+O4)
+	ALGORITHM(1,0,0, 0,1,1),    //  6: ((O1 -> O2) + O3 + O4) -> out (O2+O3+O4)
+	ALGORITHM(0,0,0, 1,1,1),    //  7: (O1 + O2 + O3 + O4) -> out (O1+O2+O3+O4)
+	ALGORITHM(1,2,3, 0,0,0),    //  8: O1 -> O2 -> O3 -> O4 -> out (O4)         [same as 0]
+	ALGORITHM(0,2,3, 1,0,0),    //  9: (O1 + (O2 -> O3 -> O4)) -> out (O1+O4)   [unique]
+	ALGORITHM(1,0,3, 0,1,0),    // 10: ((O1 -> O2) + (O3 -> O4)) -> out (O2+O4) [same as 4]
+	ALGORITHM(0,2,0, 1,0,1)     // 11: (O1 + (O2 -> O3) + O4) -> out (O1+O3+O4) [unique]
+};
+#undef ALGORITHM
+
+// the operators each entry of the opout table adds up; bit 0 = O1,
+// bit 1 = O2, bit 2 = O3
+constexpr uint8_t fm_opout_sources[8] = { 0, 1, 2, 4, 0, 3, 5, 6 };
+
 //-------------------------------------------------
 //  fm_channel - constructor
 //-------------------------------------------------
 
 template<class RegisterType>
-fm_channel<RegisterType>::fm_channel(fm_engine_base<RegisterType> &owner, uint32_t choffs) :
+fm_channel<RegisterType>::fm_channel(fm_engine_base<RegisterType> &owner, uint32_t choffs, uint32_t lane) :
 	m_choffs(choffs),
-	m_feedback{ 0, 0 },
-	m_feedback_in(0),
+	m_lane(lane),
+	m_output((RegisterType::OPERATORS / RegisterType::CHANNELS == 4) ? &fm_channel::template output_4op<0> : &fm_channel::output_2op),
+	m_feedback0(owner.block().feedback[0][lane]),
+	m_feedback1(owner.block().feedback[1][lane]),
+	m_feedback_in(owner.block().feedback_in[lane]),
 	m_op{ nullptr, nullptr, nullptr, nullptr },
 	m_regs(owner.regs()),
 	m_owner(owner)
 {
+	m_feedback0 = m_feedback1 = 0;
+	m_feedback_in = 0;
 }
 
 
@@ -814,7 +964,7 @@ template<class RegisterType>
 void fm_channel<RegisterType>::reset()
 {
 	// reset our data
-	m_feedback[0] = m_feedback[1] = 0;
+	m_feedback0 = m_feedback1 = 0;
 	m_feedback_in = 0;
 }
 
@@ -826,8 +976,8 @@ void fm_channel<RegisterType>::reset()
 template<class RegisterType>
 void fm_channel<RegisterType>::save_restore(ymfm_saved_state &state)
 {
-	state.save_restore(m_feedback[0]);
-	state.save_restore(m_feedback[1]);
+	state.save_restore(m_feedback0);
+	state.save_restore(m_feedback1);
 	state.save_restore(m_feedback_in);
 }
 
@@ -865,6 +1015,43 @@ bool fm_channel<RegisterType>::prepare()
 			if (m_op[opnum]->prepare())
 				active_mask |= 1 << opnum;
 
+	// select the output handler; this runs after every register write, so it
+	// tracks changes to the algorithm
+	static output_func const s_output_4op[8+4] =
+	{
+		&fm_channel::template output_4op<0>,
+		&fm_channel::template output_4op<1>,
+		&fm_channel::template output_4op<2>,
+		&fm_channel::template output_4op<3>,
+		&fm_channel::template output_4op<4>,
+		&fm_channel::template output_4op<5>,
+		&fm_channel::template output_4op<6>,
+		&fm_channel::template output_4op<7>,
+		&fm_channel::template output_4op<8>,
+		&fm_channel::template output_4op<9>,
+		&fm_channel::template output_4op<10>,
+		&fm_channel::template output_4op<11>
+	};
+	m_output = is4op() ? s_output_4op[m_regs.ch_algorithm(m_choffs)] : &fm_channel::output_2op;
+
+	// capture how the backends combine the operators in the operator block
+	fm_operator_block &block = m_owner.block();
+	uint32_t feedback = m_regs.ch_feedback(m_choffs);
+	block.feedback_scale[m_lane] = (feedback != 0) ? (1 << feedback) : 0;
+
+	uint32_t algorithm_ops = fm_algorithm_ops[m_regs.ch_algorithm(m_choffs)];
+	uint32_t const inputs[3] = { bitfield(algorithm_ops, 0, 1), bitfield(algorithm_ops, 1, 3), bitfield(algorithm_ops, 4, 3) };
+	for (uint32_t index = 0; index < 3; index++)
+		for (uint32_t op = 0; op < 3; op++)
+		{
+			block.modulation[index][op][m_lane] = bitfield(fm_opout_sources[inputs[index]], op) ? -1 : 0;
+			block.sum[op][m_lane] = bitfield(algorithm_ops, 7 + op) ? -1 : 0;
+		}
+
+	uint32_t output_any = m_regs.ch_output_any(m_choffs);
+	block.output_enable[0][m_lane] = (output_any != 0 && (RegisterType::OUTPUTS == 1 || m_regs.ch_output_0(m_choffs))) ? -1 : 0;
+	block.output_enable[1][m_lane] = (output_any != 0 && RegisterType::OUTPUTS >= 2 && m_regs.ch_output_1(m_choffs)) ? -1 : 0;
+
 	return (active_mask != 0);
 }
 
@@ -876,9 +1063,9 @@ bool fm_channel<RegisterType>::prepare()
 template<class RegisterType>
 void fm_channel<RegisterType>::clock(uint32_t env_counter, int32_t lfo_raw_pm)
 {
-	// clock the feedback through
-	m_feedback[0] = m_feedback[1];
-	m_feedback[1] = m_feedback_in;
+	// the engine's backend clocks the feedback through; capture the LFO AM
+	// offset the backend computes the volumes with
+	m_owner.block().am_offset[m_lane] = m_regs.lfo_am_offset(m_choffs);
 
 	for (uint32_t opnum = 0; opnum < m_op.size(); opnum++)
 		if (m_op[opnum] != nullptr)
@@ -903,6 +1090,36 @@ printf(" -- ");
 }
 
 
+//-------------------------------------------------
+//  settled - return true if all operators are
+//  settled
+//-------------------------------------------------
+
+template<class RegisterType>
+bool fm_channel<RegisterType>::settled() const
+{
+	for (uint32_t opnum = 0; opnum < m_op.size(); opnum++)
+		if (m_op[opnum] != nullptr && !m_op[opnum]->settled())
+			return false;
+	return true;
+}
+
+
+//-------------------------------------------------
+//  skip - advance a settled channel
+//-------------------------------------------------
+
+template<class RegisterType>
+void fm_channel<RegisterType>::skip()
+{
+	m_owner.block().am_offset[m_lane] = m_regs.lfo_am_offset(m_choffs);
+
+	for (uint32_t opnum = 0; opnum < m_op.size(); opnum++)
+		if (m_op[opnum] != nullptr)
+			m_op[opnum]->skip();
+}
+
+
 //-------------------------------------------------
 //  output_2op - combine 4 operators according to
 //  the specified algorithm, returning a sum
@@ -924,7 +1141,7 @@ void fm_channel<RegisterType>::output_2op(output_data &output, uint32_t rshift,
 	int32_t opmod = 0;
 	uint32_t feedback = m_regs.ch_feedback(m_choffs);
 	if (feedback != 0)
-		opmod = (m_feedback[0] + m_feedback[1]) >> (10 - feedback);
+		opmod = (m_feedback0 + m_feedback1) >> (10 - feedback);
 
 	// compute the 14-bit volume/value of operator 1 and update the feedback
 	int32_t op1value = m_feedback_in = m_op[0]->compute_volume(m_op[0]->phase() + opmod, am_offset);
@@ -942,12 +1159,12 @@ void fm_channel<RegisterType>::output_2op(output_data &output, uint32_t rshift,
 	{
 		// some OPL chips use the previous sample for modulation instead of
 		// the current sample
-		opmod = (RegisterType::MODULATOR_DELAY ? m_feedback[1] : op1value) >> 1;
+		opmod = (RegisterType::MODULATOR_DELAY ? m_feedback1 : op1value) >> 1;
 		result = m_op[1]->compute_volume(m_op[1]->phase() + opmod, am_offset) >> rshift;
 	}
 	else
 	{
-		result = (RegisterType::MODULATOR_DELAY ? m_feedback[1] : op1value) >> rshift;
+		result = (RegisterType::MODULATOR_DELAY ? m_feedback1 : op1value) >> rshift;
 		result += m_op[1]->compute_volume(m_op[1]->phase(), am_offset) >> rshift;
 		int32_t clipmin = -clipmax - 1;
 		result = clamp(result, clipmin, clipmax);
@@ -960,12 +1177,13 @@ void fm_channel<RegisterType>::output_2op(output_data &output, uint32_t rshift,
 
 //-------------------------------------------------
 //  output_4op - combine 4 operators according to
-//  the specified algorithm, returning a sum
+//  the given algorithm, returning a sum
 //  according to the rshift and clipmax parameters,
 //  which vary between different implementations
 //-------------------------------------------------
 
 template<class RegisterType>
+template<uint32_t Algorithm>
 void fm_channel<RegisterType>::output_4op(output_data &output, uint32_t rshift, int32_t clipmax) const
 {
 	// all 4 operators should be populated
@@ -981,7 +1199,7 @@ void fm_channel<RegisterType>::output_4op(output_data &output, uint32_t rshift,
 	int32_t opmod = 0;
 	uint32_t feedback = m_regs.ch_feedback(m_choffs);
 	if (feedback != 0)
-		opmod = (m_feedback[0] + m_feedback[1]) >> (10 - feedback);
+		opmod = (m_feedback0 + m_feedback1) >> (10 - feedback);
 
 	// compute the 14-bit volume/value of operator 1 and update the feedback
 	int32_t op1value = m_feedback_in = m_op[0]->compute_volume(m_op[0]->phase() + opmod, am_offset);
@@ -992,46 +1210,12 @@ void fm_channel<RegisterType>::output_4op(output_data &output, uint32_t rshift,
 		return;
 
 	// OPM/OPN offer 8 different connection algorithms for 4 operators,
-	// and OPL3 offers 4 more, which we designate here as 8-11.
-	//
-	// The operators are computed in order, with the inputs pulled from
-	// an array of values (opout) that is populated as we go:
-	//    0 = 0
-	//    1 = O1
-	//    2 = O2
-	//    3 = O3
-	//    4 = (O4)
-	//    5 = O1+O2
-	//    6 = O1+O3
-	//    7 = O2+O3
-	//
-	// The s_algorithm_ops table describes the inputs and outputs of each
-	// algorithm as follows:
+	// and OPL3 offers 4 more, which we designate here as 8-11; see
+	// fm_algorithm_ops for how they are encoded
 	//
-	//      ---------x use opout[x] as operator 2 input
-	//      ------xxx- use opout[x] as operator 3 input
-	//      ---xxx---- use opout[x] as operator 4 input
-	//      --x------- include opout[1] in final sum
-	//      -x-------- include opout[2] in final sum
-	//      x--------- include opout[3] in final sum
-	#define ALGORITHM(op2in, op3in, op4in, op1out, op2out, op3out) \
-		((op2in) | ((op3in) << 1) | ((op4in) << 4) | ((op1out) << 7) | ((op2out) << 8) | ((op3out) << 9))
-	static uint16_t const s_algorithm_ops[8+4] =
-	{
-		ALGORITHM(1,2,3, 0,0,0),    //  0: O1 -> O2 -> O3 -> O4 -> out (O4)
-		ALGORITHM(0,5,3, 0,0,0),    //  1: (O1 + O2) -> O3 -> O4 -> out (O4)
-		ALGORITHM(0,2,6, 0,0,0),    //  2: (O1 + (O2 -> O3)) -> O4 -> out (O4)
-		ALGORITHM(1,0,7, 0,0,0),    //  3: ((O1 -> O2) + O3) -> O4 -> out (O4)
-		ALGORITHM(1,0,3, 0,1,0),    //  4: ((O1 -> O2) + (O3 -> O4)) -> out (O2+O4)
-		ALGORITHM(1,1,1, 0,1,1),    //  5: ((O1 -> O2) + (O1 -> O3) + (O1 -> O4)) -> out (O2+O3+O4)
-		ALGORITHM(1,0,0, 0,1,1),    //  6: ((O1 -> O2) + O3 + O4) -> out (O2+O3+O4)
-		ALGORITHM(0,0,0, 1,1,1),    //  7: (O1 + O2 + O3 + O4) -> out (O1+O2+O3+O4)
-		ALGORITHM(1,2,3, 0,0,0),    //  8: O1 -> O2 -> O3 -> O4 -> out (O4)         [same as 0]
-		ALGORITHM(0,2,3, 1,0,0),    //  9: (O1 + (O2 -> O3 -> O4)) -> out (O1+O4)   [unique]
-		ALGORITHM(1,0,3, 0,1,0),    // 10: ((O1 -> O2) + (O3 -> O4)) -> out (O2+O4) [same as 4]
-		ALGORITHM(0,2,0, 1,0,1)     // 11: (O1 + (O2 -> O3) + O4) -> out (O1+O3+O4) [unique]
-	};
-	uint32_t algorithm_ops = s_algorithm_ops[m_regs.ch_algorithm(m_choffs)];
+	// Since the algorithm is a template parameter, the table lookups below
+	// are resolved at compile time and the unused paths drop out.
+	constexpr uint32_t algorithm_ops = fm_algorithm_ops[Algorithm];
 
 	// populate the opout table
 	int16_t opout[8];
@@ -1039,12 +1223,12 @@ void fm_channel<RegisterType>::output_4op(output_data &output, uint32_t rshift,
 	opout[1] = op1value;
 
 	// compute the 14-bit volume/value of operator 2
-	opmod = opout[bitfield(algorithm_ops, 0, 1)] >> 1;
+	opmod = opout[algorithm_ops & 1] >> 1;
 	opout[2] = m_op[1]->compute_volume(m_op[1]->phase() + opmod, am_offset);
 	opout[5] = opout[1] + opout[2];
 
 	// compute the 14-bit volume/value of operator 3
-	opmod = opout[bitfield(algorithm_ops, 1, 3)] >> 1;
+	opmod = opout[(algorithm_ops >> 1) & 7] >> 1;
 	opout[3] = m_op[2]->compute_volume(m_op[2]->phase() + opmod, am_offset);
 	opout[6] = opout[1] + opout[3];
 	opout[7] = opout[2] + opout[3];
@@ -1056,18 +1240,18 @@ void fm_channel<RegisterType>::output_4op(output_data &output, uint32_t rshift,
 		result = m_op[3]->compute_noise_volume(am_offset);
 	else
 	{
-		opmod = opout[bitfield(algorithm_ops, 4, 3)] >> 1;
+		opmod = opout[(algorithm_ops >> 4) & 7] >> 1;
 		result = m_op[3]->compute_volume(m_op[3]->phase() + opmod, am_offset);
 	}
 	result >>= rshift;
 
 	// optionally add OP1, OP2, OP3
 	int32_t clipmin = -clipmax - 1;
-	if (bitfield(algorithm_ops, 7) != 0)
+	if constexpr (((algorithm_ops >> 7) & 1) != 0)
 		result = clamp(result + (opout[1] >> rshift), clipmin, clipmax);
-	if (bitfield(algorithm_ops, 8) != 0)
+	if constexpr (((algorithm_ops >> 8) & 1) != 0)
 		result = clamp(result + (opout[2] >> rshift), clipmin, clipmax);
-	if (bitfield(algorithm_ops, 9) != 0)
+	if constexpr (((algorithm_ops >> 9) & 1) != 0)
 		result = clamp(result + (opout[3] >> rshift), clipmin, clipmax);
 
 	// add to the output
@@ -1095,7 +1279,7 @@ void fm_channel<RegisterType>::output_rhythm_ch6(output_data &output, uint32_t r
 	int32_t opmod = 0;
 	uint32_t feedback = m_regs.ch_feedback(m_choffs);
 	if (feedback != 0)
-		opmod = (m_feedback[0] + m_feedback[1]) >> (10 - feedback);
+		opmod = (m_feedback0 + m_feedback1) >> (10 - feedback);
 
 	// compute the 14-bit volume/value of operator 1 and update the feedback
 	int32_t opout1 = m_feedback_in = m_op[0]->compute_volume(m_op[0]->phase() + opmod, am_offset);
@@ -1188,18 +1372,37 @@ fm_engine_base<RegisterType>::fm_engine_base(ymfm_interface &intf) :
 	m_total_clocks(0),
 	m_active_channels(ALL_CHANNELS),
 	m_modified_channels(ALL_CHANNELS),
-	m_prepare_count(0)
+	m_prepare_count(0),
+	m_backend(&fm_default_backend()),
+	m_block()
 {
 	// inform the interface of their engine
 	m_intf.m_engine = this;
 
-	// create the channels
+	// create the channels and operators in contiguous storage, so the
+	// per-sample walks in clock() and output() stay within a few cache lines;
+	// the storage is reserved up front and never reallocated, as channels
+	// hold pointers to their operators
+	m_channel.reserve(CHANNELS);
 	for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
-		m_channel[chnum] = std::make_unique<fm_channel<RegisterType>>(*this, RegisterType::channel_offset(chnum));
+		m_channel.emplace_back(*this, RegisterType::channel_offset(chnum), chnum);
+
+	// each operator keeps its state in the operator block at the slot and
+	// lane of the channel it is assigned to; the assignment never changes
+	typename RegisterType::operator_mapping map;
+	m_regs.operator_map(map);
 
-	// create the operators
+	m_operator.reserve(OPERATORS);
 	for (uint32_t opnum = 0; opnum < OPERATORS; opnum++)
-		m_operator[opnum] = std::make_unique<fm_operator<RegisterType>>(*this, RegisterType::operator_offset(opnum));
+	{
+		uint32_t slot = 0, lane = 0;
+		for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
+			for (uint32_t index = 0; index < 4; index++)
+				if (bitfield(map.chan[chnum], 8 * index, 8) == opnum)
+					slot = index, lane = chnum;
+
+		m_operator.emplace_back(*this, RegisterType::operator_offset(opnum), slot, lane);
+	}
 
 #if (YMFM_DEBUG_LOG_WAVFILES)
 	for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
@@ -1230,11 +1433,11 @@ void fm_engine_base<RegisterType>::reset()
 
 	// reset the channels
 	for (auto &chan : m_channel)
-		chan->reset();
+		chan.reset();
 
 	// reset the operators
 	for (auto &op : m_operator)
-		op->reset();
+		op.reset();
 }
 
 
@@ -1260,11 +1463,11 @@ void fm_engine_base<RegisterType>::save_restore(ymfm_saved_state &state)
 
 	// save channel data
 	for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
-		m_channel[chnum]->save_restore(state);
+		m_channel[chnum].save_restore(state);
 
 	// save operator data
 	for (uint32_t opnum = 0; opnum < OPERATORS; opnum++)
-		m_operator[opnum]->save_restore(state);
+		m_operator[opnum].save_restore(state);
 
 	// invalidate any caches
 	invalidate_caches();
@@ -1294,7 +1497,7 @@ uint32_t fm_engine_base<RegisterType>::clock(uint32_t chanmask)
 		m_active_channels = 0;
 		for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
 			if (bitfield(chanmask, chnum))
-				if (m_channel[chnum]->prepare())
+				if (m_channel[chnum].prepare())
 					m_active_channels |= 1 << chnum;
 
 		// reset the modified channels and prepare count
@@ -1314,13 +1517,83 @@ uint32_t fm_engine_base<RegisterType>::clock(uint32_t chanmask)
 	// now update the state of all the channels and operators
 	for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
 		if (bitfield(chanmask, chnum))
-			m_channel[chnum]->clock(m_env_counter, lfo_raw_pm);
+			m_channel[chnum].clock(m_env_counter, lfo_raw_pm);
+
+	// clock the feedback and the phases of all channels at once
+	m_backend->clock(m_block, chanmask & ALL_CHANNELS);
 
 	// return the envelope counter as it is used to clock ADPCM-A
 	return m_env_counter;
 }
 
 
+//-------------------------------------------------
+//  idle - return true if the engine outputs
+//  silence until the next register write and
+//  skip() can advance it
+//-------------------------------------------------
+
+template<class RegisterType>
+bool fm_engine_base<RegisterType>::idle(uint32_t chanmask) const
+{
+	if (m_active_channels != 0 || m_modified_channels != 0)
+		return false;
+
+	// a silent channel may still have an envelope or a phase step that
+	// changes from clock to clock
+	for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
+		if (bitfield(chanmask, chnum) && !m_channel[chnum].settled())
+			return false;
+	return true;
+}
+
+
+//-------------------------------------------------
+//  skip - advance an idle engine by a number of
+//  clocks at once; the counters are stepped in
+//  closed form and the periodic prepare() finds
+//  nothing to change while idle
+//-------------------------------------------------
+
+template<class RegisterType>
+void fm_engine_base<RegisterType>::skip(uint32_t clocks, uint32_t chanmask)
+{
+	if (clocks == 0)
+		return;
+
+	m_total_clocks += clocks;
+	m_prepare_count = uint32_t((uint64_t(m_prepare_count) + clocks) % 4097);
+
+	// the envelope sub-counter wraps at the divider count
+	if (RegisterType::EG_CLOCK_DIVIDER == 1)
+		m_env_counter += 4 * clocks;
+	else
+	{
+		uint64_t subcount = bitfield(m_env_counter, 0, 2) + uint64_t(clocks);
+		m_env_counter = (m_env_counter & ~3) + uint32_t(subcount / RegisterType::EG_CLOCK_DIVIDER) * 4 + uint32_t(subcount % RegisterType::EG_CLOCK_DIVIDER);
+	}
+
+	m_regs.skip_noise_and_lfo(clocks);
+
+	for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
+		if (bitfield(chanmask, chnum))
+			m_channel[chnum].skip();
+
+	// step the feedback and the phases as the backend would; the feedback
+	// input does not change while no channel is active
+	uint32_t lanemask = chanmask & ALL_CHANNELS;
+	for (uint32_t lane = 0; lane < fm_operator_block::LANES; lane++)
+		if (bitfield(lanemask, lane))
+		{
+			m_block.feedback[0][lane] = (clocks == 1) ? m_block.feedback[1][lane] : m_block.feedback_in[lane];
+			m_block.feedback[1][lane] = m_block.feedback_in[lane];
+
+			for (uint32_t slot = 0; slot < fm_operator_block::SLOTS; slot++)
+				m_block.phase[slot][lane] += m_block.phase_step[slot][lane] * clocks;
+		}
+}
+
+
 //-------------------------------------------------
 //  output - compute a sum over the relevant
 //  channels
@@ -1344,8 +1617,8 @@ void fm_engine_base<RegisterType>::output(output_data &output, uint32_t rshift,
 		assert(m_regs.noise_enable() == 0);
 
 		// precompute the operator 13+17 phase selection value
-		uint32_t op13phase = m_operator[13]->phase();
-		uint32_t op17phase = m_operator[17]->phase();
+		uint32_t op13phase = m_operator[13].phase();
+		uint32_t op17phase = m_operator[17].phase();
 		uint32_t phase_select = (bitfield(op13phase, 2) ^ bitfield(op13phase, 7)) | bitfield(op13phase, 3) | (bitfield(op17phase, 5) ^ bitfield(op17phase, 3));
 
 		// sum over all the desired channels
@@ -1356,20 +1629,23 @@ void fm_engine_base<RegisterType>::output(output_data &output, uint32_t rshift,
 				auto reference = output;
 #endif
 				if (chnum == 6)
-					m_channel[chnum]->output_rhythm_ch6(output, rshift, clipmax);
+					m_channel[chnum].output_rhythm_ch6(output, rshift, clipmax);
 				else if (chnum == 7)
-					m_channel[chnum]->output_rhythm_ch7(phase_select, output, rshift, clipmax);
+					m_channel[chnum].output_rhythm_ch7(phase_select, output, rshift, clipmax);
 				else if (chnum == 8)
-					m_channel[chnum]->output_rhythm_ch8(phase_select, output, rshift, clipmax);
-				else if (m_channel[chnum]->is4op())
-					m_channel[chnum]->output_4op(output, rshift, clipmax);
+					m_channel[chnum].output_rhythm_ch8(phase_select, output, rshift, clipmax);
 				else
-					m_channel[chnum]->output_2op(output, rshift, clipmax);
+					m_channel[chnum].output(output, rshift, clipmax);
 #if (YMFM_DEBUG_LOG_WAVFILES)
 				m_wavfile[chnum].add(output, reference);
 #endif
 			}
 	}
+	else if (m_backend->output != nullptr && !YMFM_DEBUG_LOG_WAVFILES)
+	{
+		// combine the operators of all channels at once
+		m_backend->output(m_block, chanmask, rshift, clipmax, output.data, OUTPUTS);
+	}
 	else
 	{
 		// sum over all the desired channels
@@ -1379,10 +1655,7 @@ void fm_engine_base<RegisterType>::output(output_data &output, uint32_t rshift,
 #if (YMFM_DEBUG_LOG_WAVFILES)
 				auto reference = output;
 #endif
-				if (m_channel[chnum]->is4op())
-					m_channel[chnum]->output_4op(output, rshift, clipmax);
-				else
-					m_channel[chnum]->output_2op(output, rshift, clipmax);
+				m_channel[chnum].output(output, rshift, clipmax);
 #if (YMFM_DEBUG_LOG_WAVFILES)
 				m_wavfile[chnum].add(output, reference);
 #endif
@@ -1391,6 +1664,34 @@ void fm_engine_base<RegisterType>::output(output_data &output, uint32_t rshift,
 }
 
 
+//-------------------------------------------------
+//  output_channels - compute the output of each
+//  channel separately
+//-------------------------------------------------
+
+template<class RegisterType>
+void fm_engine_base<RegisterType>::output_channels(output_data *outputs, uint32_t rshift, int32_t clipmax, uint32_t chanmask) const
+{
+	// the backends keep the result of each channel, so all of them are
+	// computed at once and routed to their own outputs
+	if (m_backend->output != nullptr && !YMFM_DEBUG_LOG_WAVFILES && !m_regs.rhythm_enable())
+	{
+		output_data sum;
+		output(sum.clear(), rshift, clipmax, chanmask);
+
+		for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
+			for (uint32_t index = 0; index < OUTPUTS; index++)
+				outputs[chnum].data[index] = m_block.result[chnum] & m_block.output_enable[index][chnum];
+		return;
+	}
+
+	// channels only clip their own result, so without intermediate clipping
+	// the outputs add up to what output() computes
+	for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
+		output(outputs[chnum].clear(), rshift, clipmax, chanmask & (1 << chnum));
+}
+
+
 //-------------------------------------------------
 //  write - handle writes to the OPN registers
 //-------------------------------------------------
@@ -1420,14 +1721,14 @@ void fm_engine_base<RegisterType>::write(uint16_t regnum, uint8_t data)
 		if (keyon_channel < CHANNELS)
 		{
 			// normal channel on/off
-			m_channel[keyon_channel]->keyonoff(keyon_opmask, KEYON_NORMAL, keyon_channel);
+			m_channel[keyon_channel].keyonoff(keyon_opmask, KEYON_NORMAL, keyon_channel);
 		}
 		else if (CHANNELS >= 9 && keyon_channel == RegisterType::RHYTHM_CHANNEL)
 		{
 			// special case for the OPL rhythm channels
-			m_channel[6]->keyonoff(bitfield(keyon_opmask, 4) ? 3 : 0, KEYON_RHYTHM, 6);
-			m_channel[7]->keyonoff(bitfield(keyon_opmask, 0) | (bitfield(keyon_opmask, 3) << 1), KEYON_RHYTHM, 7);
-			m_channel[8]->keyonoff(bitfield(keyon_opmask, 2) | (bitfield(keyon_opmask, 1) << 1), KEYON_RHYTHM, 8);
+			m_channel[6].keyonoff(bitfield(keyon_opmask, 4) ? 3 : 0, KEYON_RHYTHM, 6);
+			m_channel[7].keyonoff(bitfield(keyon_opmask, 0) | (bitfield(keyon_opmask, 3) << 1), KEYON_RHYTHM, 7);
+			m_channel[8].keyonoff(bitfield(keyon_opmask, 2) | (bitfield(keyon_opmask, 1) << 1), KEYON_RHYTHM, 8);
 		}
 	}
 }
@@ -1460,7 +1761,7 @@ void fm_engine_base<RegisterType>::assign_operators()
 		for (uint32_t index = 0; index < 4; index++)
 		{
 			uint32_t opnum = bitfield(map.chan[chnum], 8 * index, 8);
-			m_channel[chnum]->assign(index, (opnum == 0xff) ? nullptr : m_operator[opnum].get());
+			m_channel[chnum].assign(index, (opnum == 0xff) ? nullptr : &m_operator[opnum]);
 		}
 }
 
@@ -1517,7 +1818,7 @@ void fm_engine_base<RegisterType>::engine_timer_expired(uint32_t tnum)
 		for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
 			if (bitfield(RegisterType::CSM_TRIGGER_MASK, chnum))
 			{
-				m_channel[chnum]->keyonoff(0xf, KEYON_CSM, chnum);
+				m_channel[chnum].keyonoff(0xf, KEYON_CSM, chnum);
 				m_modified_channels |= 1 << chnum;
 			}
 
@@ -0,0 +1,626 @@
+
+/** $VER: ymfm_fm_soa.cpp (2026.10.19) P. Stuer - Structure-of-arrays state and vector backends of the 4-operator FM engine **/
+
+#include "ymfm_fm_soa.h"
+#include "ymfm_fm.h"
+#include "ymfm_fm.ipp"
+
+#include <atomic>
+#include <mutex>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define YMFM_FM_SOA_X86 (1)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define YMFM_FM_SOA_X86 (0)
+#endif
+
+// MSVC compiles any intrinsic in any function; GCC and Clang need to be told
+// which functions may use instructions beyond the baseline
+#if defined(__GNUC__) || defined(__clang__)
+#define YMFM_TARGET(x) __attribute__((target(x)))
+#else
+#define YMFM_TARGET(x)
+#endif
+
+namespace ymfm
+{
+
+namespace
+{
+
+constexpr uint32_t LANES = fm_operator_block::LANES;
+constexpr uint32_t EG_QUIET = fm_operator_block::EG_QUIET;
+
+//-------------------------------------------------
+//  soa_tables - the OPN sine and power tables,
+//  widened to 32 bits so they can be gathered;
+//  filled on first use instead of by a constructor
+//  so that engines created during static
+//  initialization do not see empty tables; several
+//  engines may be created at the same time on
+//  different threads, so the tables are filled
+//  exactly once under a std::once_flag
+//-------------------------------------------------
+
+struct soa_tables
+{
+	void init()
+	{
+		std::call_once(once, [this]
+		{
+			// the same values opn_registers_base puts in its single waveform
+			for (uint32_t index = 0; index < 0x400; index++)
+				sin[index] = abs_sin_attenuation(index) | (bitfield(index, 9) << 15);
+
+			// attenuation_to_volume() of an input below 0x100 is the table entry itself
+			for (uint32_t index = 0; index < 0x100; index++)
+				power[index] = attenuation_to_volume(index);
+		});
+	}
+
+	alignas(32) uint32_t sin[0x400];
+	alignas(32) uint32_t power[0x100];
+	std::once_flag once;
+};
+
+soa_tables s_tables;
+
+
+//*********************************************************
+//  SCALAR BACKEND
+//*********************************************************
+
+//-------------------------------------------------
+//  clock_scalar - advance the feedback memory and
+//  the phases of the channels in lanemask
+//-------------------------------------------------
+
+void clock_scalar(fm_operator_block &block, uint32_t lanemask)
+{
+	for (uint32_t lane = 0; lane < LANES; lane++)
+		if (bitfield(lanemask, lane))
+		{
+			block.feedback[0][lane] = block.feedback[1][lane];
+			block.feedback[1][lane] = block.feedback_in[lane];
+
+			for (uint32_t slot = 0; slot < fm_operator_block::SLOTS; slot++)
+				block.phase[slot][lane] += block.phase_step[slot][lane];
+		}
+}
+
+
+//-------------------------------------------------
+//  volume_scalar - fm_operator::compute_volume()
+//  of one operator of the block
+//-------------------------------------------------
+
+inline int32_t volume_scalar(fm_operator_block const &block, uint32_t slot, uint32_t lane, int32_t opmod)
+{
+	// early out if the envelope is effectively off
+	uint32_t env_attenuation = block.env_attenuation[slot][lane];
+	if (env_attenuation > EG_QUIET)
+		return 0;
+
+	uint32_t sin_attenuation = s_tables.sin[((block.phase[slot][lane] >> 10) + opmod) & 0x3ff];
+
+	// fm_operator::envelope_attenuation(); the OPN registers never set an envelope shift
+	if (block.ssg_inverted[slot][lane])
+		env_attenuation = (0x200 - env_attenuation) & 0x3ff;
+	env_attenuation += block.am_offset[lane] & block.am_enable[slot][lane];
+	env_attenuation += block.total_level[slot][lane];
+	env_attenuation = std::min<uint32_t>(env_attenuation, 0x3ff);
+
+	uint32_t attenuation = (sin_attenuation & 0x7fff) + (env_attenuation << 2);
+	int32_t result = s_tables.power[attenuation & 0xff] >> (attenuation >> 8);
+
+	return bitfield(sin_attenuation, 15) ? -result : result;
+}
+
+
+//-------------------------------------------------
+//  output_scalar - combine the operators of the
+//  channels in lanemask
+//-------------------------------------------------
+
+void output_scalar(fm_operator_block const &block, uint32_t lanemask, uint32_t rshift, int32_t clipmax, int32_t *outputs, uint32_t count)
+{
+	int32_t clipmin = -clipmax - 1;
+
+	for (uint32_t lane = 0; lane < LANES; lane++)
+	{
+		block.result[lane] = 0;
+
+		if (!bitfield(lanemask, lane))
+			continue;
+
+		// operator 1 has optional self-feedback
+		int32_t opmod = ((block.feedback[0][lane] + block.feedback[1][lane]) * block.feedback_scale[lane]) >> 10;
+
+		// opout[1] to opout[3] hold O1 to O3 and opout[0] holds O4
+		int32_t opout[4] = { 0, 0, 0, 0 };
+		opout[1] = volume_scalar(block, 0, lane, opmod);
+		block.feedback_in[lane] = int16_t(opout[1]);
+
+		// operators 2 to 4 are modulated by the sum of the selected outputs
+		for (uint32_t slot = 1; slot < fm_operator_block::SLOTS; slot++)
+		{
+			int32_t input = (opout[1] & block.modulation[slot - 1][0][lane]) + (opout[2] & block.modulation[slot - 1][1][lane]) + (opout[3] & block.modulation[slot - 1][2][lane]);
+			opout[(slot + 1) & 3] = volume_scalar(block, slot, lane, input >> 1);
+		}
+
+		// O4 is always part of the output; adding nothing to a value within
+		// the clip range leaves it unchanged, so the sum is clamped after
+		// every term, like fm_channel::output_4op() does
+		int32_t result = opout[0] >> rshift;
+		for (uint32_t op = 0; op < 3; op++)
+			result = clamp(result + ((opout[op + 1] >> rshift) & block.sum[op][lane]), clipmin, clipmax);
+
+		block.result[lane] = result;
+
+		for (uint32_t index = 0; index < count; index++)
+			outputs[index] += result & block.output_enable[index][lane];
+	}
+}
+
+#if (YMFM_FM_SOA_X86)
+
+//*********************************************************
+//  SSE4.1 BACKEND
+//*********************************************************
+
+//-------------------------------------------------
+//  lanes_sse41 - expand 4 bits of a lane mask into
+//  32-bit lane masks
+//-------------------------------------------------
+
+YMFM_TARGET("sse4.1")
+inline __m128i lanes_sse41(uint32_t lanemask)
+{
+	__m128i const bits = _mm_setr_epi32(1, 2, 4, 8);
+	return _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(int(lanemask)), bits), bits);
+}
+
+
+//-------------------------------------------------
+//  clock_sse41 - advance the feedback memory and
+//  the phases of the channels in lanemask
+//-------------------------------------------------
+
+YMFM_TARGET("sse4.1")
+void clock_sse41(fm_operator_block &block, uint32_t lanemask)
+{
+	__m128i const lanes_lo = lanes_sse41(lanemask);
+	__m128i const lanes_hi = lanes_sse41(lanemask >> 4);
+
+	for (uint32_t slot = 0; slot < fm_operator_block::SLOTS; slot++)
+	{
+		__m128i *phase = reinterpret_cast<__m128i *>(block.phase[slot]);
+		__m128i const *step = reinterpret_cast<__m128i const *>(block.phase_step[slot]);
+
+		_mm_storeu_si128(phase + 0, _mm_add_epi32(_mm_loadu_si128(phase + 0), _mm_and_si128(_mm_loadu_si128(step + 0), lanes_lo)));
+		_mm_storeu_si128(phase + 1, _mm_add_epi32(_mm_loadu_si128(phase + 1), _mm_and_si128(_mm_loadu_si128(step + 1), lanes_hi)));
+	}
+
+	__m128i const lanes = _mm_packs_epi32(lanes_lo, lanes_hi);
+	__m128i const feedback0 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(block.feedback[0]));
+	__m128i const feedback1 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(block.feedback[1]));
+	__m128i const feedback_in = _mm_loadu_si128(reinterpret_cast<__m128i const *>(block.feedback_in));
+
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(block.feedback[0]), _mm_blendv_epi8(feedback0, feedback1, lanes));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(block.feedback[1]), _mm_blendv_epi8(feedback1, feedback_in, lanes));
+}
+
+
+//-------------------------------------------------
+//  volume_sse41 - compute the volume of one slot
+//  of 4 lanes starting at base; SSE4.1 has no
+//  gathers or per-lane shifts, so the two table
+//  lookups are done one lane at a time
+//-------------------------------------------------
+
+YMFM_TARGET("sse4.1")
+inline __m128i volume_sse41(fm_operator_block const &block, uint32_t slot, uint32_t base, __m128i opmod)
+{
+	__m128i env_attenuation = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(&block.env_attenuation[slot][base])));
+	__m128i const quiet = _mm_cmpgt_epi32(env_attenuation, _mm_set1_epi32(EG_QUIET));
+
+	alignas(16) uint32_t index[4];
+	__m128i const phase = _mm_loadu_si128(reinterpret_cast<__m128i const *>(&block.phase[slot][base]));
+	_mm_store_si128(reinterpret_cast<__m128i *>(index), _mm_and_si128(_mm_add_epi32(_mm_srli_epi32(phase, 10), opmod), _mm_set1_epi32(0x3ff)));
+	__m128i const sin_attenuation = _mm_setr_epi32(int(s_tables.sin[index[0]]), int(s_tables.sin[index[1]]), int(s_tables.sin[index[2]]), int(s_tables.sin[index[3]]));
+
+	// fm_operator::envelope_attenuation()
+	int inverted_bytes;
+	memcpy(&inverted_bytes, &block.ssg_inverted[slot][base], sizeof(inverted_bytes));
+	__m128i const inverted = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(inverted_bytes));
+	__m128i const not_inverted = _mm_cmpeq_epi32(inverted, _mm_setzero_si128());
+	env_attenuation = _mm_blendv_epi8(_mm_and_si128(_mm_sub_epi32(_mm_set1_epi32(0x200), env_attenuation), _mm_set1_epi32(0x3ff)), env_attenuation, not_inverted);
+	env_attenuation = _mm_add_epi32(env_attenuation, _mm_and_si128(_mm_loadu_si128(reinterpret_cast<__m128i const *>(&block.am_offset[base])), _mm_loadu_si128(reinterpret_cast<__m128i const *>(&block.am_enable[slot][base]))));
+	env_attenuation = _mm_add_epi32(env_attenuation, _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(&block.total_level[slot][base]))));
+	env_attenuation = _mm_min_epu32(env_attenuation, _mm_set1_epi32(0x3ff));
+
+	alignas(16) uint32_t attenuation[4];
+	_mm_store_si128(reinterpret_cast<__m128i *>(attenuation), _mm_add_epi32(_mm_and_si128(sin_attenuation, _mm_set1_epi32(0x7fff)), _mm_slli_epi32(env_attenuation, 2)));
+	__m128i result = _mm_setr_epi32(
+		int(s_tables.power[attenuation[0] & 0xff] >> (attenuation[0] >> 8)),
+		int(s_tables.power[attenuation[1] & 0xff] >> (attenuation[1] >> 8)),
+		int(s_tables.power[attenuation[2] & 0xff] >> (attenuation[2] >> 8)),
+		int(s_tables.power[attenuation[3] & 0xff] >> (attenuation[3] >> 8)));
+
+	// negate if in the negative part of the sin wave
+	__m128i const sign = _mm_srai_epi32(_mm_slli_epi32(sin_attenuation, 16), 31);
+	result = _mm_sub_epi32(_mm_xor_si128(result, sign), sign);
+
+	return _mm_andnot_si128(quiet, result);
+}
+
+
+//-------------------------------------------------
+//  combine_sse41 - combine the operators of 4
+//  lanes starting at base and return the channel
+//  results
+//-------------------------------------------------
+
+YMFM_TARGET("sse4.1")
+inline __m128i combine_sse41(fm_operator_block const &block, uint32_t base, __m128i lanes, __m128i rshift, __m128i clipmin, __m128i clipmax)
+{
+	// operator 1 has optional self-feedback
+	__m128i const feedback0 = _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(&block.feedback[0][base])));
+	__m128i const feedback1 = _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(&block.feedback[1][base])));
+	__m128i const scale = _mm_loadu_si128(reinterpret_cast<__m128i const *>(&block.feedback_scale[base]));
+	__m128i opout[4];
+	opout[1] = volume_sse41(block, 0, base, _mm_srai_epi32(_mm_mullo_epi32(_mm_add_epi32(feedback0, feedback1), scale), 10));
+
+	// store the feedback input of the computed lanes
+	__m128i const feedback_in = _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(&block.feedback_in[base])));
+	_mm_storel_epi64(reinterpret_cast<__m128i *>(&block.feedback_in[base]), _mm_packs_epi32(_mm_blendv_epi8(feedback_in, opout[1], lanes), _mm_setzero_si128()));
+
+	// operators 2 to 4 are modulated by the sum of the selected outputs
+	for (uint32_t slot = 1; slot < fm_operator_block::SLOTS; slot++)
+	{
+		__m128i input = _mm_and_si128(opout[1], _mm_loadu_si128(reinterpret_cast<__m128i const *>(&block.modulation[slot - 1][0][base])));
+		if (slot > 1)
+			input = _mm_add_epi32(input, _mm_and_si128(opout[2], _mm_loadu_si128(reinterpret_cast<__m128i const *>(&block.modulation[slot - 1][1][base]))));
+		if (slot > 2)
+			input = _mm_add_epi32(input, _mm_and_si128(opout[3], _mm_loadu_si128(reinterpret_cast<__m128i const *>(&block.modulation[slot - 1][2][base]))));
+
+		opout[(slot + 1) & 3] = volume_sse41(block, slot, base, _mm_srai_epi32(input, 1));
+	}
+
+	// add the selected operators to O4, clamping after every term
+	__m128i result = _mm_sra_epi32(opout[0], rshift);
+	for (uint32_t op = 0; op < 3; op++)
+	{
+		__m128i const term = _mm_and_si128(_mm_sra_epi32(opout[op + 1], rshift), _mm_loadu_si128(reinterpret_cast<__m128i const *>(&block.sum[op][base])));
+		result = _mm_min_epi32(_mm_max_epi32(_mm_add_epi32(result, term), clipmin), clipmax);
+	}
+
+	return _mm_and_si128(result, lanes);
+}
+
+
+//-------------------------------------------------
+//  hsum_sse41 - return the sum of 4 lanes
+//-------------------------------------------------
+
+YMFM_TARGET("sse4.1")
+inline int32_t hsum_sse41(__m128i value)
+{
+	value = _mm_add_epi32(value, _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2)));
+	value = _mm_add_epi32(value, _mm_shuffle_epi32(value, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(value);
+}
+
+
+//-------------------------------------------------
+//  output_sse41 - combine the operators of the
+//  channels in lanemask
+//-------------------------------------------------
+
+YMFM_TARGET("sse4.1")
+void output_sse41(fm_operator_block const &block, uint32_t lanemask, uint32_t rshift, int32_t clipmax, int32_t *outputs, uint32_t count)
+{
+	__m128i const shift = _mm_cvtsi32_si128(int(rshift));
+	__m128i const clipmin_v = _mm_set1_epi32(-clipmax - 1);
+	__m128i const clipmax_v = _mm_set1_epi32(clipmax);
+
+	__m128i const result_lo = combine_sse41(block, 0, lanes_sse41(lanemask), shift, clipmin_v, clipmax_v);
+	__m128i const result_hi = combine_sse41(block, 4, lanes_sse41(lanemask >> 4), shift, clipmin_v, clipmax_v);
+
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(&block.result[0]), result_lo);
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(&block.result[4]), result_hi);
+
+	for (uint32_t index = 0; index < count; index++)
+	{
+		__m128i const enable_lo = _mm_loadu_si128(reinterpret_cast<__m128i const *>(&block.output_enable[index][0]));
+		__m128i const enable_hi = _mm_loadu_si128(reinterpret_cast<__m128i const *>(&block.output_enable[index][4]));
+		outputs[index] += hsum_sse41(_mm_add_epi32(_mm_and_si128(result_lo, enable_lo), _mm_and_si128(result_hi, enable_hi)));
+	}
+}
+
+
+//*********************************************************
+//  AVX2 BACKEND
+//*********************************************************
+
+//-------------------------------------------------
+//  lanes_avx2 - expand a lane mask into 32-bit
+//  lane masks
+//-------------------------------------------------
+
+YMFM_TARGET("avx2")
+inline __m256i lanes_avx2(uint32_t lanemask)
+{
+	__m256i const bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(int(lanemask)), bits), bits);
+}
+
+
+//-------------------------------------------------
+//  clock_avx2 - advance the feedback memory and
+//  the phases of the channels in lanemask
+//-------------------------------------------------
+
+YMFM_TARGET("avx2")
+void clock_avx2(fm_operator_block &block, uint32_t lanemask)
+{
+	__m256i const lanes = lanes_avx2(lanemask);
+
+	for (uint32_t slot = 0; slot < fm_operator_block::SLOTS; slot++)
+	{
+		__m256i *phase = reinterpret_cast<__m256i *>(block.phase[slot]);
+		__m256i const step = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(block.phase_step[slot]));
+
+		_mm256_storeu_si256(phase, _mm256_add_epi32(_mm256_loadu_si256(phase), _mm256_and_si256(step, lanes)));
+	}
+
+	__m128i const lanes16 = _mm_packs_epi32(_mm256_castsi256_si128(lanes), _mm256_extracti128_si256(lanes, 1));
+	__m128i const feedback0 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(block.feedback[0]));
+	__m128i const feedback1 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(block.feedback[1]));
+	__m128i const feedback_in = _mm_loadu_si128(reinterpret_cast<__m128i const *>(block.feedback_in));
+
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(block.feedback[0]), _mm_blendv_epi8(feedback0, feedback1, lanes16));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(block.feedback[1]), _mm_blendv_epi8(feedback1, feedback_in, lanes16));
+}
+
+
+//-------------------------------------------------
+//  volume_avx2 - compute the volume of one slot
+//  of all lanes
+//-------------------------------------------------
+
+YMFM_TARGET("avx2")
+inline __m256i volume_avx2(fm_operator_block const &block, uint32_t slot, __m256i opmod, __m256i am_offset)
+{
+	__m256i env_attenuation = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(block.env_attenuation[slot])));
+	__m256i const quiet = _mm256_cmpgt_epi32(env_attenuation, _mm256_set1_epi32(EG_QUIET));
+
+	__m256i const phase = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(block.phase[slot]));
+	__m256i const index = _mm256_and_si256(_mm256_add_epi32(_mm256_srli_epi32(phase, 10), opmod), _mm256_set1_epi32(0x3ff));
+	__m256i const sin_attenuation = _mm256_i32gather_epi32(reinterpret_cast<int const *>(s_tables.sin), index, 4);
+
+	// fm_operator::envelope_attenuation()
+	__m256i const inverted = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(block.ssg_inverted[slot])));
+	__m256i const not_inverted = _mm256_cmpeq_epi32(inverted, _mm256_setzero_si256());
+	env_attenuation = _mm256_blendv_epi8(_mm256_and_si256(_mm256_sub_epi32(_mm256_set1_epi32(0x200), env_attenuation), _mm256_set1_epi32(0x3ff)), env_attenuation, not_inverted);
+	env_attenuation = _mm256_add_epi32(env_attenuation, _mm256_and_si256(am_offset, _mm256_loadu_si256(reinterpret_cast<__m256i const *>(block.am_enable[slot]))));
+	env_attenuation = _mm256_add_epi32(env_attenuation, _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(block.total_level[slot]))));
+	env_attenuation = _mm256_min_epu32(env_attenuation, _mm256_set1_epi32(0x3ff));
+
+	__m256i const attenuation = _mm256_add_epi32(_mm256_and_si256(sin_attenuation, _mm256_set1_epi32(0x7fff)), _mm256_slli_epi32(env_attenuation, 2));
+	__m256i const power = _mm256_i32gather_epi32(reinterpret_cast<int const *>(s_tables.power), _mm256_and_si256(attenuation, _mm256_set1_epi32(0xff)), 4);
+	__m256i result = _mm256_srlv_epi32(power, _mm256_srli_epi32(attenuation, 8));
+
+	// negate if in the negative part of the sin wave
+	__m256i const sign = _mm256_srai_epi32(_mm256_slli_epi32(sin_attenuation, 16), 31);
+	result = _mm256_sub_epi32(_mm256_xor_si256(result, sign), sign);
+
+	return _mm256_andnot_si256(quiet, result);
+}
+
+
+//-------------------------------------------------
+//  output_avx2 - combine the operators of the
+//  channels in lanemask
+//-------------------------------------------------
+
+YMFM_TARGET("avx2")
+void output_avx2(fm_operator_block const &block, uint32_t lanemask, uint32_t rshift, int32_t clipmax, int32_t *outputs, uint32_t count)
+{
+	__m256i const lanes = lanes_avx2(lanemask);
+	__m256i const am_offset = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(block.am_offset));
+
+	// operator 1 has optional self-feedback
+	__m256i const feedback0 = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(block.feedback[0])));
+	__m256i const feedback1 = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(block.feedback[1])));
+	__m256i const scale = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(block.feedback_scale));
+	__m256i opout[4];
+	opout[1] = volume_avx2(block, 0, _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_add_epi32(feedback0, feedback1), scale), 10), am_offset);
+
+	// store the feedback input of the computed lanes
+	__m256i const feedback_in = _mm256_blendv_epi8(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const *>(block.feedback_in))), opout[1], lanes);
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(block.feedback_in), _mm_packs_epi32(_mm256_castsi256_si128(feedback_in), _mm256_extracti128_si256(feedback_in, 1)));
+
+	// operators 2 to 4 are modulated by the sum of the selected outputs
+	for (uint32_t slot = 1; slot < fm_operator_block::SLOTS; slot++)
+	{
+		__m256i input = _mm256_and_si256(opout[1], _mm256_loadu_si256(reinterpret_cast<__m256i const *>(block.modulation[slot - 1][0])));
+		if (slot > 1)
+			input = _mm256_add_epi32(input, _mm256_and_si256(opout[2], _mm256_loadu_si256(reinterpret_cast<__m256i const *>(block.modulation[slot - 1][1]))));
+		if (slot > 2)
+			input = _mm256_add_epi32(input, _mm256_and_si256(opout[3], _mm256_loadu_si256(reinterpret_cast<__m256i const *>(block.modulation[slot - 1][2]))));
+
+		opout[(slot + 1) & 3] = volume_avx2(block, slot, _mm256_srai_epi32(input, 1), am_offset);
+	}
+
+	// add the selected operators to O4, clamping after every term
+	__m128i const shift = _mm_cvtsi32_si128(int(rshift));
+	__m256i const clipmin_v = _mm256_set1_epi32(-clipmax - 1);
+	__m256i const clipmax_v = _mm256_set1_epi32(clipmax);
+
+	__m256i result = _mm256_sra_epi32(opout[0], shift);
+	for (uint32_t op = 0; op < 3; op++)
+	{
+		__m256i const term = _mm256_and_si256(_mm256_sra_epi32(opout[op + 1], shift), _mm256_loadu_si256(reinterpret_cast<__m256i const *>(block.sum[op])));
+		result = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(result, term), clipmin_v), clipmax_v);
+	}
+	result = _mm256_and_si256(result, lanes);
+
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(block.result), result);
+
+	for (uint32_t index = 0; index < count; index++)
+	{
+		__m256i const routed = _mm256_and_si256(result, _mm256_loadu_si256(reinterpret_cast<__m256i const *>(block.output_enable[index])));
+		__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(routed), _mm256_extracti128_si256(routed, 1));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+		outputs[index] += _mm_cvtsi128_si32(sum);
+	}
+}
+
+
+//-------------------------------------------------
+//  cpu_supports - return true if the CPU supports
+//  the instruction set of a backend
+//-------------------------------------------------
+
+bool cpu_supports_sse41()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 19)) != 0;
+#else
+	return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+bool cpu_supports_avx2()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	// the OS has to save the YMM registers on a context switch
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+bool cpu_supports_always() { return true; }
+
+
+//-------------------------------------------------
+//  backends, from slowest to fastest
+//-------------------------------------------------
+
+struct backend_entry
+{
+	fm_operator_backend backend;
+	bool (*supported)();
+};
+
+backend_entry const s_backends[] =
+{
+	{ { "ymfm", clock_scalar, nullptr }, cpu_supports_always },
+	{ { "scalar", clock_scalar, output_scalar }, cpu_supports_always },
+#if (YMFM_FM_SOA_X86)
+	{ { "sse41", clock_sse41, output_sse41 }, cpu_supports_sse41 },
+	{ { "avx2", clock_avx2, output_avx2 }, cpu_supports_avx2 },
+#endif
+};
+
+//-------------------------------------------------
+//  fastest_backend - return the last (fastest)
+//  backend the CPU supports; the CPU is queried
+//  only once, by the first caller
+//-------------------------------------------------
+
+fm_operator_backend const &fastest_backend()
+{
+	static fm_operator_backend const *const s_fastest = []
+	{
+		fm_operator_backend const *result = nullptr;
+		for (auto const &entry : s_backends)
+			if (entry.supported())
+				result = &entry.backend;
+		return result;
+	}();
+
+	return *s_fastest;
+}
+
+// the backend new engines use, nullptr until it is resolved or overridden;
+// engines may be created on several threads at once, hence the atomic
+std::atomic<fm_operator_backend const *> s_default_backend(nullptr);
+
+}
+
+
+//-------------------------------------------------
+//  fm_find_backend - return the backend with the
+//  given name if the CPU supports it
+//-------------------------------------------------
+
+fm_operator_backend const *fm_find_backend(char const *name)
+{
+	s_tables.init();
+
+	for (auto const &entry : s_backends)
+		if (strcmp(entry.backend.name, name) == 0)
+			return entry.supported() ? &entry.backend : nullptr;
+
+	return nullptr;
+}
+
+
+//-------------------------------------------------
+//  fm_default_backend - return the backend new
+//  engines use
+//-------------------------------------------------
+
+fm_operator_backend const &fm_default_backend()
+{
+	s_tables.init();
+
+	fm_operator_backend const *backend = s_default_backend.load(std::memory_order_acquire);
+	if (backend == nullptr)
+	{
+		// the first caller installs the fastest backend unless another thread
+		// has set one in the meantime
+		fm_operator_backend const *fastest = &fastest_backend();
+		if (s_default_backend.compare_exchange_strong(backend, fastest, std::memory_order_acq_rel))
+			backend = fastest;
+	}
+
+	return *backend;
+}
+
+
+//-------------------------------------------------
+//  fm_set_default_backend - override the backend
+//  new engines use
+//-------------------------------------------------
+
+void fm_set_default_backend(fm_operator_backend const &backend)
+{
+	s_tables.init();
+
+	s_default_backend.store(&backend, std::memory_order_release);
+}
+
+}
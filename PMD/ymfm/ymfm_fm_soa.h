@@ -0,0 +1,89 @@
+
+/** $VER: ymfm_fm_soa.h (2026.10.19) P. Stuer - Structure-of-arrays state and vector backends of the 4-operator FM engine **/
+
+#ifndef YMFM_FM_SOA_H
+#define YMFM_FM_SOA_H
+
+#pragma once
+
+#include "ymfm.h"
+
+namespace ymfm
+{
+
+// ======================> fm_operator_block
+
+// fm_operator_block holds the per-sample state of the operators and channels
+// of a 4-operator FM engine with up to 8 channels as structure of arrays;
+// operator arrays are indexed by the operator's slot in its channel and by
+// the channel ("lane"), so one vector register covers the same slot of all
+// channels; fm_operator and fm_channel keep references to their phase and
+// feedback state in the block, the envelope state machine itself stays
+// scalar and copies its attenuation into the block after every change
+struct alignas(32) fm_operator_block
+{
+	static constexpr uint32_t SLOTS = 4;
+	static constexpr uint32_t LANES = 8;
+
+	// "quiet" value of the envelope attenuation, see fm_operator
+	static constexpr uint32_t EG_QUIET = 0x380;
+
+	// operator state
+	uint32_t phase[SLOTS][LANES];            // current phase value (10.10 format)
+	uint32_t phase_step[SLOTS][LANES];       // phase step applied by the next clock
+	uint16_t env_attenuation[SLOTS][LANES];  // computed envelope attenuation (4.6 format)
+	uint8_t ssg_inverted[SLOTS][LANES];      // non-zero if the output should be inverted
+
+	// operator parameters, captured by fm_operator::prepare()
+	uint16_t total_level[SLOTS][LANES];      // total level * 8
+	int32_t am_enable[SLOTS][LANES];         // all ones if LFO AM applies to the operator
+
+	// channel state
+	int16_t feedback[2][LANES];              // feedback memory for operator 1
+	mutable int16_t feedback_in[LANES];      // next input value for op 1 feedback (set in output)
+	uint32_t am_offset[LANES];               // LFO AM offset of the current clock
+
+	// channel parameters, captured by fm_channel::prepare()
+	int32_t feedback_scale[LANES];           // 1 << feedback, or 0 if there is no feedback
+	int32_t modulation[SLOTS - 1][3][LANES]; // all ones if O1/O2/O3 modulate operator 2/3/4
+	int32_t sum[3][LANES];                   // all ones if O1/O2/O3 are added to the O4 output
+	int32_t output_enable[2][LANES];         // all ones if the channel feeds output 0/1
+
+	// channel results of the last output, before they are routed to the outputs
+	mutable int32_t result[LANES];
+};
+
+
+// ======================> fm_operator_backend
+
+// fm_operator_backend is a set of functions that step and combine the
+// operators of an fm_operator_block; all backends produce the same output
+// bit for bit, they differ only in the instruction set they use
+struct fm_operator_backend
+{
+	// name of the backend: "ymfm", "scalar", "sse41" or "avx2"
+	char const *name;
+
+	// advance the feedback memory and the phases of the channels in lanemask
+	void (*clock)(fm_operator_block &block, uint32_t lanemask);
+
+	// combine the operators of the channels in lanemask, store their results
+	// and add them to the enabled outputs; the "ymfm" backend has no output
+	// function and leaves it to the original per-channel handlers
+	void (*output)(fm_operator_block const &block, uint32_t lanemask, uint32_t rshift, int32_t clipmax, int32_t *outputs, uint32_t count);
+};
+
+// return the backend with the given name, or nullptr if it is unknown or the
+// CPU does not support it
+fm_operator_backend const *fm_find_backend(char const *name);
+
+// return the backend that new FM engines use; this is the fastest one the CPU
+// supports unless it has been overridden
+fm_operator_backend const &fm_default_backend();
+
+// override the backend that new FM engines use
+void fm_set_default_backend(fm_operator_backend const &backend);
+
+}
+
+#endif // YMFM_FM_SOA_H
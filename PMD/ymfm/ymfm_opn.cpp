@@ -190,6 +190,11 @@ bool opn_registers_base<IsOpnA>::write(uint16_t index, uint8_t data, uint32_t &c
 }
 
 
+// this table is based on converting the frequencies in the applications
+// manual to clock dividers, based on the assumption of a 7-bit LFO value
+static uint8_t const s_lfo_max_count[8] = { 109, 78, 72, 68, 63, 45, 9, 6 };
+
+
 //-------------------------------------------------
 //  clock_noise_and_lfo - clock the noise and LFO,
 //  handling clock division, depth, and waveform
@@ -214,14 +219,11 @@ int32_t opn_registers_base<IsOpnA>::clock_noise_and_lfo()
 		return 0;
 	}
 
-	// this table is based on converting the frequencies in the applications
-	// manual to clock dividers, based on the assumption of a 7-bit LFO value
-	static uint8_t const lfo_max_count[8] = { 109, 78, 72, 68, 63, 45, 9, 6 };
 	uint32_t subcount = uint8_t(m_lfo_counter++);
 
 	// when we cross the divider count, add enough to zero it and cause an
 	// increment at bit 8; the 7-bit value lives from bits 8-14
-	if (subcount >= lfo_max_count[lfo_rate()])
+	if (subcount >= s_lfo_max_count[lfo_rate()])
 	{
 		// note: to match the published values this should be 0x100 - subcount;
 		// however, tests on the hardware and nuked bear out an off-by-one
@@ -248,6 +250,41 @@ int32_t opn_registers_base<IsOpnA>::clock_noise_and_lfo()
 }
 
 
+//-------------------------------------------------
+//  skip_noise_and_lfo - advance the LFO by a
+//  number of clocks at once; the PM value is
+//  recomputed by the next clock
+//-------------------------------------------------
+
+template<bool IsOpnA>
+void opn_registers_base<IsOpnA>::skip_noise_and_lfo(uint32_t clocks)
+{
+	if (!IsOpnA || !lfo_enable())
+	{
+		m_lfo_counter = 0;
+		m_lfo_am = IsOpnA ? 0x3f : 0x00;
+		return;
+	}
+
+	// the low byte counts up to the divider, then the next clock sets it to 2
+	// and increments the 7-bit value
+	uint32_t maxcount = s_lfo_max_count[lfo_rate()];
+	uint32_t subcount = uint8_t(m_lfo_counter);
+	uint32_t first = (subcount >= maxcount) ? 1 : maxcount - subcount + 1;
+	if (clocks < first)
+		m_lfo_counter += clocks;
+	else
+	{
+		uint32_t rest = clocks - first;
+		m_lfo_counter = (m_lfo_counter & ~0xff) + ((1 + rest / (maxcount - 1)) << 8) + 2 + rest % (maxcount - 1);
+	}
+
+	m_lfo_am = bitfield(m_lfo_counter, 8, 6);
+	if (bitfield(m_lfo_counter, 8+6) == 0)
+		m_lfo_am ^= 0x3f;
+}
+
+
 //-------------------------------------------------
 //  lfo_am_offset - return the AM offset from LFO
 //  for the given channel
@@ -503,6 +540,16 @@ void ssg_resampler<OutputType, FirstOutput, MixTo1>::write_to_output(OutputType
 		output->data[FirstOutput + 2] = sum2 / divisor;
 	}
 
+	// write the individual channels at the same scale if requested
+	if (m_channel_outputs != nullptr)
+	{
+		int32_t mul = MixTo1 ? 2 : 1;
+		int32_t div = MixTo1 ? 3 * divisor : divisor;
+		m_channel_outputs->data[0] = sum0 * mul / div;
+		m_channel_outputs->data[1] = sum1 * mul / div;
+		m_channel_outputs->data[2] = sum2 * mul / div;
+	}
+
 	// track the sample index here
 	m_sampindex++;
 }
@@ -516,9 +563,11 @@ template<typename OutputType, int FirstOutput, bool MixTo1>
 ssg_resampler<OutputType, FirstOutput, MixTo1>::ssg_resampler(ssg_engine &ssg) :
 	m_ssg(ssg),
 	m_sampindex(0),
-	m_resampler(&ssg_resampler::resample_nop)
+	m_resampler(&ssg_resampler::resample_nop),
+	m_channel_outputs(nullptr)
 {
 	m_last.clear();
+	set_clock_pattern(1, 0);
 }
 
 
@@ -543,20 +592,59 @@ void ssg_resampler<OutputType, FirstOutput, MixTo1>::configure(uint8_t outsample
 {
 	switch (outsamples * 10 + srcsamples)
 	{
-		case 4*10 + 1:	/* 4:1 */	m_resampler = &ssg_resampler::resample_n_1<4>;	break;
-		case 2*10 + 1:	/* 2:1 */	m_resampler = &ssg_resampler::resample_n_1<2>;	break;
-		case 4*10 + 3:	/* 4:3 */	m_resampler = &ssg_resampler::resample_4_3;		break;
-		case 1*10 + 1:	/* 1:1 */	m_resampler = &ssg_resampler::resample_n_1<1>;	break;
-		case 2*10 + 3:	/* 2:3 */	m_resampler = &ssg_resampler::resample_2_3;		break;
-		case 1*10 + 3:	/* 1:3 */	m_resampler = &ssg_resampler::resample_1_n<3>;	break;
-		case 2*10 + 9:	/* 2:9 */	m_resampler = &ssg_resampler::resample_2_9;		break;
-		case 1*10 + 6:	/* 1:6 */	m_resampler = &ssg_resampler::resample_1_n<6>;	break;
-		case 0*10 + 0:	/* 0:0 */	m_resampler = &ssg_resampler::resample_nop;		break;
+		case 4*10 + 1:	/* 4:1 */	m_resampler = &ssg_resampler::resample_n_1<4>;	set_clock_pattern(4, 1, 0, 0, 0);	break;
+		case 2*10 + 1:	/* 2:1 */	m_resampler = &ssg_resampler::resample_n_1<2>;	set_clock_pattern(2, 1, 0);			break;
+		case 4*10 + 3:	/* 4:3 */	m_resampler = &ssg_resampler::resample_4_3;		set_clock_pattern(4, 1, 1, 1, 0);	break;
+		case 1*10 + 1:	/* 1:1 */	m_resampler = &ssg_resampler::resample_n_1<1>;	set_clock_pattern(1, 1);			break;
+		case 2*10 + 3:	/* 2:3 */	m_resampler = &ssg_resampler::resample_2_3;		set_clock_pattern(2, 2, 1);			break;
+		case 1*10 + 3:	/* 1:3 */	m_resampler = &ssg_resampler::resample_1_n<3>;	set_clock_pattern(1, 3);			break;
+		case 2*10 + 9:	/* 2:9 */	m_resampler = &ssg_resampler::resample_2_9;		set_clock_pattern(2, 5, 4);			break;
+		case 1*10 + 6:	/* 1:6 */	m_resampler = &ssg_resampler::resample_1_n<6>;	set_clock_pattern(1, 6);			break;
+		case 0*10 + 0:	/* 0:0 */	m_resampler = &ssg_resampler::resample_nop;		set_clock_pattern(1, 0);			break;
 		default: assert(false); break;
 	}
 }
 
 
+//-------------------------------------------------
+//  set_clock_pattern - record how many times the
+//  resampler clocks the SSG for each sample index
+//  modulo the period
+//-------------------------------------------------
+
+template<typename OutputType, int FirstOutput, bool MixTo1>
+void ssg_resampler<OutputType, FirstOutput, MixTo1>::set_clock_pattern(uint8_t period, uint8_t clocks0, uint8_t clocks1, uint8_t clocks2, uint8_t clocks3)
+{
+	m_clock_period = period;
+	m_clock_pattern[0] = clocks0;
+	m_clock_pattern[1] = clocks1;
+	m_clock_pattern[2] = clocks2;
+	m_clock_pattern[3] = clocks3;
+}
+
+
+//-------------------------------------------------
+//  skip - advance the sample index while the SSG
+//  is idle; the last value stays 0 and only the
+//  SSG counters need to move
+//-------------------------------------------------
+
+template<typename OutputType, int FirstOutput, bool MixTo1>
+void ssg_resampler<OutputType, FirstOutput, MixTo1>::skip(uint32_t numsamples)
+{
+	uint32_t cycle = 0;
+	for (uint32_t index = 0; index < m_clock_period; index++)
+		cycle += m_clock_pattern[index];
+
+	uint32_t clocks = (numsamples / m_clock_period) * cycle;
+	for (uint32_t samp = 0; samp < numsamples % m_clock_period; samp++)
+		clocks += m_clock_pattern[(m_sampindex + samp) % m_clock_period];
+
+	m_ssg.skip(clocks);
+	m_sampindex += numsamples;
+}
+
+
 //-------------------------------------------------
 //  resample_n_1 - resample SSG output to the
 //  target at a rate of 1 SSG sample to every
@@ -978,6 +1066,8 @@ ym2608::ym2608(ymfm_interface &intf) :
 	m_address(0),
 	m_irq_enable(0x1f),
 	m_flag_control(0x1c),
+	m_fm_chanmask(fm_engine::ALL_CHANNELS),
+	m_channel_outputs(nullptr),
 	m_fm(intf),
 	m_ssg(intf),
 	m_ssg_resampler(m_ssg),
@@ -990,6 +1080,8 @@ ym2608::ym2608(ymfm_interface &intf) :
 	_RhythmVolume(65536)
 {
 	m_last_fm.clear();
+	m_last_adpcm.clear();
+	m_last_rhythm.clear();
 	update_prescale(m_fm.clock_prescale());
 }
 
@@ -998,6 +1090,17 @@ ym2608::ym2608(ymfm_interface &intf) :
 //  reset - reset the system
 //-------------------------------------------------
 
+// ADPCM percussion sounds; these are present in an embedded ROM
+static uint16_t const s_rhythm_range[6][2] =
+{
+	{ 0x0000, 0x01bf }, // bass drum
+	{ 0x01c0, 0x043f }, // snare drum
+	{ 0x0440, 0x1b7f }, // top cymbal
+	{ 0x1b80, 0x1cff }, // high hat
+	{ 0x1d00, 0x1f7f }, // tom tom
+	{ 0x1f80, 0x1fff }, // rim shot
+};
+
 void ym2608::reset()
 {
 	// reset the engines
@@ -1006,13 +1109,9 @@ void ym2608::reset()
 	m_adpcm_a.reset();
 	m_adpcm_b.reset();
 
-	// configure ADPCM percussion sounds; these are present in an embedded ROM
-	m_adpcm_a.set_start_end(0, 0x0000, 0x01bf); // bass drum
-	m_adpcm_a.set_start_end(1, 0x01c0, 0x043f); // snare drum
-	m_adpcm_a.set_start_end(2, 0x0440, 0x1b7f); // top cymbal
-	m_adpcm_a.set_start_end(3, 0x1b80, 0x1cff); // high hat
-	m_adpcm_a.set_start_end(4, 0x1d00, 0x1f7f); // tom tom
-	m_adpcm_a.set_start_end(5, 0x1f80, 0x1fff); // rim shot
+	// configure ADPCM percussion sounds
+	for (uint8_t chnum = 0; chnum < 6; chnum++)
+		m_adpcm_a.set_start_end(chnum, s_rhythm_range[chnum][0], s_rhythm_range[chnum][1]);
 
 	// initialize our special interrupt states, then read the upper status
 	// register, which updates the IRQs
@@ -1022,6 +1121,28 @@ void ym2608::reset()
 }
 
 
+//-------------------------------------------------
+//  decode_rhythm - decode one percussion sound
+//  from the ADPCM ROM into 16-bit PCM
+//-------------------------------------------------
+
+void ym2608::decode_rhythm(uint8_t const *rom, uint32_t size, uint32_t chnum, std::vector<int16_t> &pcm)
+{
+	adpcm_a_engine::decode(rom, size, s_rhythm_range[chnum][0], s_rhythm_range[chnum][1], 0, pcm);
+}
+
+
+//-------------------------------------------------
+//  set_rhythm_pcm - attach pre-decoded PCM data
+//  for one percussion sound
+//-------------------------------------------------
+
+void ym2608::set_rhythm_pcm(uint32_t chnum, int16_t const *pcm, uint32_t length)
+{
+	m_adpcm_a.set_pcm(uint8_t(chnum), s_rhythm_range[chnum][0], s_rhythm_range[chnum][1], pcm, length);
+}
+
+
 //-------------------------------------------------
 //  save_restore - save or restore the data
 //-------------------------------------------------
@@ -1320,9 +1441,29 @@ void ym2608::generate(output_data *output, uint32_t numsamples)
 			output->data[1] = m_last_fm.data[1];
 			if (step == 1)
 			{
+				// keep the channel outputs of the first clock so they can be
+				// averaged like the mix
+				channel_output_data first;
+				if (m_channel_outputs != nullptr)
+					first = *m_channel_outputs;
+
 				clock_fm_and_adpcm();
 				output->data[0] = (output->data[0] + m_last_fm.data[0]) / 2;
 				output->data[1] = (output->data[1] + m_last_fm.data[1]) / 2;
+
+				if (m_channel_outputs != nullptr)
+				{
+					auto average = [](fm_engine::output_data &output, fm_engine::output_data const &first)
+					{
+						for (uint32_t index = 0; index < FM_OUTPUTS; index++)
+							output.data[index] = (first.data[index] + output.data[index]) / 2;
+					};
+
+					for (uint32_t chnum = 0; chnum < fm_engine::CHANNELS; chnum++)
+						average(m_channel_outputs->fm[chnum], first.fm[chnum]);
+					average(m_channel_outputs->adpcm_a, first.adpcm_a);
+					average(m_channel_outputs->adpcm_b, first.adpcm_b);
+				}
 			}
 		}
 	}
@@ -1331,6 +1472,73 @@ void ym2608::generate(output_data *output, uint32_t numsamples)
 	m_ssg_resampler.resample(output - numsamples, numsamples);
 
 	(output - numsamples)->data[2] = (output - numsamples)->data[2] * _PSGVolume / 65536;
+
+	if (m_channel_outputs != nullptr)
+		for (int32_t &value : m_channel_outputs->ssg.data)
+			value = value * _PSGVolume / 65536;
+}
+
+
+//-------------------------------------------------
+//  idle - return true if the chip outputs silence
+//  until the next register write; the caller may
+//  call skip() instead of generate() while this is
+//  the case
+//-------------------------------------------------
+
+bool ym2608::idle() const
+{
+	// the FM output holds its last value until the next FM clock
+	return m_fm.idle(m_fm_chanmask) && m_last_fm.data[0] == 0 && m_last_fm.data[1] == 0 && m_adpcm_a.idle() && m_adpcm_b.idle() && m_ssg.idle() && m_ssg_resampler.idle();
+}
+
+
+//-------------------------------------------------
+//  skip - advance an idle chip by a number of
+//  samples; ADPCM clocks are no-ops while idle
+//-------------------------------------------------
+
+void ym2608::skip(uint32_t numsamples)
+{
+	// count the sample indices generate() would clock the FM engine on
+	auto count = [start = uint64_t(m_ssg_resampler.sampindex()), numsamples](uint32_t modulo, uint32_t remainder)
+	{
+		auto below = [=](uint64_t end) { return (end + modulo - 1 - remainder) / modulo; };
+		return uint32_t(below(start + numsamples) - below(start));
+	};
+
+	uint32_t clocks = (m_fm_samples_per_output != 0) ? count(m_fm_samples_per_output, 0) : numsamples - count(3, 2);
+
+	m_fm.skip(clocks, m_fm_chanmask);
+	m_ssg_resampler.skip(numsamples);
+}
+
+
+//-------------------------------------------------
+//  set_channel_mask - set the masks of FM and SSG
+//  channels to compute
+//-------------------------------------------------
+
+void ym2608::set_channel_mask(uint32_t fmmask, uint32_t ssgmask)
+{
+	// unmasked channels need to be prepared again before they are clocked
+	if (fmmask != m_fm_chanmask)
+		m_fm.invalidate_caches();
+
+	m_fm_chanmask = fmmask & fm_engine::ALL_CHANNELS;
+	m_ssg.set_channel_mask(ssgmask);
+}
+
+
+//-------------------------------------------------
+//  set_channel_outputs - set the structure that
+//  receives the channel outputs of each sample
+//-------------------------------------------------
+
+void ym2608::set_channel_outputs(channel_output_data *outputs)
+{
+	m_channel_outputs = outputs;
+	m_ssg_resampler.set_channel_outputs((outputs != nullptr) ? &outputs->ssg : nullptr);
 }
 
 
@@ -1399,10 +1607,10 @@ void ym2608::update_prescale(uint8_t prescale)
 void ym2608::clock_fm_and_adpcm()
 {
 	// top bit of the IRQ enable flags controls 3-channel vs 6-channel mode
-	uint32_t fmmask = bitfield(m_irq_enable, 7) ? 0x3f : 0x07;
+	uint32_t fmmask = (bitfield(m_irq_enable, 7) ? 0x3f : 0x07) & m_fm_chanmask;
 
-	// clock the system
-	uint32_t env_counter = m_fm.clock(fm_engine::ALL_CHANNELS);
+	// clock the system; masked channels are left alone
+	uint32_t env_counter = m_fm.clock(m_fm_chanmask);
 
 	// clock the ADPCM-A engine on every envelope cycle
 	// (channels 4 and 5 clock every 2 envelope clocks)
@@ -1412,12 +1620,32 @@ void ym2608::clock_fm_and_adpcm()
 	// clock the ADPCM-B engine every cycle
 	m_adpcm_b.clock();
 
-	// update the FM content; OPNA is 13-bit with no intermediate clipping
-	m_fm.output(m_last_fm.clear(), 1, 32767, fmmask);
+	if (m_channel_outputs == nullptr)
+	{
+		// update the FM content; OPNA is 13-bit with no intermediate clipping
+		m_fm.output(m_last_fm.clear(), 1, 32767, fmmask);
 
-	// mix in the ADPCM and clamp
-	m_adpcm_a.output(m_last_fm, 0x3f);
-	m_adpcm_b.output(m_last_fm, 1);
+		// mix in the ADPCM and clamp
+		m_adpcm_a.output(m_last_fm, 0x3f);
+		m_adpcm_b.output(m_last_fm, 1);
+	}
+	else
+	{
+		channel_output_data &outputs = *m_channel_outputs;
+
+		// compute each channel on its own; they add up to the same mix
+		m_fm.output_channels(outputs.fm, 1, 32767, fmmask);
+		m_adpcm_a.output(outputs.adpcm_a.clear(), 0x3f);
+		m_adpcm_b.output(outputs.adpcm_b.clear(), 1);
+
+		m_last_fm.clear();
+		for (uint32_t index = 0; index < FM_OUTPUTS; index++)
+		{
+			for (auto &fm : outputs.fm)
+				m_last_fm.data[index] += fm.data[index];
+			m_last_fm.data[index] += outputs.adpcm_a.data[index] + outputs.adpcm_b.data[index];
+		}
+	}
 
     {
         m_last_fm.data[0]  = m_last_fm    .data[0] * _FMVolume     / (65536 / 2);
@@ -1430,6 +1658,22 @@ void ym2608::clock_fm_and_adpcm()
 	}
 
 	m_last_fm.clamp16();
+
+	// scale the channel outputs like the mix
+	if (m_channel_outputs != nullptr)
+	{
+		auto scale = [this](fm_engine::output_data &output)
+		{
+			for (uint32_t index = 0; index < FM_OUTPUTS; index++)
+				output.data[index] = output.data[index] * _FMVolume / (65536 / 2);
+			output.clamp16();
+		};
+
+		for (auto &fm : m_channel_outputs->fm)
+			scale(fm);
+		scale(m_channel_outputs->adpcm_a);
+		scale(m_channel_outputs->adpcm_b);
+	}
 }
 
 
@@ -171,6 +171,9 @@ public:
 	// clock the noise and LFO, if present, returning LFO PM value
 	int32_t clock_noise_and_lfo();
 
+	// advance the noise and LFO by a number of clocks at once
+	void skip_noise_and_lfo(uint32_t clocks);
+
 	// reset the LFO
 	void reset_lfo() { m_lfo_counter = 0; }
 
@@ -364,6 +367,13 @@ public:
 	// get the current sample index
 	uint32_t sampindex() const { return m_sampindex; }
 
+	// return true if the last SSG sample was silent
+	bool idle() const { return m_last.data[0] == 0 && m_last.data[1] == 0 && m_last.data[2] == 0; }
+
+	// also write the resampled channels of each sample to the given output,
+	// or stop if null
+	void set_channel_outputs(ssg_engine::output_data *outputs) { m_channel_outputs = outputs; }
+
 	// configure the ratio
 	void configure(uint8_t outsamples, uint8_t srcsamples);
 
@@ -373,6 +383,10 @@ public:
 		(this->*m_resampler)(output, numsamples);
 	}
 
+	// advance the sample index while the SSG is idle, clocking it as often as
+	// resample() would
+	void skip(uint32_t numsamples);
+
 private:
 	// resample SSG output to the target at a rate of 1 SSG sample
 	// to every n output samples
@@ -403,6 +417,9 @@ private:
 	// no-op resampler
 	void resample_nop(OutputType *output, uint32_t numsamples);
 
+	// set the number of SSG clocks of each output sample in a cycle of period samples
+	void set_clock_pattern(uint8_t period, uint8_t clocks0, uint8_t clocks1 = 0, uint8_t clocks2 = 0, uint8_t clocks3 = 0);
+
 	// define a pointer type
 	using resample_func = void (ssg_resampler::*)(OutputType *output, uint32_t numsamples);
 
@@ -411,6 +428,9 @@ private:
 	uint32_t m_sampindex;
 	resample_func m_resampler;
 	ssg_engine::output_data m_last;
+	ssg_engine::output_data *m_channel_outputs;
+	uint8_t m_clock_period;
+	uint8_t m_clock_pattern[4];
 };
 
 
@@ -546,6 +566,36 @@ public:
 	// generate one sample of sound
 	void generate(output_data *output, uint32_t numsamples = 1);
 
+	// return true if the chip outputs silence until the next register write
+	bool idle() const;
+
+	// advance an idle chip by numsamples samples at once, leaving it in the
+	// state generate() would
+	void skip(uint32_t numsamples);
+
+	// set the masks of FM and SSG channels to compute; the others are not
+	// clocked and output 0
+	void set_channel_mask(uint32_t fmmask, uint32_t ssgmask);
+
+	// outputs of the individual channels, scaled like the mixed output
+	struct channel_output_data
+	{
+		fm_engine::output_data fm[fm_engine::CHANNELS]; // FM channels
+		fm_engine::output_data adpcm_a;                 // ADPCM-A (rhythm) channels
+		fm_engine::output_data adpcm_b;                 // ADPCM-B channel
+		ssg_engine::output_data ssg;                    // SSG channels
+	};
+
+	// write the channel outputs of each generated sample to the given
+	// structure, or stop if null
+	void set_channel_outputs(channel_output_data *outputs);
+
+	// decode one percussion sound from the ADPCM ROM into 16-bit PCM
+	static void decode_rhythm(uint8_t const *rom, uint32_t size, uint32_t chnum, std::vector<int16_t> &pcm);
+
+	// play a percussion sound from pre-decoded PCM instead of the ROM
+	void set_rhythm_pcm(uint32_t chnum, int16_t const *pcm, uint32_t length);
+
 	// set volume
 	void SetFMVolume(int32_t vol);
 	void SetPSGVolume(int32_t vol);
@@ -563,6 +613,8 @@ protected:
 	uint8_t m_fm_samples_per_output;    // how many samples to repeat
 	uint8_t m_irq_enable;               // IRQ enable register
 	uint8_t m_flag_control;             // flag control register
+	uint32_t m_fm_chanmask;             // mask of FM channels to compute
+	channel_output_data *m_channel_outputs; // channel outputs, or nullptr
 
 	fm_engine::output_data m_last_fm;       // last FM output
 	fm_engine::output_data m_last_adpcm;    // last adpcm output
@@ -74,6 +74,7 @@ ssg_engine::ssg_engine(ymfm_interface &intf) :
 	m_envelope_state(0),
 	m_noise_count(0),
 	m_noise_state(1),
+	m_chanmask(7),
 	m_override(nullptr)
 {
 }
@@ -135,6 +136,9 @@ void ssg_engine::clock()
 	// programmed period
 	for (int chan = 0; chan < 3; chan++)
 	{
+		if (!bitfield(m_chanmask, chan))
+			continue;
+
 		m_tone_count[chan]++;
 		if (m_tone_count[chan] >= m_regs.ch_tone_period(chan))
 		{
@@ -166,6 +170,57 @@ void ssg_engine::clock()
 }
 
 
+//-------------------------------------------------
+//  skip_counter - advance a counter that clock()
+//  resets to 0 once it reaches the period,
+//  returning the number of resets
+//-------------------------------------------------
+
+static uint32_t skip_counter(uint32_t &count, uint32_t period, uint32_t clocks)
+{
+	uint32_t first = (count + 1 >= period) ? 1 : period - count;
+	if (clocks < first)
+	{
+		count += clocks;
+		return 0;
+	}
+
+	uint32_t rest = clocks - first;
+	period = std::max<uint32_t>(period, 1);
+	count = rest % period;
+	return 1 + rest / period;
+}
+
+
+//-------------------------------------------------
+//  skip - advance by a number of clocks at once
+//-------------------------------------------------
+
+void ssg_engine::skip(uint32_t clocks)
+{
+	if (clocks == 0)
+		return;
+
+	for (int chan = 0; chan < 3; chan++)
+		if (bitfield(m_chanmask, chan))
+			m_tone_state[chan] ^= skip_counter(m_tone_count[chan], m_regs.ch_tone_period(chan), clocks) & 1;
+
+	// the noise counter resets once half of it reaches the period, but never
+	// at 1, which is a period of 2 * noise_period() but at least 2
+	for (uint32_t shifts = skip_counter(m_noise_count, std::max<uint32_t>(m_regs.noise_period() * 2, 2), clocks); shifts != 0; shifts--)
+	{
+		m_noise_state ^= (bitfield(m_noise_state, 0) ^ bitfield(m_noise_state, 3)) << 17;
+		m_noise_state >>= 1;
+	}
+
+	m_envelope_state += skip_counter(m_envelope_count, m_regs.envelope_period(), clocks);
+
+	// output() holds the envelope state at 32
+	if ((m_regs.envelope_hold() | (m_regs.envelope_continue() ^ 1)) && m_envelope_state >= 32)
+		m_envelope_state = 32;
+}
+
+
 //-------------------------------------------------
 //  output - output the current state
 //-------------------------------------------------
@@ -200,6 +255,13 @@ void ssg_engine::output(output_data &output)
 	// iterate over channels
 	for (int chan = 0; chan < 3; chan++)
 	{
+		// masked channels are silent
+		if (!bitfield(m_chanmask, chan))
+		{
+			output.data[chan] = 0;
+			continue;
+		}
+
 		// noise depends on the noise state, which is the LSB of m_noise_state
 		uint32_t noise_on = m_regs.ch_noise_enable_n(chan) | m_noise_state;
 
@@ -230,6 +292,27 @@ void ssg_engine::output(output_data &output)
 }
 
 
+//-------------------------------------------------
+//  idle - return true if all channels output 0
+//  until the next register write
+//-------------------------------------------------
+
+bool ssg_engine::idle() const
+{
+	// we can't see into an override
+	if (m_override != nullptr)
+		return false;
+
+	// a channel is silent only if it has a fixed amplitude of 0; disabling
+	// both tone and noise in the mixer does not silence it, the channel then
+	// outputs its amplitude as a constant level
+	for (int chan = 0; chan < 3; chan++)
+		if (bitfield(m_chanmask, chan) && (m_regs.ch_envelope_enable(chan) || m_regs.ch_amplitude(chan) != 0))
+			return false;
+	return true;
+}
+
+
 //-------------------------------------------------
 //  read - handle reads from the SSG registers
 //-------------------------------------------------
@@ -170,6 +170,10 @@ public:
 	// master clocking function
 	void clock();
 
+	// advance the counters by a number of clocks at once, leaving the engine
+	// in the state the same number of clock() and output() calls would
+	void skip(uint32_t clocks);
+
 	// compute sum of channel outputs
 	void output(output_data &output);
 
@@ -186,6 +190,12 @@ public:
 	// true if we are overridden
 	bool overridden() const { return (m_override != nullptr); }
 
+	// return true if all channels output 0 until the next register write
+	bool idle() const;
+
+	// set the mask of channels to compute; the others are not clocked and output 0
+	void set_channel_mask(uint32_t chanmask) { m_chanmask = chanmask & 7; }
+
 	// indicate the prescale has changed
 	void prescale_changed() { if (m_override != nullptr) m_override->ssg_prescale_changed(); }
 
@@ -198,6 +208,7 @@ private:
 	uint32_t m_envelope_state;              // envelope state
 	uint32_t m_noise_count;                 // current noise counter
 	uint32_t m_noise_state;                 // current noise state
+	uint32_t m_chanmask;                    // mask of channels to compute
 	ssg_registers m_regs;                   // registers
 	ssg_override *m_override;               // override interface
 };
@@ -1,5 +1,5 @@
 
-/** $VER: PMDDecoder.cpp (2026.01.08) P. Stuer **/
+/** $VER: PMDDecoder.cpp (2026.10.19) P. Stuer **/
 
 #include "pch.h"
 
@@ -39,13 +39,24 @@ pmd_decoder_t::~pmd_decoder_t()
 }
 
 /// <summary>
-/// Reads the PMD data from memory.
+/// Reads the PMD data from memory. The song index selects the song of a song bundle.
 /// </summary>
-bool pmd_decoder_t::Open(const uint8_t * data, size_t size, uint32_t sampleRate, const char * filePath, const char * directoryPathDrums)
+bool pmd_decoder_t::Open(const uint8_t * data, size_t size, size_t songIndex, uint32_t sampleRate, const char * filePath, const char * directoryPathDrums)
 {
     _FilePath = filePath;
 
-    if (!IsPMD(data, size))
+    const uint8_t * SongData = data;
+    size_t SongSize = size;
+
+    if (bundle_t::IsBundle(data, size))
+    {
+        bundle_t Bundle;
+
+        if (!Bundle.Open(data, size, songIndex) || !Bundle.GetSong(SongData, SongSize))
+            return false;
+    }
+
+    if (!IsPMD(SongData, SongSize))
         return false;
 
     {
@@ -103,28 +114,36 @@ bool pmd_decoder_t::Open(const uint8_t * data, size_t size, uint32_t sampleRate,
             }
         }
 
-        if (_PMD->Load(_Data, _Size) != ERR_SUCCESS)
+        if (_PMD->Load(_Data, _Size, songIndex) != ERR_SUCCESS)
             return false;
 
         if (!_PMD->GetLength(_Length, _LoopLength, _TickCount, _LoopTickCount))
+        {
+            if (_PMD->GetErrorCode() == ERR_COMMAND_LIMIT)
+                console::printf(STR_COMPONENT_BASENAME ": Song aborted: more than %u commands were executed in a single tick.", pmd_driver_t::MaxCommandsPerTick);
+            else
+            if (_PMD->GetErrorCode() == ERR_SIMULATION_LIMIT)
+                console::printf(STR_COMPONENT_BASENAME ": Song aborted: more than %llu commands were executed while determining its length (peak %u commands per tick).", pmd_driver_t::MaxCommandsPerSong, _PMD->GetPeakCommandCount());
+
             return false;
+        }
 
         {
             char Memo[1024] = { 0 };
 
-            _PMD->GetMemo(data, size, 1, Memo, _countof(Memo));
+            _PMD->GetMemo(SongData, SongSize, 1, Memo, _countof(Memo));
             ConvertShiftJISToUTF8(Memo, _Title);
 
             Memo[0] = '\0';
-            _PMD->GetMemo(data, size, 2, Memo, _countof(Memo));
+            _PMD->GetMemo(SongData, SongSize, 2, Memo, _countof(Memo));
             ConvertShiftJISToUTF8(Memo, _Composer);
 
             Memo[0] = '\0';
-            _PMD->GetMemo(data, size, 3, Memo, _countof(Memo));
+            _PMD->GetMemo(SongData, SongSize, 3, Memo, _countof(Memo));
             ConvertShiftJISToUTF8(Memo, _Arranger);
 
             Memo[0] = '\0';
-            _PMD->GetMemo(data, size, 4, Memo, _countof(Memo));
+            _PMD->GetMemo(SongData, SongSize, 4, Memo, _countof(Memo));
             ConvertShiftJISToUTF8(Memo, _Memo);
         }
 
@@ -18,7 +18,7 @@ public:
     pmd_decoder_t();
     ~pmd_decoder_t();
 
-    bool Open(const uint8_t * data, size_t size, uint32_t sampleRate, const char * filePath, const char * pdxSamplesPath);
+    bool Open(const uint8_t * data, size_t size, size_t songIndex, uint32_t sampleRate, const char * filePath, const char * pdxSamplesPath);
 
     void Initialize() noexcept;
     size_t Render(audio_chunk & audioChunk, size_t sampleCount) noexcept;
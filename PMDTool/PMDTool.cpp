@@ -0,0 +1,1283 @@
+
+/** $VER: PMDTool.cpp (2026.10.19) P. Stuer - Command line tool for PMD songs **/
+
+#include <pch.h>
+
+#include "PMD.h"
+#include "VoiceMixer.h"
+#include "ymfm_fm_soa.h"
+
+#pragma hdrstop
+
+static int Pack(int argc, WCHAR * argv[]);
+static int Bench(int argc, WCHAR * argv[]);
+static int Stems(int argc, WCHAR * argv[]);
+static int Check(int argc, WCHAR * argv[]);
+static int VGM(int argc, WCHAR * argv[]);
+static int Events(int argc, WCHAR * argv[]);
+
+static void Usage();
+
+static bool AddSong(const std::wstring & rootPath, const std::wstring & filePath, const std::vector<uint8_t> & data, size_t songIndex, const WCHAR * drumsPath, std::vector<bundle_file_t> & songs, std::vector<bundle_file_t> & banks);
+static void FindSongs(const std::wstring & rootPath, const std::wstring & directoryPath, std::vector<std::wstring> & filePaths);
+
+static pmd_driver_t * CreateDriver(const WCHAR * songPath, const WCHAR * drumsPath);
+static bool ReadAllBytes(const WCHAR * filePath, std::vector<uint8_t> & data);
+static bool WriteAllBytes(const WCHAR * filePath, const std::vector<uint8_t> & data);
+static bool WriteWAVHeader(HANDLE hFile, uint32_t sampleRate, uint32_t dataSize);
+static std::wstring GetFileName(const WCHAR * filePath);
+static std::wstring GetDirectoryPath(const WCHAR * filePath);
+
+/// <summary>
+/// Describes a command of the tool.
+/// </summary>
+struct command_t
+{
+    const WCHAR * Name;
+    const WCHAR * Arguments;
+    const WCHAR * Description;
+    int (* Handler)(int argc, WCHAR * argv[]);
+};
+
+static const command_t Commands[] =
+{
+    { L"pack", L"<directory, song or bundle> [bundle] [drums directory]", L"Packs the songs of a directory tree, a song or the songs of a bundle and the sample banks they reference into a song bundle (.pmdb). The files keep their paths relative to the directory. Sample banks are stored once.", Pack },
+    { L"bench", L"<song> [seconds] [sample rate] [FM backend]", L"Measures the time it takes to determine the length of a song, to render it and to seek in it. Prints a checksum of the rendered samples. The FM backend (ymfm, scalar, sse41 or avx2) defaults to the fastest one the CPU supports.", Bench },
+    { L"stems", L"<song> [seconds] [directory]", L"Renders each sound source of a song to its own WAV file (song.FM1.wav, song.SSG1.wav, ...). Sources that stay silent are not written. The length defaults to the length of the song.", Stems },
+    { L"check", L"", L"Loads a set of built-in songs that exercise edge cases of the driver, determines their length or collects their events, and verifies the outcome. Compares the voice mixer with the original mixing loops.", Check },
+    { L"vgm", L"<song> [VGM file]", L"Compiles the register log of a song and writes it to a VGM file. The file name defaults to the name of the song with a .vgm extension.", VGM },
+    { L"events", L"<song> [events file] [loops]", L"Collects the musical events of a song without synthesizing audio until it has looped the specified number of times (default 1), and writes them as 12-byte event_t records. The file name defaults to the name of the song with an .events extension.", Events },
+};
+
+/// <summary>
+/// Entry point of the tool.
+/// </summary>
+int wmain(int argc, WCHAR * argv[])
+{
+    if (argc < 2)
+    {
+        Usage();
+
+        return 1;
+    }
+
+    for (const auto & Command : Commands)
+    {
+        if (::_wcsicmp(argv[1], Command.Name) == 0)
+            return Command.Handler(argc - 2, argv + 2);
+    }
+
+    Usage();
+
+    return 1;
+}
+
+/// <summary>
+/// Packs the songs of a directory tree, a song or the songs of a song bundle together with the sample banks they reference into a song bundle.
+/// </summary>
+static int Pack(int argc, WCHAR * argv[])
+{
+    if (argc < 1)
+    {
+        Usage();
+
+        return 1;
+    }
+
+    std::wstring SourcePath = argv[0];
+
+    std::replace(SourcePath.begin(), SourcePath.end(), L'/', L'\\');
+
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+
+    if (!::GetFileAttributesExW(SourcePath.c_str(), GetFileExInfoStandard, &fad))
+    {
+        ::fwprintf(stderr, L"Unable to find \"%s\".\n", SourcePath.c_str());
+
+        return 1;
+    }
+
+    const bool IsDirectory = (fad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+
+    while (IsDirectory && (SourcePath.size() > 1) && (SourcePath.back() == L'\\'))
+        SourcePath.pop_back();
+
+    // The paths in the bundle are relative to the root directory, which includes its trailing separator.
+    const std::wstring RootPath = IsDirectory ? SourcePath + L"\\" : GetDirectoryPath(SourcePath.c_str());
+
+    std::wstring BundlePath;
+
+    if (argc > 1)
+        BundlePath = argv[1];
+    else
+    if (IsDirectory)
+        BundlePath = SourcePath + L".pmdb";
+    else
+    {
+        WCHAR FilePath[MAX_PATH];
+
+        if ((::wcscpy_s(FilePath, _countof(FilePath), SourcePath.c_str()) != 0) || !RenameExtension(FilePath, _countof(FilePath), L".pmdb"))
+            return 1;
+
+        BundlePath = FilePath;
+    }
+
+    if (::_wcsicmp(BundlePath.c_str(), SourcePath.c_str()) == 0)
+    {
+        ::fwprintf(stderr, L"Specify a bundle path that differs from \"%s\".\n", SourcePath.c_str());
+
+        return 1;
+    }
+
+    std::vector<std::wstring> FilePaths;
+
+    if (IsDirectory)
+    {
+        FindSongs(RootPath, L"", FilePaths);
+
+        std::sort(FilePaths.begin(), FilePaths.end(), [](const std::wstring & a, const std::wstring & b) { return ::_wcsicmp(a.c_str(), b.c_str()) < 0; });
+    }
+    else
+        FilePaths.push_back(GetFileName(SourcePath.c_str()));
+
+    const WCHAR * DrumsPath = (argc > 2) ? argv[2] : L"";
+
+    std::vector<bundle_file_t> Songs;
+    std::vector<bundle_file_t> Banks;
+
+    for (const auto & FilePath : FilePaths)
+    {
+        std::vector<uint8_t> Data;
+
+        if (!ReadAllBytes((RootPath + FilePath).c_str(), Data))
+        {
+            ::fwprintf(stderr, L"Unable to read \"%s\".\n", (RootPath + FilePath).c_str());
+
+            return 1;
+        }
+
+        if (bundle_t::IsBundle(Data.data(), Data.size()))
+        {
+            bundle_t Bundle;
+
+            if (!Bundle.Open(Data.data(), Data.size()))
+            {
+                ::fwprintf(stderr, L"\"%s\" is not a valid song bundle.\n", (RootPath + FilePath).c_str());
+
+                return 1;
+            }
+
+            for (size_t i = 0; i < Bundle.GetSongCount(); ++i)
+            {
+                if (!AddSong(RootPath, FilePath, Data, i, DrumsPath, Songs, Banks))
+                    return 1;
+            }
+        }
+        else
+        if (pmd_driver_t::IsPMD(Data.data(), Data.size()))
+        {
+            if (!AddSong(RootPath, FilePath, Data, 0, DrumsPath, Songs, Banks))
+                return 1;
+        }
+        else
+        if (IsDirectory)
+            ::fwprintf(stderr, L"Warning: \"%s\" is not a PMD song.\n", (RootPath + FilePath).c_str());
+        else
+        {
+            ::fwprintf(stderr, L"\"%s\" is not a PMD song.\n", (RootPath + FilePath).c_str());
+
+            return 1;
+        }
+    }
+
+    if (Songs.empty())
+    {
+        ::fwprintf(stderr, L"No songs found in \"%s\".\n", SourcePath.c_str());
+
+        return 1;
+    }
+
+    std::vector<uint8_t> Bundle;
+
+    if (!bundle_t::Create(Songs, Banks, Bundle) || !WriteAllBytes(BundlePath.c_str(), Bundle))
+    {
+        ::fwprintf(stderr, L"Unable to create \"%s\".\n", BundlePath.c_str());
+
+        return 1;
+    }
+
+    ::wprintf(L"Created \"%s\" with %zu songs and %zu sample banks (%zu bytes).\n", BundlePath.c_str(), Songs.size(), Banks.size(), Bundle.size());
+
+    return 0;
+}
+
+/// <summary>
+/// Adds a song and the sample banks it references to the files of a bundle. The song is a song file or a song of a song bundle, with a path relative to the root directory.
+/// Banks that another song already added are shared. Banks outside the root directory are stored in the root of the bundle.
+/// </summary>
+static bool AddSong(const std::wstring & rootPath, const std::wstring & filePath, const std::vector<uint8_t> & data, size_t songIndex, const WCHAR * drumsPath, std::vector<bundle_file_t> & songs, std::vector<bundle_file_t> & banks)
+{
+    const std::wstring SongPath = rootPath + filePath;
+
+    pmd_driver_t * Driver = CreateDriver(SongPath.c_str(), drumsPath);
+
+    if (Driver == nullptr)
+        return false;
+
+    if (Driver->Load(data.data(), data.size(), songIndex) != ERR_SUCCESS)
+    {
+        ::fwprintf(stderr, L"Unable to load \"%s\".\n", SongPath.c_str());
+
+        delete Driver;
+
+        return false;
+    }
+
+    // The banks of a song from a bundle are read from that bundle. Their paths in the bundle are relative to the directory of the bundle.
+    const std::wstring DirectoryPath = GetDirectoryPath(filePath.c_str());
+
+    bundle_t Bundle;
+    File f;
+
+    const bool IsBundle = Bundle.Open(data.data(), data.size(), songIndex);
+
+    if (IsBundle)
+        f.Mount(&Bundle);
+
+    {
+        bundle_file_t Song = { IsBundle ? DirectoryPath + Bundle.GetSongName() : filePath, { } };
+
+        if (IsBundle)
+        {
+            const uint8_t * SongData;
+            size_t SongSize;
+
+            Bundle.GetSong(SongData, SongSize);
+
+            Song.Data.assign(SongData, SongData + SongSize);
+        }
+        else
+            Song.Data = data;
+
+        if (std::find_if(songs.begin(), songs.end(), [&Song](const bundle_file_t & song) { return ::_wcsicmp(song.Name.c_str(), Song.Name.c_str()) == 0; }) != songs.end())
+            ::fwprintf(stderr, L"Warning: Song \"%s\" occurs more than once. Keeping the first one.\n", Song.Name.c_str());
+        else
+        {
+            ::wprintf(L"Adding song \"%s\".\n", Song.Name.c_str());
+
+            songs.push_back(std::move(Song));
+        }
+    }
+
+    // Report the sample banks the song references but that could not be found. The bundle is created without them.
+    const std::pair<std::wstring &, std::wstring &> Banks[] =
+    {
+        { Driver->GetPCMFileName(),    Driver->GetPCMFilePath() },
+        { Driver->GetPPSFileName(),    Driver->GetPPSFilePath() },
+        { Driver->GetPPZFileName(0),   Driver->GetPPZFilePath(0) },
+        { Driver->GetPPZFileName(1),   Driver->GetPPZFilePath(1) },
+    };
+
+    bool Success = true;
+
+    for (const auto & [FileName, FilePath] : Banks)
+    {
+        if (FileName.empty())
+            continue;
+
+        if (FilePath.empty())
+        {
+            ::fwprintf(stderr, L"Warning: Sample bank \"%s\" not found.\n", FileName.c_str());
+
+            continue;
+        }
+
+        std::wstring Name;
+
+        const uint8_t * EntryData;
+        size_t EntrySize;
+        const WCHAR * EntryName;
+
+        if (IsBundle && Bundle.Find(FilePath.c_str(), EntryData, EntrySize, &EntryName) && (::_wcsicmp(EntryName, FilePath.c_str()) == 0))
+            Name = DirectoryPath + EntryName;
+        else
+        if ((FilePath.size() > rootPath.size()) && (::_wcsnicmp(FilePath.c_str(), rootPath.c_str(), rootPath.size()) == 0))
+            Name = FilePath.substr(rootPath.size());
+        else
+            Name = GetFileName(FilePath.c_str());
+
+        std::replace(Name.begin(), Name.end(), L'/', L'\\');
+
+        bundle_file_t Bank = { Name, { } };
+
+        const int64_t Size = f.GetFileSize(FilePath.c_str());
+
+        if ((Size < 0) || (Size > 0x7FFFFFFF) || !f.Open(FilePath.c_str()))
+        {
+            ::fwprintf(stderr, L"Unable to read \"%s\".\n", FilePath.c_str());
+
+            Success = false;
+            break;
+        }
+
+        Bank.Data.resize((size_t) Size);
+
+        const int32_t BytesRead = f.Read(Bank.Data.data(), (uint32_t) Size);
+
+        f.Close();
+
+        if (BytesRead != (int32_t) Size)
+        {
+            ::fwprintf(stderr, L"Unable to read \"%s\".\n", FilePath.c_str());
+
+            Success = false;
+            break;
+        }
+
+        const auto Item = std::find_if(banks.begin(), banks.end(), [&Name](const bundle_file_t & bank) { return ::_wcsicmp(bank.Name.c_str(), Name.c_str()) == 0; });
+
+        if (Item == banks.end())
+        {
+            ::wprintf(L"Adding sample bank \"%s\".\n", Name.c_str());
+
+            banks.push_back(std::move(Bank));
+        }
+        else
+        if (Item->Data != Bank.Data)
+            ::fwprintf(stderr, L"Warning: \"%s\" differs from the sample bank \"%s\" that was added before. Keeping the first one.\n", FilePath.c_str(), Name.c_str());
+    }
+
+    delete Driver;
+
+    return Success;
+}
+
+/// <summary>
+/// Collects the songs and song bundles in a directory tree. The paths are relative to the root directory.
+/// </summary>
+static void FindSongs(const std::wstring & rootPath, const std::wstring & directoryPath, std::vector<std::wstring> & filePaths)
+{
+    WCHAR Pattern[MAX_PATH];
+
+    if (!CombinePath(Pattern, _countof(Pattern), (rootPath + directoryPath).c_str(), L"*"))
+        return;
+
+    WIN32_FIND_DATAW fd;
+
+    HANDLE Handle = ::FindFirstFileExW(Pattern, FindExInfoBasic, &fd, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+
+    if (Handle == INVALID_HANDLE_VALUE)
+        return;
+
+    do
+    {
+        if ((::wcscmp(fd.cFileName, L".") == 0) || (::wcscmp(fd.cFileName, L"..") == 0))
+            continue;
+
+        const std::wstring FilePath = directoryPath + fd.cFileName;
+
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            FindSongs(rootPath, FilePath + L"\\", filePaths);
+        else
+        {
+            for (const WCHAR * Extension : { L".m", L".m2", L".mz", L".pmdb" })
+            {
+                if (HasExtension(fd.cFileName, _countof(fd.cFileName), Extension))
+                {
+                    filePaths.push_back(FilePath);
+                    break;
+                }
+            }
+        }
+    }
+    while (::FindNextFileW(Handle, &fd));
+
+    ::FindClose(Handle);
+}
+
+/// <summary>
+/// Measures the time it takes to determine the length of a song and to render it.
+/// </summary>
+static int Bench(int argc, WCHAR * argv[])
+{
+    if (argc < 1)
+    {
+        Usage();
+
+        return 1;
+    }
+
+    const WCHAR * SongPath = argv[0];
+
+    const uint32_t Seconds    = (argc > 1) ? (uint32_t) ::_wtoi(argv[1]) : 60;
+    const uint32_t SampleRate = (argc > 2) ? (uint32_t) ::_wtoi(argv[2]) : 44100;
+
+    if (argc > 3)
+    {
+        char Name[16] = { };
+
+        for (size_t i = 0; (i < _countof(Name) - 1) && (argv[3][i] != L'\0'); ++i)
+            Name[i] = (char) argv[3][i];
+
+        const ymfm::fm_operator_backend * Backend = ymfm::fm_find_backend(Name);
+
+        if (Backend == nullptr)
+        {
+            ::fwprintf(stderr, L"FM backend \"%s\" is unknown or not supported by this CPU.\n", argv[3]);
+
+            return 1;
+        }
+
+        ymfm::fm_set_default_backend(*Backend);
+    }
+
+    std::vector<uint8_t> Song;
+
+    if (!ReadAllBytes(SongPath, Song))
+    {
+        ::fwprintf(stderr, L"Unable to read \"%s\".\n", SongPath);
+
+        return 1;
+    }
+
+    pmd_driver_t * Driver = CreateDriver(SongPath, L"");
+
+    if (Driver == nullptr)
+        return 1;
+
+    Driver->SetSampleRate(SampleRate);
+
+    if (Driver->Load(Song.data(), Song.size()) != ERR_SUCCESS)
+    {
+        ::fwprintf(stderr, L"Unable to load \"%s\".\n", SongPath);
+
+        delete Driver;
+
+        return 1;
+    }
+
+    ::wprintf(L"FM backend: %S\n", ymfm::fm_default_backend().name);
+
+    // Determine the length of the song.
+    {
+        const int RunCount = 10;
+
+        uint32_t SongLength = 0, LoopLength = 0, SongTicks = 0, LoopTicks = 0;
+
+        bool Success = true;
+
+        const auto Start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < RunCount; ++i)
+            Success = Driver->GetLength(SongLength, LoopLength, SongTicks, LoopTicks);
+
+        const std::chrono::duration<double, std::milli> Duration = std::chrono::steady_clock::now() - Start;
+
+        if (Success)
+            ::wprintf(L"Length: %u ms, loop %u ms, %u ticks, loop %u ticks, %llu commands\n", SongLength, LoopLength, SongTicks, LoopTicks, (unsigned long long) Driver->GetTotalCommandCount());
+        else
+            ::wprintf(L"Length: aborted with error %d\n", Driver->GetErrorCode());
+
+        ::wprintf(L"GetLength: %.3f ms per call\n", Duration.count() / RunCount);
+    }
+
+    // Render the song.
+    {
+        const size_t BlockSize = 512;
+
+        std::vector<int16_t> Frames(BlockSize * 2);
+
+        const size_t FrameCount = (size_t) Seconds * SampleRate;
+
+        uint64_t Checksum = 0xCBF29CE484222325; // FNV-1a
+
+        Driver->Start();
+
+        std::chrono::duration<double, std::milli> Duration(0.);
+
+        for (size_t i = 0; i < FrameCount; i += BlockSize)
+        {
+            const size_t Count = std::min(BlockSize, FrameCount - i);
+
+            const auto Start = std::chrono::steady_clock::now();
+
+            Driver->Render(Frames.data(), Count);
+
+            Duration += std::chrono::steady_clock::now() - Start;
+
+            for (size_t j = 0; j < Count * 2; ++j)
+                Checksum = (Checksum ^ (uint16_t) Frames[j]) * 0x100000001B3;
+        }
+
+        Driver->Stop();
+
+        ::wprintf(L"Render: %.1f ms for %u s at %u Hz, %.1f ns per frame, %.0fx real time\n", Duration.count(), Seconds, SampleRate, Duration.count() * 1e6 / (double) FrameCount, (Seconds * 1000.) / Duration.count());
+        ::wprintf(L"Checksum: %016llX\n", (unsigned long long) Checksum);
+    }
+
+    // Seek forward from the start of the song and back again. This happens after rendering because a seek leaves the chip in a different state than a start.
+    {
+        const uint32_t Position = Seconds * 1000 / 2;
+
+        Driver->Start();
+
+        auto Start = std::chrono::steady_clock::now();
+
+        Driver->SetPosition(Position);
+
+        const std::chrono::duration<double, std::milli> Forward = std::chrono::steady_clock::now() - Start;
+
+        Start = std::chrono::steady_clock::now();
+
+        Driver->SetPosition(0);
+
+        const std::chrono::duration<double, std::milli> Backward = std::chrono::steady_clock::now() - Start;
+
+        Driver->Stop();
+
+        ::wprintf(L"SetPosition: %.3f ms to %u ms, %.3f ms back to the start\n", Forward.count(), Position, Backward.count());
+    }
+
+    delete Driver;
+
+    return 0;
+}
+
+/// <summary>
+/// Renders each sound source of a song to its own WAV file.
+/// </summary>
+static int Stems(int argc, WCHAR * argv[])
+{
+    if (argc < 1)
+    {
+        Usage();
+
+        return 1;
+    }
+
+    static const WCHAR * const StemNames[StemCount] =
+    {
+        L"FM1", L"FM2", L"FM3", L"FM4", L"FM5", L"FM6",
+        L"SSG1", L"SSG2", L"SSG3",
+        L"ADPCM",
+        L"Rhythm",
+        L"PPZ1", L"PPZ2", L"PPZ3", L"PPZ4", L"PPZ5", L"PPZ6", L"PPZ7", L"PPZ8",
+        L"PPS",
+    };
+
+    const WCHAR * SongPath = argv[0];
+
+    const uint32_t SampleRate = 44100;
+
+    std::vector<uint8_t> Song;
+
+    if (!ReadAllBytes(SongPath, Song))
+    {
+        ::fwprintf(stderr, L"Unable to read \"%s\".\n", SongPath);
+
+        return 1;
+    }
+
+    pmd_driver_t * Driver = CreateDriver(SongPath, L"");
+
+    if (Driver == nullptr)
+        return 1;
+
+    if (Driver->Load(Song.data(), Song.size()) != ERR_SUCCESS)
+    {
+        ::fwprintf(stderr, L"Unable to load \"%s\".\n", SongPath);
+
+        delete Driver;
+
+        return 1;
+    }
+
+    size_t FrameCount = (size_t) 60 * SampleRate;
+
+    if (argc > 1)
+        FrameCount = (size_t) ::_wtoi(argv[1]) * SampleRate;
+    else
+    {
+        uint32_t SongLength = 0, LoopLength = 0, SongTicks = 0, LoopTicks = 0;
+
+        if (Driver->GetLength(SongLength, LoopLength, SongTicks, LoopTicks) && (SongLength != 0))
+            FrameCount = (size_t) SongLength * SampleRate / 1000;
+    }
+
+    // Name the stem files after the song, without its extension.
+    std::wstring BasePath = (argc > 2) ? std::wstring(argv[2]) : GetDirectoryPath(SongPath);
+
+    if (!BasePath.empty() && (BasePath.back() != L'\\') && (BasePath.back() != L'/'))
+        BasePath += L'\\';
+
+    {
+        const std::wstring FileName = GetFileName(SongPath);
+
+        BasePath += FileName.substr(0, FileName.find_last_of(L'.'));
+    }
+
+    HANDLE Files[StemCount];
+    bool IsAudible[StemCount] = { };
+
+    int Result = 1;
+
+    for (size_t i = 0; i < StemCount; ++i)
+    {
+        Files[i] = ::CreateFileW((BasePath + L"." + StemNames[i] + L".wav").c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if ((Files[i] == INVALID_HANDLE_VALUE) || !WriteWAVHeader(Files[i], SampleRate, 0))
+        {
+            ::fwprintf(stderr, L"Unable to create \"%s.%s.wav\".\n", BasePath.c_str(), StemNames[i]);
+
+            FrameCount = 0;
+        }
+    }
+
+    if (FrameCount != 0)
+    {
+        const size_t BlockSize = 512;
+
+        std::vector<int16_t> Frames(StemCount * BlockSize * 2);
+
+        int16_t * StemData[StemCount];
+
+        for (size_t i = 0; i < StemCount; ++i)
+            StemData[i] = Frames.data() + i * BlockSize * 2;
+
+        Driver->Start();
+
+        Result = 0;
+
+        for (size_t i = 0; (i < FrameCount) && (Result == 0); i += BlockSize)
+        {
+            const size_t Count = std::min(BlockSize, FrameCount - i);
+
+            if (!Driver->RenderStems(StemData, Count))
+            {
+                ::fwprintf(stderr, L"Unable to render the stems.\n");
+
+                Result = 1;
+                continue;
+            }
+
+            for (size_t j = 0; j < StemCount; ++j)
+            {
+                DWORD BytesWritten = 0;
+
+                if (!::WriteFile(Files[j], StemData[j], (DWORD) (Count * 2 * sizeof(int16_t)), &BytesWritten, nullptr) || (BytesWritten != Count * 2 * sizeof(int16_t)))
+                    Result = 1;
+
+                IsAudible[j] = IsAudible[j] || std::any_of(StemData[j], StemData[j] + Count * 2, [](int16_t x) { return x != 0; });
+            }
+        }
+
+        Driver->Stop();
+    }
+
+    // Complete the files of the audible stems and remove the others.
+    for (size_t i = 0; i < StemCount; ++i)
+    {
+        if (Files[i] == INVALID_HANDLE_VALUE)
+            continue;
+
+        const std::wstring FilePath = BasePath + L"." + StemNames[i] + L".wav";
+
+        if ((Result == 0) && IsAudible[i])
+        {
+            ::SetFilePointer(Files[i], 0, nullptr, FILE_BEGIN);
+
+            if (!WriteWAVHeader(Files[i], SampleRate, (uint32_t) (FrameCount * 2 * sizeof(int16_t))))
+                Result = 1;
+
+            ::CloseHandle(Files[i]);
+
+            ::wprintf(L"Created \"%s\".\n", FilePath.c_str());
+        }
+        else
+        {
+            ::CloseHandle(Files[i]);
+            ::DeleteFileW(FilePath.c_str());
+        }
+    }
+
+    if (Result != 0)
+        ::fwprintf(stderr, L"Unable to write the stems of \"%s\".\n", SongPath);
+
+    delete Driver;
+
+    return Result;
+}
+
+/// <summary>
+/// Compiles the register log of a song and writes it to a VGM file.
+/// </summary>
+static int VGM(int argc, WCHAR * argv[])
+{
+    if (argc < 1)
+    {
+        Usage();
+
+        return 1;
+    }
+
+    const WCHAR * SongPath = argv[0];
+
+    std::vector<uint8_t> Song;
+
+    if (!ReadAllBytes(SongPath, Song))
+    {
+        ::fwprintf(stderr, L"Unable to read \"%s\".\n", SongPath);
+
+        return 1;
+    }
+
+    pmd_driver_t * Driver = CreateDriver(SongPath, L"");
+
+    if (Driver == nullptr)
+        return 1;
+
+    if (Driver->Load(Song.data(), Song.size()) != ERR_SUCCESS)
+    {
+        ::fwprintf(stderr, L"Unable to load \"%s\".\n", SongPath);
+
+        delete Driver;
+
+        return 1;
+    }
+
+    register_log_t Log;
+
+    if (!Driver->CompileRegisterLog(Log))
+    {
+        ::fwprintf(stderr, L"Unable to compile the register log of \"%s\" (error %d).\n", SongPath, Driver->GetErrorCode());
+
+        delete Driver;
+
+        return 1;
+    }
+
+    ::wprintf(L"Compile time: %u ms, %zu bytes, %zu register writes, %zu PCM driver calls\n", Log.GetCompileTime(), Log.GetSize(), Log.GetEntries().size(), Log.GetCalls().size());
+
+    if (Log.GetLoopTime() != register_log_t::NoLoop)
+        ::wprintf(L"Duration: %u samples, loop at %u samples\n", Log.GetDuration(), Log.GetLoopTime());
+    else
+        ::wprintf(L"Duration: %u samples, no loop\n", Log.GetDuration());
+
+    // Name the VGM file after the song by default.
+    std::wstring FilePath;
+
+    if (argc > 1)
+        FilePath = argv[1];
+    else
+    {
+        FilePath = SongPath;
+
+        const size_t Index = FilePath.find_last_of(L".\\/");
+
+        if ((Index != std::wstring::npos) && (FilePath[Index] == L'.'))
+            FilePath.resize(Index);
+
+        FilePath += L".vgm";
+    }
+
+    const bool Success = Driver->WriteVGM(Log, FilePath.c_str());
+
+    if (!Success)
+        ::fwprintf(stderr, L"Unable to write \"%s\".\n", FilePath.c_str());
+
+    delete Driver;
+
+    return Success ? 0 : 1;
+}
+
+/// <summary>
+/// Collects the musical events of a song without synthesizing audio and writes them to a file.
+/// </summary>
+static int Events(int argc, WCHAR * argv[])
+{
+    if (argc < 1)
+    {
+        Usage();
+
+        return 1;
+    }
+
+    const WCHAR * SongPath = argv[0];
+
+    const uint32_t LoopCount = (argc > 2) ? (uint32_t) ::_wtoi(argv[2]) : 1;
+
+    std::vector<uint8_t> Song;
+
+    if (!ReadAllBytes(SongPath, Song))
+    {
+        ::fwprintf(stderr, L"Unable to read \"%s\".\n", SongPath);
+
+        return 1;
+    }
+
+    pmd_driver_t * Driver = CreateDriver(SongPath, L"");
+
+    if (Driver == nullptr)
+        return 1;
+
+    if (Driver->Load(Song.data(), Song.size()) != ERR_SUCCESS)
+    {
+        ::fwprintf(stderr, L"Unable to load \"%s\".\n", SongPath);
+
+        delete Driver;
+
+        return 1;
+    }
+
+    std::vector<event_t> Events;
+
+    const auto Start = std::chrono::steady_clock::now();
+
+    const bool Success = Driver->GetEvents(Events, LoopCount);
+
+    const std::chrono::duration<double, std::milli> Duration = std::chrono::steady_clock::now() - Start;
+
+    const int32_t ErrorCode = Driver->GetErrorCode();
+
+    delete Driver;
+
+    if (!Success)
+    {
+        ::fwprintf(stderr, L"Unable to collect the events of \"%s\" (error %d).\n", SongPath, ErrorCode);
+
+        return 1;
+    }
+
+    const uint32_t SongTime = Events.empty() ? 0 : Events.back().Time;
+
+    ::wprintf(L"%zu events, %u ticks, %u ms of music in %.3f ms (%.0fx real time)\n", Events.size(), Events.empty() ? 0 : Events.back().Tick, SongTime, Duration.count(), (Duration.count() > 0.) ? SongTime / Duration.count() : 0.);
+
+    // Name the events file after the song by default.
+    std::wstring FilePath;
+
+    if (argc > 1)
+        FilePath = argv[1];
+    else
+    {
+        FilePath = SongPath;
+
+        const size_t Index = FilePath.find_last_of(L".\\/");
+
+        if ((Index != std::wstring::npos) && (FilePath[Index] == L'.'))
+            FilePath.resize(Index);
+
+        FilePath += L".events";
+    }
+
+    const std::vector<uint8_t> Data((const uint8_t *) Events.data(), (const uint8_t *) (Events.data() + Events.size()));
+
+    if (!WriteAllBytes(FilePath.c_str(), Data))
+    {
+        ::fwprintf(stderr, L"Unable to write \"%s\".\n", FilePath.c_str());
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/// <summary>
+/// Shows the usage of the tool.
+/// </summary>
+static void Usage()
+{
+    ::wprintf(L"Usage: PMDTool <command> [arguments]\n\n");
+
+    for (const auto & Command : Commands)
+        ::wprintf(L"  %s %s\n      %s\n", Command.Name, Command.Arguments, Command.Description);
+}
+
+/// <summary>
+/// Describes a built-in song that exercises an edge case of the driver.
+/// </summary>
+struct fixture_t
+{
+    const WCHAR * Name;
+    std::vector<uint8_t> Data;
+    int32_t ErrorCode;  // Error reported by Load() or GetLength(), ERR_SUCCESS if both are expected to succeed
+};
+
+/// <summary>
+/// Describes an event that a fixture is expected to produce.
+/// </summary>
+struct expected_event_t
+{
+    uint32_t Tick;
+    uint8_t Channel;
+    event_type_t Type;
+    uint16_t Value;
+};
+
+/// <summary>
+/// Builds a song with the standard layout: the offsets of the FM 1-6, SSG 1-3, ADPCM and rhythm parts and of the rhythm pattern table, followed by the data.
+/// The other parts share a single end marker. The offsets of the rhythm patterns are relative to the start of the data.
+/// </summary>
+static std::vector<uint8_t> CreateFixture(const std::vector<uint8_t> & fmPart, const std::vector<uint8_t> & rhythmPart, const std::vector<std::vector<uint8_t>> & patterns)
+{
+    const size_t OffsetCount = 12;
+
+    std::vector<uint8_t> Data(OffsetCount * 2);
+
+    auto SetOffset = [&Data](size_t i, size_t offset)
+    {
+        Data[i * 2]     = (uint8_t) offset;
+        Data[i * 2 + 1] = (uint8_t) (offset >> 8);
+    };
+
+    // The FM 1 part has to follow the offset table.
+    SetOffset(0, Data.size());
+    Data.insert(Data.end(), fmPart.begin(), fmPart.end());
+
+    const size_t EmptyPart = Data.size();
+
+    Data.push_back(0x80);
+
+    for (size_t i = 1; i < 10; ++i)
+        SetOffset(i, EmptyPart);
+
+    SetOffset(10, Data.size());
+    Data.insert(Data.end(), rhythmPart.begin(), rhythmPart.end());
+
+    const size_t PatternTable = Data.size();
+
+    SetOffset(11, PatternTable);
+    Data.resize(PatternTable + patterns.size() * 2);
+
+    for (size_t i = 0; i < patterns.size(); ++i)
+    {
+        Data[PatternTable + i * 2]     = (uint8_t) Data.size();
+        Data[PatternTable + i * 2 + 1] = (uint8_t) (Data.size() >> 8);
+
+        Data.insert(Data.end(), patterns[i].begin(), patterns[i].end());
+    }
+
+    Data.insert(Data.begin(), 0x00); // Version
+
+    return Data;
+}
+
+/// <summary>
+/// Loads a set of built-in songs that exercise edge cases of the driver, determines their length or collects their events, and verifies the outcome. Compares the voice mixer with the original mixing loops.
+/// </summary>
+static int Check(int, WCHAR * [])
+{
+    const fixture_t Fixtures[] =
+    {
+        // L, R0 R0 R0: A rhythm part that loops over references to an empty rhythm pattern never consumes time.
+        { L"Rhythm part referencing empty patterns in a loop", CreateFixture({ 0x80 }, { 0xF6, 0x00, 0x00, 0x00, 0x80 }, { { 0xFF } }), ERR_COMMAND_LIMIT },
+
+        // L, R0: The same loop with a pattern that holds a rest of 24 ticks.
+        { L"Rhythm part referencing a pattern with a rest in a loop", CreateFixture({ 0x80 }, { 0xF6, 0x00, 0x80 }, { { 0x00, 0x18, 0xFF } }), ERR_SUCCESS },
+
+        // L, v100: An FM part that loops over a command without notes never consumes time.
+        { L"FM part looping without notes", CreateFixture({ 0xF6, 0xFD, 0x64, 0x80 }, { 0x80 }, { }), ERR_COMMAND_LIMIT },
+
+        // [ o3c4 ]2: The FM 1 part starts at offset 24. '[' refers to the operands of ']' at offset 30, ']' refers to the operand of '[' at offset 25.
+        { L"FM part with a loop", CreateFixture({ 0xF9, 0x1E, 0x00, 0x30, 0x18, 0xF8, 0x02, 0x00, 0x19, 0x00, 0x80 }, { 0x80 }, { }), ERR_SUCCESS },
+
+        // The same loop with a '[' that refers to the length of the note.
+        { L"FM part with a loop start that refers to a note", CreateFixture({ 0xF9, 0x1C, 0x00, 0x30, 0x18, 0xF8, 0x02, 0x00, 0x19, 0x00, 0x80 }, { 0x80 }, { }), ERR_UNKNOWN_FORMAT },
+
+        // The same loop with a ']' that jumps past the end of the song.
+        { L"FM part with a loop end outside the song", CreateFixture({ 0xF9, 0x1E, 0x00, 0x30, 0x18, 0xF8, 0x02, 0x00, 0x00, 0x10, 0x80 }, { 0x80 }, { }), ERR_UNKNOWN_FORMAT },
+
+        // v without its operand and an end marker: The rhythm part is cut off by the end of the song.
+        { L"Rhythm part cut off by the end of the song", CreateFixture({ 0x80 }, { 0xFD }, { }), ERR_UNKNOWN_FORMAT },
+    };
+
+    int FailureCount = 0;
+
+    for (const auto & Fixture : Fixtures)
+    {
+        pmd_driver_t Driver;
+
+        if (!Driver.Initialize(L""))
+        {
+            ::wprintf(L"FAIL: %s (unable to initialize the driver)\n", Fixture.Name);
+
+            FailureCount++;
+
+            continue;
+        }
+
+        const int32_t Result = Driver.Load(Fixture.Data.data(), Fixture.Data.size());
+
+        if (Result != ERR_SUCCESS)
+        {
+            const bool Passed = (Result == Fixture.ErrorCode);
+
+            ::wprintf(L"%s: %s (load error %d, expected %d)\n", Passed ? L"Pass" : L"FAIL", Fixture.Name, Result, Fixture.ErrorCode);
+
+            if (!Passed)
+                FailureCount++;
+
+            continue;
+        }
+
+        uint32_t SongLength = 0, LoopLength = 0, SongTicks = 0, LoopTicks = 0;
+
+        const bool Success = Driver.GetLength(SongLength, LoopLength, SongTicks, LoopTicks);
+        const bool Passed = (Success == (Fixture.ErrorCode == ERR_SUCCESS)) && (Driver.GetErrorCode() == Fixture.ErrorCode);
+
+        ::wprintf(L"%s: %s (error %d, expected %d)\n", Passed ? L"Pass" : L"FAIL", Fixture.Name, Driver.GetErrorCode(), Fixture.ErrorCode);
+
+        if (!Passed)
+            FailureCount++;
+    }
+
+    // sk1,4 L o3c4 T224 r4: The delayed slot keys the note on a second time without a key off in between. That is not a new note.
+    {
+        const WCHAR * Name = L"Events of an FM part with a slot delay in a loop";
+
+        const std::vector<uint8_t> Data = CreateFixture({ 0xB5, 0x01, 0x04, 0xF6, 0x30, 0x18, 0xFC, 0xE0, 0x0F, 0x18, 0x80 }, { 0x80 }, { });
+
+        const expected_event_t ExpectedEvents[] =
+        {
+            {  0, EventSong, event_type_t::Tempo,       79 },
+            {  0,         0, event_type_t::Instrument,   0 },
+            {  0,         0, event_type_t::Volume,     108 },
+            {  0,         0, event_type_t::KeyOn,     0x30 },
+            { 24,         0, event_type_t::KeyOff,       0 },
+            { 24, EventSong, event_type_t::Tempo,      138 },
+            { 48,         0, event_type_t::KeyOn,     0x30 },
+            { 48, EventSong, event_type_t::Loop,         1 },
+            { 72,         0, event_type_t::KeyOff,       0 },
+            { 72, EventSong, event_type_t::Tempo,      138 },
+            { 96,         0, event_type_t::KeyOn,     0x30 },
+            { 96, EventSong, event_type_t::Loop,         2 },
+        };
+
+        pmd_driver_t Driver;
+
+        std::vector<event_t> Events;
+
+        const bool Success = Driver.Initialize(L"") && (Driver.Load(Data.data(), Data.size()) == ERR_SUCCESS) && Driver.GetEvents(Events, 2);
+
+        bool Passed = Success && (Events.size() == _countof(ExpectedEvents));
+
+        for (size_t i = 0; Passed && (i < Events.size()); ++i)
+        {
+            const auto & e = ExpectedEvents[i];
+
+            Passed = (Events[i].Tick == e.Tick) && (Events[i].Channel == e.Channel) && (Events[i].Type == e.Type) && (Events[i].Value == e.Value);
+        }
+
+        ::wprintf(L"%s: %s (%zu events, expected %zu)\n", Passed ? L"Pass" : L"FAIL", Name, Events.size(), _countof(ExpectedEvents));
+
+        if (!Passed)
+            FailureCount++;
+    }
+
+    // The voice mixer has to produce the same frames as the hand-written loops it replaced, for each pan law and phase. The voice ends part-way through the buffer.
+    {
+        const size_t FrameCount = 1024;
+        const size_t VoiceSize  = 700;
+
+        std::vector<int32_t> Voice(VoiceSize);
+
+        uint32_t Seed = 0x1234567;
+
+        for (auto & Sample : Voice)
+        {
+            Seed = Seed * 1103515245 + 12345;
+
+            Sample = (int32_t) ((Seed >> 8) & 0xFFFF) - 0x8000;
+        }
+
+        std::vector<int32_t> Initial(FrameCount * 2);
+
+        for (auto & Sample : Initial)
+        {
+            Seed = Seed * 1103515245 + 12345;
+
+            Sample = (int32_t) ((Seed >> 8) & 0x1FFFF) - 0x10000;
+        }
+
+        // Mixes the voice the way the hand-written loops did.
+        auto MixReference = [&Voice](int32_t * frames, int panLaw, int32_t panValue, int32_t maskL, int32_t maskR, bool phaseReversed)
+        {
+            for (const int32_t Sample : Voice)
+            {
+                int32_t L = Sample, R = Sample;
+
+                switch (panLaw)
+                {
+                    case 1: R = Sample * panValue / (256 / 2); break;
+                    case 2: L = Sample * panValue / (256 / 2); break;
+                    case 3: L = Sample & maskL; R = Sample & maskR; break;
+                }
+
+                *frames++ += L;
+                *frames++ += phaseReversed ? -R : R;
+            }
+        };
+
+        auto Compare = [&]<bool PhaseReversed>(const WCHAR * name, int panLaw, int32_t panValue, int32_t maskL, int32_t maskR, const auto & pan)
+        {
+            std::vector<int32_t> Expected(Initial);
+            std::vector<int32_t> Actual(Initial);
+
+            MixReference(Expected.data(), panLaw, panValue, maskL, maskR, PhaseReversed);
+
+            size_t i = 0;
+
+            const bool Ended = !voice_mixer::Mix<PhaseReversed>(Actual.data(), FrameCount, pan, [&Voice, &i]() noexcept { return Voice[i]; }, [&Voice, &i]() noexcept { return ++i < Voice.size(); });
+            const bool Passed = Ended && (Actual == Expected);
+
+            ::wprintf(L"%s: Voice mixer, %s%s\n", Passed ? L"Pass" : L"FAIL", name, PhaseReversed ? L", phase reversed" : L"");
+
+            if (!Passed)
+                FailureCount++;
+        };
+
+        auto CompareBoth = [&Compare](const WCHAR * name, int panLaw, int32_t panValue, int32_t maskL, int32_t maskR, const auto & pan)
+        {
+            Compare.template operator()<false>(name, panLaw, panValue, maskL, maskR, pan);
+            Compare.template operator()<true> (name, panLaw, panValue, maskL, maskR, pan);
+        };
+
+        using namespace voice_mixer;
+
+        CompareBoth(L"center",               0,  0,  0,  0, pan_center_t());
+        CompareBoth(L"left",                 1, 37,  0,  0, pan_left_t { 37 });
+        CompareBoth(L"right",                2, 91,  0,  0, pan_right_t { 91 });
+        CompareBoth(L"left channel masked",  3,  0,  0, -1, pan_mask_t { 0, -1 });
+        CompareBoth(L"right channel masked", 3,  0, -1,  0, pan_mask_t { -1, 0 });
+        CompareBoth(L"both channels masked", 3,  0,  0,  0, pan_mask_t { 0, 0 });
+    }
+
+    return (FailureCount == 0) ? 0 : 1;
+}
+
+/// <summary>
+/// Creates a driver that looks for the sample banks of a song in the directory of the song and in the current directory, like the decoder does.
+/// </summary>
+static pmd_driver_t * CreateDriver(const WCHAR * songPath, const WCHAR * drumsPath)
+{
+    pmd_driver_t * Driver = new pmd_driver_t();
+
+    if (!Driver->Initialize(drumsPath))
+    {
+        ::fwprintf(stderr, L"Unable to initialize the driver.\n");
+
+        delete Driver;
+
+        return nullptr;
+    }
+
+    Driver->SetSampleRate(44100);
+
+    const std::wstring DirectoryPath = GetDirectoryPath(songPath);
+
+    std::vector<const WCHAR *> Paths;
+
+    if (!DirectoryPath.empty())
+        Paths.push_back(DirectoryPath.c_str());
+
+    Paths.push_back(L".\\");
+
+    Driver->SetSearchPaths(Paths);
+
+    return Driver;
+}
+
+/// <summary>
+/// Reads a complete file.
+/// </summary>
+static bool ReadAllBytes(const WCHAR * filePath, std::vector<uint8_t> & data)
+{
+    File f;
+
+    const int64_t Size = f.GetFileSize(filePath);
+
+    if ((Size < 0) || (Size > 0x7FFFFFFF) || !f.Open(filePath))
+        return false;
+
+    data.resize((size_t) Size);
+
+    return (f.Read(data.data(), (uint32_t) Size) == (int32_t) Size);
+}
+
+/// <summary>
+/// Writes a complete file.
+/// </summary>
+static bool WriteAllBytes(const WCHAR * filePath, const std::vector<uint8_t> & data)
+{
+    HANDLE hFile = ::CreateFileW(filePath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    DWORD BytesWritten = 0;
+
+    const bool Success = ::WriteFile(hFile, data.data(), (DWORD) data.size(), &BytesWritten, nullptr) && (BytesWritten == data.size());
+
+    ::CloseHandle(hFile);
+
+    return Success;
+}
+
+/// <summary>
+/// Writes the header of a 16-bit stereo PCM WAV file.
+/// </summary>
+static bool WriteWAVHeader(HANDLE hFile, uint32_t sampleRate, uint32_t dataSize)
+{
+    #pragma pack(push, 1)
+    struct
+    {
+        char RIFF[4];
+        uint32_t RIFFSize;
+        char WAVE[4];
+
+        char fmt[4];
+        uint32_t fmtSize;
+        uint16_t FormatTag;
+        uint16_t ChannelCount;
+        uint32_t SampleRate;
+        uint32_t ByteRate;
+        uint16_t BlockAlign;
+        uint16_t BitsPerSample;
+
+        char data[4];
+        uint32_t DataSize;
+    } Header =
+    {
+        { 'R', 'I', 'F', 'F' }, 36 + dataSize, { 'W', 'A', 'V', 'E' },
+        { 'f', 'm', 't', ' ' }, 16, 1 /* WAVE_FORMAT_PCM */, 2, sampleRate, sampleRate * 4, 4, 16,
+        { 'd', 'a', 't', 'a' }, dataSize
+    };
+    #pragma pack(pop)
+
+    DWORD BytesWritten = 0;
+
+    return ::WriteFile(hFile, &Header, sizeof(Header), &BytesWritten, nullptr) && (BytesWritten == sizeof(Header));
+}
+
+/// <summary>
+/// Gets the file name part of a file path.
+/// </summary>
+static std::wstring GetFileName(const WCHAR * filePath)
+{
+    const std::wstring FilePath(filePath);
+
+    const size_t Index = FilePath.find_last_of(L"\\/");
+
+    return (Index != std::wstring::npos) ? FilePath.substr(Index + 1) : FilePath;
+}
+
+/// <summary>
+/// Gets the directory part of a file path, including the trailing separator.
+/// </summary>
+static std::wstring GetDirectoryPath(const WCHAR * filePath)
+{
+    const std::wstring FilePath(filePath);
+
+    const size_t Index = FilePath.find_last_of(L"\\/");
+
+    return (Index != std::wstring::npos) ? FilePath.substr(0, Index + 1) : std::wstring();
+}
@@ -0,0 +1,34 @@
+
+/** $VER: pch.h (2026.10.19) P. Stuer - Precompiled header of the PMD command line tool **/
+
+#pragma once
+
+#include <SDKDDKVer.h>
+
+#define NOMINMAX
+
+#include <windows.h>
+#include <strsafe.h>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#ifndef Assert
+#if defined(DEBUG) || defined(_DEBUG)
+#define Assert(b) do {if (!(b)) { ::OutputDebugStringA("Assert: " #b "\n");}} while(0)
+#else
+#define Assert(b)
+#endif
+#endif
+
+#define TOSTRING_IMPL(x) #x
+#define TOSTRING(x) TOSTRING_IMPL(x)